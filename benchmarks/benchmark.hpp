@@ -0,0 +1,129 @@
+/**
+ * @file benchmark.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Minimal benchmark harness used by the files in benchmarks/
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Bench {
+
+/**
+ * @brief Times the measured region of one benchmark run
+ *
+ * A benchmark does its setup, calls start(), runs the operations being measured, then calls stop()
+ * with how many operations it ran. Extra numbers worth reporting (bytes per order, etc) go in counters.
+ */
+struct Timer {
+    /**
+     * @brief Start timing, anything before this is setup
+     *
+     */
+    void start() { startTime = std::chrono::steady_clock::now(); }
+
+    /**
+     * @brief Stop timing
+     *
+     * @param numOperations Number of operations run since start()
+     */
+    void stop(std::size_t numOperations) {
+        elapsed = std::chrono::steady_clock::now() - startTime;
+        operations = numOperations;
+    }
+
+    /**
+     * @brief Report an extra named number alongside the timing
+     *
+     * @param name  Name of the counter
+     * @param value Value of the counter
+     */
+    void setCounter(std::string name, double value) {
+        counters.emplace_back(std::move(name), value);
+    }
+
+    /**
+     * @brief Get the average time each operation took
+     *
+     * @return Nanoseconds per operation
+     */
+    [[nodiscard]] auto nanosecondsPerOperation() const -> double {
+        if (operations == 0)
+            return 0;
+        return std::chrono::duration<double, std::nano>(elapsed).count() /
+               static_cast<double>(operations);
+    }
+
+    /**
+     * @brief Get the counters set during the run
+     *
+     * @return Name and value of every counter
+     */
+    [[nodiscard]] auto getCounters() const
+        -> const std::vector<std::pair<std::string, double>> & {
+        return counters;
+    }
+
+  private:
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::duration elapsed{};
+    std::size_t operations = 0;
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+/// @brief Signature of a benchmark function
+using BenchmarkFunction = void (*)(Timer &);
+
+/**
+ * @brief Get every benchmark registered with the BENCHMARK macro
+ *
+ * @return Name and function of every registered benchmark
+ */
+auto getRegistry() -> std::vector<std::pair<std::string_view, BenchmarkFunction>> &;
+
+/**
+ * @brief Registers a benchmark on construction, used by the BENCHMARK macro
+ *
+ */
+struct Registrar {
+    /**
+     * @brief Register a benchmark
+     *
+     * @param name      Name printed in results and matched against the command line filter
+     * @param function  Benchmark to run
+     */
+    Registrar(std::string_view name, BenchmarkFunction function) {
+        getRegistry().emplace_back(name, function);
+    }
+};
+
+/**
+ * @brief Keep the compiler from optimising away a value that is otherwise unused
+ *
+ * @param value Value to keep alive
+ */
+template <typename T> void doNotOptimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace Bench
+
+/// @brief Define and register a benchmark taking a Bench::Timer& named timer
+#define BENCHMARK(function)                                                    \
+    static void function(Bench::Timer &timer);                                 \
+    static const Bench::Registrar function##Registrar{#function, function};   \
+    static void function(Bench::Timer &timer)
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * @file main.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Runs the registered benchmarks and prints their results
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "benchmark.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <span>
+#include <string_view>
+
+namespace Bench {
+
+auto getRegistry() -> std::vector<std::pair<std::string_view, BenchmarkFunction>>& {
+    static std::vector<std::pair<std::string_view, BenchmarkFunction>> registry;
+    return registry;
+}
+
+} // namespace Bench
+
+namespace {
+
+/// @brief Each benchmark runs this many times, and the fastest run is reported to cut out noise
+constexpr int repetitions = 5;
+
+} // namespace
+
+/**
+ * @brief Runs every benchmark whose name contains any of the command line arguments, or all of them if none given
+ *
+ * @return 0 on success
+ */
+auto main(int argc, char** argv) -> int {
+    const std::span<char*> filters{argv + 1, static_cast<std::size_t>(argc - 1)};
+
+    for(const auto& [name, function] : Bench::getRegistry()) {
+        const bool selected = filters.empty() || std::any_of(filters.begin(), filters.end(),
+            [&name](const char* filter) { return name.find(filter) != std::string_view::npos; });
+        if(!selected)
+            continue;
+
+        double bestNanoseconds = std::numeric_limits<double>::max();
+        Bench::Timer bestTimer;
+        for(int i = 0; i < repetitions; ++i) {
+            Bench::Timer timer;
+            function(timer);
+            if(timer.nanosecondsPerOperation() < bestNanoseconds) {
+                bestNanoseconds = timer.nanosecondsPerOperation();
+                bestTimer = timer;
+            }
+        }
+
+        std::printf("%-48.*s %10.2f ns/op", static_cast<int>(name.size()), name.data(), bestNanoseconds);
+        for(const auto& [counterName, value] : bestTimer.getCounters())
+            std::printf("  %s=%.2f", counterName.c_str(), value);
+        std::printf("\n");
+    }
+}
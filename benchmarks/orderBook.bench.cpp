@@ -0,0 +1,503 @@
+/**
+ * @file orderBook.bench.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Benchmarks for the core OrderBook operations: resting, cancelling and executing orders
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "benchmark.hpp"
+#include "orderBook.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace Exchange;
+using enum OrderType;
+
+namespace {
+
+constexpr int numOrders = 1'000'000;
+constexpr int numPrices = 1'000;
+
+/// @brief Bids rest on [1, numPrices], asks on (numPrices, 2 * numPrices], so nothing crosses
+auto passivePrice(int i) -> int {
+    return (i % 2 == 0) ? 1 + (i / 2) % numPrices : numPrices + 1 + (i / 2) % numPrices;
+}
+
+/**
+ * @brief Fill a book with numOrders passive orders
+ *
+ * @param orderBook Book to fill
+ * @return Ids of every order added
+ */
+auto fillPassive(OrderBook& orderBook) -> std::vector<int> {
+    std::vector<int> ids;
+    ids.reserve(numOrders);
+    for(int i = 0; i < numOrders; ++i)
+        ids.push_back(orderBook.addOrder((i % 2 == 0) ? buy : sell, 10, passivePrice(i))->getBaseId());
+
+    return ids;
+}
+
+/// @brief Bytes currently allocated on the heap, or 0 where the allocator can't tell us
+auto heapBytesInUse() -> std::size_t {
+#if defined(__GLIBC__)
+    const auto info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Rest numOrders passive orders spread over many accounts, the same with or without risk checks
+ *
+ * @param orderBook Book to fill
+ * @param timer     Timer to time the adds with
+ */
+void addAccountOrders(OrderBook& orderBook, Bench::Timer& timer) {
+    constexpr std::uint32_t numAccounts = 1'000;
+    timer.start();
+    for(int i = 0; i < numOrders; ++i)
+        orderBook.addOrder(OrderRequest{.orderType = (i % 2 == 0) ? buy : sell,
+                                        .shares = 10,
+                                        .limitPrice = passivePrice(i),
+                                        .accountId = 1 + static_cast<std::uint32_t>(i) % numAccounts});
+    timer.stop(numOrders);
+}
+
+/**
+ * @brief Take out whole levels of 500 orders from account 1, so the queue is walked front to back
+ *
+ * @param timer                 Timer to time the sweeps with
+ * @param selfTradePrevention   What the aggressive orders, from account 2, do on meeting their own account
+ */
+void sweepDeepLevels(Bench::Timer& timer, SelfTradePrevention selfTradePrevention) {
+    constexpr int ordersPerLevel = 500;
+    constexpr int sweeps = 2'000;
+    OrderBook orderBook;
+    for(int price = 1; price <= sweeps; ++price)
+        for(int i = 0; i < ordersPerLevel; ++i)
+            orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 10, .limitPrice = price, .accountId = 1});
+
+    timer.start();
+    for(int price = 1; price <= sweeps; ++price)
+        Bench::doNotOptimize(orderBook.addOrder(OrderRequest{.orderType = buy,
+                                                             .selfTradePrevention = selfTradePrevention,
+                                                             .shares = 10 * ordersPerLevel,
+                                                             .limitPrice = price,
+                                                             .accountId = 2}));
+    timer.stop(static_cast<std::size_t>(sweeps) * ordersPerLevel);
+}
+
+} // namespace
+
+BENCHMARK(addPassiveOrders) {
+    OrderBook orderBook;
+
+    timer.start();
+    fillPassive(orderBook);
+    timer.stop(numOrders);
+}
+
+BENCHMARK(bytesPerRestingOrder) {
+    // Same work as addPassiveOrders, but reports what each resting order costs in memory
+    const std::size_t heapBefore = heapBytesInUse();
+    OrderBook orderBook;
+
+    timer.start();
+    for(int i = 0; i < numOrders; ++i)
+        orderBook.addOrder((i % 2 == 0) ? buy : sell, 10, passivePrice(i));
+    timer.stop(numOrders);
+
+    timer.setCounter("hotBytes", sizeof(HotOrder));
+    timer.setCounter("coldBytes", sizeof(ColdOrder));
+    if(const std::size_t heapAfter = heapBytesInUse(); heapAfter > heapBefore)
+        timer.setCounter("heapBytesPerOrder", static_cast<double>(heapAfter - heapBefore) / numOrders);
+}
+
+BENCHMARK(cancelRestingOrders) {
+    OrderBook orderBook;
+    auto ids = fillPassive(orderBook);
+    std::shuffle(ids.begin(), ids.end(), std::mt19937{42});
+
+    timer.start();
+    for(const int id : ids)
+        orderBook.cancelOrder(id);
+    timer.stop(ids.size());
+}
+
+BENCHMARK(cancelRestingOrdersByHandle) {
+    OrderBook orderBook;
+    std::vector<OrderHandle> handles;
+    handles.reserve(numOrders);
+    for(int i = 0; i < numOrders; ++i)
+        handles.push_back(*orderBook.addOrder((i % 2 == 0) ? buy : sell, 10, passivePrice(i))->getRestingHandle());
+    std::shuffle(handles.begin(), handles.end(), std::mt19937{42});
+
+    timer.start();
+    for(const auto handle : handles)
+        orderBook.cancelOrder(handle);
+    timer.stop(handles.size());
+}
+
+BENCHMARK(staleCancels) {
+    // Cancels racing fills, every handle has already gone stale by the time it arrives
+    OrderBook orderBook;
+    std::vector<OrderHandle> handles;
+    handles.reserve(numOrders);
+    for(int i = 0; i < numOrders; ++i) {
+        handles.push_back(*orderBook.addOrder(sell, 10, 1 + i % numPrices)->getRestingHandle());
+        orderBook.addOrder(buy, 10, 1 + i % numPrices);
+    }
+
+    timer.start();
+    for(const auto handle : handles)
+        Bench::doNotOptimize(orderBook.cancelOrder(handle));
+    timer.stop(handles.size());
+}
+
+BENCHMARK(cancelHeavyDeepLevel) {
+    // Our flow: 9 in 10 orders at a level are cancelled, in random order, before the level trades
+    constexpr int rounds = 1'000;
+    constexpr int ordersPerRound = 1'000;
+    OrderBook orderBook;
+    std::vector<OrderHandle> handles(ordersPerRound);
+    std::vector<int> cancelOrder;
+    for(int i = 0; i < ordersPerRound; ++i)
+        if(i % 10 != 0)
+            cancelOrder.push_back(i);
+    std::shuffle(cancelOrder.begin(), cancelOrder.end(), std::mt19937{42});
+
+    timer.start();
+    for(int round = 0; round < rounds; ++round) {
+        for(auto& handle : handles)
+            handle = *orderBook.addOrder(sell, 10, 100)->getRestingHandle();
+        for(const int i : cancelOrder)
+            orderBook.cancelOrder(handles[i]);
+        Bench::doNotOptimize(orderBook.addOrder(buy, 10 * (ordersPerRound / 10), 100));
+    }
+    timer.stop(static_cast<std::size_t>(rounds) * (ordersPerRound + cancelOrder.size() + 1));
+}
+
+BENCHMARK(addCancelEmptyLevel) {
+    // Every add creates a level and every cancel destroys it, the worst case for level bookkeeping
+    OrderBook orderBook;
+
+    timer.start();
+    for(int i = 0; i < numOrders; ++i) {
+        const int id = orderBook.addOrder(buy, 10, 1 + i % numPrices)->getBaseId();
+        orderBook.cancelOrder(id);
+    }
+    timer.stop(2 * static_cast<std::size_t>(numOrders));
+}
+
+BENCHMARK(aggressiveOrdersSweepingLevels) {
+    // Each aggressive order takes out 3 whole levels of 10 orders each
+    constexpr int ordersPerLevel = 10;
+    constexpr int levelsPerSweep = 3;
+    constexpr int sweeps = 20'000;
+    OrderBook orderBook;
+    for(int price = 1; price <= sweeps * levelsPerSweep; ++price)
+        for(int i = 0; i < ordersPerLevel; ++i)
+            orderBook.addOrder(sell, 10, price);
+
+    timer.start();
+    for(int i = 1; i <= sweeps; ++i)
+        Bench::doNotOptimize(orderBook.addOrder(buy, 10 * ordersPerLevel * levelsPerSweep, i * levelsPerSweep));
+    timer.stop(sweeps);
+}
+
+BENCHMARK(aggressiveOrdersSweepingLevelsInBands) {
+    // Same sweeps as aggressiveOrdersSweepingLevels, with a collar and dynamic band checked on each but never hit
+    constexpr int ordersPerLevel = 10;
+    constexpr int levelsPerSweep = 3;
+    constexpr int sweeps = 20'000;
+    constexpr int basePrice = 100'000;
+    OrderBook orderBook;
+    orderBook.setPriceBands(PriceBandRules{.staticBasisPoints = 9'000, .dynamicBasisPoints = 100}, basePrice);
+    for(int price = 1; price <= sweeps * levelsPerSweep; ++price)
+        for(int i = 0; i < ordersPerLevel; ++i)
+            orderBook.addOrder(sell, 10, basePrice + price);
+
+    timer.start();
+    for(int i = 1; i <= sweeps; ++i)
+        Bench::doNotOptimize(
+            orderBook.addOrder(buy, 10 * ordersPerLevel * levelsPerSweep, basePrice + i * levelsPerSweep));
+    timer.stop(sweeps);
+}
+
+BENCHMARK(deepLevelSweeps) {
+    sweepDeepLevels(timer, SelfTradePrevention::none);
+}
+
+BENCHMARK(deepLevelSweepsPreventingSelfTrades) {
+    // deepLevelSweeps with self-trade prevention on, and never triggered, to compare against it
+    sweepDeepLevels(timer, SelfTradePrevention::cancelOldest);
+}
+
+BENCHMARK(massCancelOnDisconnect) {
+    // One account of a hundred disconnects from a book of 10M resting orders, its 100k orders are cancelled
+    constexpr int numOrders = 10'000'000;
+    constexpr std::uint32_t numAccounts = 100;
+    constexpr int numLevels = 10'000;
+    OrderBook orderBook;
+    for(int i = 0; i < numOrders; ++i)
+        orderBook.addOrder(OrderRequest{.orderType = sell,
+                                        .shares = 10,
+                                        .limitPrice = 1 + i % numLevels,
+                                        .accountId = 1 + static_cast<std::uint32_t>(i) % numAccounts});
+
+    timer.start();
+    const std::size_t cancelled = orderBook.cancelAccountOrders(7);
+    timer.stop(cancelled);
+}
+
+BENCHMARK(addOrdersWithoutRiskChecks) {
+    OrderBook orderBook;
+    addAccountOrders(orderBook, timer);
+}
+
+BENCHMARK(addOrdersWithRiskChecks) {
+    // Limits loose enough that every order passes, so both benchmarks rest the same book
+    RiskLedger ledger{1'001};
+    OrderBook orderBook;
+    orderBook.setRiskLedger(&ledger);
+    addAccountOrders(orderBook, timer);
+}
+
+BENCHMARK(manySmallBooks) {
+    // A universe of illiquid symbols, each with a few levels a side, traded at the touch in turn
+    constexpr int numBooks = 8'000;
+    constexpr int levelsPerSide = 5;
+    constexpr int rounds = 20;
+    const std::size_t heapBefore = heapBytesInUse();
+    std::vector<OrderBook> books(numBooks);
+    for(auto& book : books)
+        for(int price = 1; price <= levelsPerSide; ++price) {
+            book.addOrder(buy, 10, price);
+            book.addOrder(sell, 10, levelsPerSide + price);
+        }
+    if(const std::size_t heapAfter = heapBytesInUse(); heapAfter > heapBefore)
+        timer.setCounter("heapBytesPerBook", static_cast<double>(heapAfter - heapBefore) / numBooks);
+
+    timer.start();
+    for(int round = 0; round < rounds; ++round)
+        for(auto& book : books) {
+            Bench::doNotOptimize(book.addOrder(buy, 10, levelsPerSide + 1));
+            book.addOrder(sell, 10, levelsPerSide + 1);
+        }
+    timer.stop(2 * static_cast<std::size_t>(rounds) * numBooks);
+}
+
+BENCHMARK(shiftingLevelDensity) {
+    // The same book alternates between trading a dense ladder of levels and a sparse spread of them,
+    // reports what the book's moves between level storages cost
+    constexpr int phases = 20;
+    constexpr int levelsPerPhase = 2'000;
+    constexpr int tradesPerPhase = 20'000;
+    OrderBook orderBook;
+
+    timer.start();
+    for(int phase = 0; phase < phases; ++phase) {
+        const int tickSpacing = phase % 2 == 0 ? 1 : 500;
+        std::vector<int> ids;
+        ids.reserve(levelsPerPhase);
+        for(int level = 1; level <= levelsPerPhase; ++level)
+            ids.push_back(orderBook.addOrder(sell, 10, 1'000'000 + level * tickSpacing)->getBaseId());
+
+        // Take out and replace the best ask, then clear the phase's levels away
+        for(int trade = 0; trade < tradesPerPhase; ++trade) {
+            const Price bestAsk = orderBook.getBestAsk().value();
+            Bench::doNotOptimize(orderBook.addOrder(buy, 10, bestAsk));
+            ids.push_back(orderBook.addOrder(sell, 10, bestAsk)->getBaseId());
+        }
+        for(const int id : ids)
+            orderBook.cancelOrder(id);
+    }
+    timer.stop(static_cast<std::size_t>(phases) * (2 * levelsPerPhase + 3 * tradesPerPhase));
+
+    const auto& migrations = orderBook.getLevelMigrationStats();
+    timer.setCounter("migrations", static_cast<double>(migrations.migrations));
+    if(migrations.migrations > 0) {
+        timer.setCounter("avgMigrationMicros", static_cast<double>(migrations.totalNanoseconds) / 1000.0 / static_cast<double>(migrations.migrations));
+        timer.setCounter("maxMigrationMicros", static_cast<double>(migrations.maxNanoseconds) / 1000.0);
+    }
+}
+
+BENCHMARK(cumulativeDepthQueries) {
+    // A router asking how much it can take up to a price, and how far a size would push the price
+    constexpr int levelsPerSide = 2'000;
+    constexpr int queries = 1'000'000;
+    OrderBook orderBook;
+    for(int price = 1; price <= levelsPerSide; ++price) {
+        orderBook.addOrder(buy, price % 7 + 1, price);
+        orderBook.addOrder(sell, price % 5 + 1, levelsPerSide + price);
+    }
+
+    std::mt19937 generator{3};
+    std::vector<int> draws(queries);
+    for(auto& draw : draws)
+        draw = static_cast<int>(generator() % levelsPerSide);
+
+    timer.start();
+    for(int i = 0; i < queries; ++i) {
+        if(i % 2 == 0)
+            Bench::doNotOptimize(orderBook.getAvailableShares(i % 4 == 0 ? buy : sell, levelsPerSide / 2 + draws[i]));
+        else
+            Bench::doNotOptimize(orderBook.getImpactPrice(i % 4 == 1 ? buy : sell, 1 + draws[i]));
+    }
+    timer.stop(queries);
+}
+
+BENCHMARK(queuePositionOnDeepLevels) {
+    // Market makers polling their place in 50k order queues, while others cancel and rejoin at the back
+    constexpr int ordersPerLevel = 50'000;
+    constexpr int queries = 1'000'000;
+    OrderBook orderBook;
+    std::vector<OrderHandle> handles;
+    for(int i = 0; i < ordersPerLevel; ++i) {
+        handles.push_back(*orderBook.addOrder(sell, 1 + i % 9, 100)->getRestingHandle());
+        handles.push_back(*orderBook.addOrder(buy, 1 + i % 7, 99)->getRestingHandle());
+    }
+
+    std::mt19937 generator{9};
+    std::vector<std::size_t> draws(queries);
+    for(auto& draw : draws)
+        draw = generator() % handles.size();
+
+    timer.start();
+    for(int i = 0; i < queries; ++i) {
+        OrderHandle& handle = handles[draws[i]];
+        if(i % 8 == 0) {
+            const bool isSell = draws[i] % 2 == 0;
+            orderBook.cancelOrder(handle);
+            handle = *orderBook.addOrder(isSell ? sell : buy, 5, isSell ? 100 : 99)->getRestingHandle();
+        }
+        Bench::doNotOptimize(orderBook.getQueuePosition(handle));
+    }
+    timer.stop(queries);
+}
+
+BENCHMARK(proRataDeepLevels) {
+    // Futures-style matching, each fill shared out over every one of thousands of orders at the level
+    constexpr int ordersPerLevel = 4'000;
+    constexpr int levels = 50;
+    constexpr int fillsPerLevel = 20;
+    OrderBook orderBook{MatchingRules{
+        .algorithm = MatchingAlgorithm::proRata, .topOrderPriority = true, .fifoPercent = 20, .minAllocation = 2}};
+    for(int price = 1; price <= levels; ++price)
+        for(int i = 0; i < ordersPerLevel; ++i)
+            orderBook.addOrder(sell, 100 + i % 900, price);
+
+    timer.start();
+    for(int price = 1; price <= levels; ++price) {
+        // A twentieth of what's left each time, then whatever remains
+        for(int fill = 1; fill < fillsPerLevel; ++fill)
+            Bench::doNotOptimize(orderBook.addOrder(buy, orderBook.getAvailableShares(buy, price).value() / 20, price));
+        Bench::doNotOptimize(orderBook.addOrder(buy, orderBook.getAvailableShares(buy, price), price));
+    }
+    timer.stop(static_cast<std::size_t>(levels) * fillsPerLevel * ordersPerLevel);
+}
+
+BENCHMARK(closingAuctions) {
+    // The closing auction of every symbol, each book crossed over a few dozen levels. Reported per book.
+    constexpr int numBooks = 8'000;
+    constexpr int ordersPerSide = 100;
+    std::vector<OrderBook> books(numBooks);
+    std::mt19937 generator{21};
+    setSessionState(books, SessionState::auction);
+    for(auto& book : books) {
+        for(int i = 0; i < ordersPerSide; ++i) {
+            book.addOrder(buy, 1 + static_cast<int>(generator() % 50), 90 + static_cast<int>(generator() % 30));
+            book.addOrder(sell, 1 + static_cast<int>(generator() % 50), 80 + static_cast<int>(generator() % 30));
+        }
+    }
+
+    timer.start();
+    for(auto& book : books)
+        Bench::doNotOptimize(book.uncrossAuction(95));
+    timer.stop(numBooks);
+}
+
+BENCHMARK(haltAndResumeAcrossBooks) {
+    // A market-wide halt, a burst of orders queued in every book, then resuming them all. Reported per book.
+    constexpr int numBooks = 8'000;
+    constexpr int queuedPerBook = 20;
+    std::vector<OrderBook> books(numBooks);
+    for(auto& book : books)
+        for(int price = 100; price < 110; ++price)
+            book.addOrder(sell, 10, price);
+
+    // The first halt reserves each book's queue, later ones don't allocate
+    setSessionState(books, SessionState::halted);
+    setSessionState(books, SessionState::continuous);
+
+    timer.start();
+    Bench::doNotOptimize(setSessionState(books, SessionState::halted));
+    for(auto& book : books)
+        for(int i = 0; i < queuedPerBook; ++i)
+            Bench::doNotOptimize(book.addOrder(i % 2 == 0 ? buy : sell, 5, i % 2 == 0 ? 100 + i / 2 : 110 + i / 2));
+    Bench::doNotOptimize(setSessionState(books, SessionState::continuous));
+    timer.stop(numBooks);
+}
+
+BENCHMARK(simulateSweepingOrders) {
+    // Same book and orders as aggressiveOrdersSweepingLevels, simulated instead of sent
+    constexpr int ordersPerLevel = 10;
+    constexpr int levelsPerSweep = 3;
+    constexpr int sweeps = 20'000;
+    OrderBook orderBook;
+    for(int price = 1; price <= sweeps * levelsPerSweep; ++price)
+        for(int i = 0; i < ordersPerLevel; ++i)
+            orderBook.addOrder(sell, 10, price);
+    std::array<int, ordersPerLevel * levelsPerSweep> filledIds{};
+
+    const std::size_t heapBefore = heapBytesInUse();
+    timer.start();
+    for(int i = 1; i <= sweeps; ++i)
+        Bench::doNotOptimize(orderBook.simulateOrder(buy, 10 * ordersPerLevel * levelsPerSweep, levelsPerSweep, filledIds));
+    timer.stop(sweeps);
+    timer.setCounter("heapBytesGrown", static_cast<double>(heapBytesInUse() - heapBefore));
+}
+
+BENCHMARK(mixedSideAggressiveOrders) {
+    // Randomly sided aggressive orders, each taking out the best level, which is then put back
+    constexpr int iterations = 500'000;
+    constexpr int levels = 500;
+    OrderBook orderBook;
+    for(int price = 1; price <= levels; ++price) {
+        orderBook.addOrder(buy, 10, price);
+        orderBook.addOrder(sell, 10, levels + price);
+    }
+
+    std::mt19937 generator{7};
+    std::vector<OrderType> sides(iterations);
+    for(auto& side : sides)
+        side = (generator() % 2 == 0) ? buy : sell;
+
+    timer.start();
+    for(const auto side : sides) {
+        if(side == buy) {
+            const Price bestAsk = orderBook.getBestAsk().value();
+            Bench::doNotOptimize(orderBook.addOrder(buy, 10, bestAsk));
+            orderBook.addOrder(sell, 10, bestAsk);
+        } else {
+            const Price bestBid = orderBook.getBestBid().value();
+            Bench::doNotOptimize(orderBook.addOrder(sell, 10, bestBid));
+            orderBook.addOrder(buy, 10, bestBid);
+        }
+    }
+    timer.stop(2 * static_cast<std::size_t>(iterations));
+}
@@ -0,0 +1,62 @@
+/**
+ * @file accountIndex.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Implements AccountIndex member functions
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "accountIndex.hpp"
+
+namespace Exchange {
+
+void AccountIndex::link(OrderSlot slot, std::uint32_t accountId) {
+    // Pool slots are handed out densely, so this only grows along with the pool
+    if(slot >= links.size())
+        links.resize(static_cast<std::size_t>(slot) + 1);
+    if(accountId >= heads.size())
+        heads.resize(static_cast<std::size_t>(accountId) + 1, noSlot);
+
+    const OrderSlot head = heads[accountId];
+    if(head == noSlot) {
+        links[slot] = Link{slot, slot};
+        heads[accountId] = slot;
+        ++nonEmptyLists;
+        return;
+    }
+
+    const OrderSlot tail = links[head].prev;
+    links[slot] = Link{head, tail};
+    links[tail].next = slot;
+    links[head].prev = slot;
+}
+
+void AccountIndex::unlink(OrderSlot slot, std::uint32_t accountId) {
+    const Link link = links[slot];
+    if(link.next == slot) {
+        heads[accountId] = noSlot;
+        --nonEmptyLists;
+        return;
+    }
+
+    links[link.prev].next = link.next;
+    links[link.next].prev = link.prev;
+    if(heads[accountId] == slot)
+        heads[accountId] = link.next;
+}
+
+auto AccountIndex::getFirst(std::uint32_t accountId) const -> OrderSlot {
+    return accountId < heads.size() ? heads[accountId] : noSlot;
+}
+
+auto AccountIndex::getLast(std::uint32_t accountId) const -> OrderSlot {
+    const OrderSlot head = getFirst(accountId);
+    return head == noSlot ? noSlot : links[head].prev;
+}
+
+auto AccountIndex::size() const -> std::size_t { return nonEmptyLists; }
+
+} // namespace Exchange
@@ -0,0 +1,95 @@
+/**
+ * @file accountIndex.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the lists linking every resting order of an account together
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ACCOUNTINDEX_HPP
+#define ACCOUNTINDEX_HPP
+
+#include "order.hpp"
+#include "orderHandle.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Exchange {
+
+/**
+ * @brief Intrusive lists of OrderPool slots, one per account, so all of an account's orders are found in O(k)
+ *
+ * Each list is circular and doubly linked through links, a pair of slots per pool slot, with the oldest order as
+ * its head, so orders are appended at the head's prev and any order is unlinked in O(1). The heads are kept in a
+ * vector indexed by account ID, as RiskLedger's accounts are, so unlinking is a few stores with no lookup. Account
+ * IDs should be dense, the vector grows to the largest one linked.
+ */
+struct AccountIndex {
+    /**
+     * @brief Append an order to its account's list
+     *
+     * @param slot      Slot of the order, not linked yet
+     * @param accountId Account of the order, not noAccount
+     */
+    void link(OrderSlot slot, std::uint32_t accountId);
+
+    /**
+     * @brief Take an order out of its account's list
+     *
+     * @param slot      Slot of the order, linked into accountId's list
+     * @param accountId Account of the order
+     */
+    void unlink(OrderSlot slot, std::uint32_t accountId);
+
+    /**
+     * @brief Get the oldest order of an account
+     *
+     * @param accountId Account to look up
+     * @return Slot of its oldest resting order, or noSlot if it has none
+     */
+    [[nodiscard]] auto getFirst(std::uint32_t accountId) const -> OrderSlot;
+
+    /**
+     * @brief Get the newest order of an account
+     *
+     * @param accountId Account to look up
+     * @return Slot of its newest resting order, or noSlot if it has none
+     */
+    [[nodiscard]] auto getLast(std::uint32_t accountId) const -> OrderSlot;
+
+    /**
+     * @brief Get the next order of the same account
+     *
+     * @param slot Slot of a linked order
+     * @return Slot of the account's next order, or the first one again once the list wraps around
+     */
+    [[nodiscard]] auto getNext(OrderSlot slot) const -> OrderSlot { return links[slot].next; }
+
+    /**
+     * @brief Get the number of accounts with resting orders
+     *
+     * @return Number of non-empty lists
+     */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+  private:
+    /// @brief Neighbours of a slot in its account's list
+    struct Link {
+        OrderSlot next = noSlot;
+        OrderSlot prev = noSlot;
+    };
+
+    std::vector<Link> links;
+
+    /// @brief Head of each account's list, noSlot if it has no resting orders
+    std::vector<OrderSlot> heads;
+    std::size_t nonEmptyLists = 0;
+};
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file auction.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Implements the search for a call auction's uncrossing price
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "auction.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace Exchange {
+
+namespace {
+
+/**
+ * @brief Get the size of a surplus, whichever side it's on
+ *
+ * @param surplus Buy minus sell shares
+ * @return Absolute value
+ */
+auto getSurplusSize(Qty surplus) -> Qty { return surplus < 0 ? Qty{0} - surplus : surplus; }
+
+/**
+ * @brief Get how far a price is from the reference price
+ *
+ * @param price             Candidate price
+ * @param referencePrice    Reference price
+ * @return Distance in ticks
+ */
+auto getDistance(Price price, Price referencePrice) -> std::int64_t {
+    const std::int64_t difference = price.value() - referencePrice.value();
+    return difference < 0 ? -difference : difference;
+}
+
+} // namespace
+
+auto findUncrossingPrice(std::span<const AuctionLevel> levels, Price referencePrice) -> std::optional<AuctionUncross> {
+    Qty buyShares = 0;
+    for(const AuctionLevel& level : levels)
+        buyShares += level.buyShares;
+
+    // Only the extremes, the closest, and which way the surplus points are needed to break ties, never the whole tie
+    std::optional<AuctionUncross> lowest;
+    AuctionUncross highest{};
+    AuctionUncross closest{};
+    bool allBuySurplus = false;
+    bool allSellSurplus = false;
+
+    Qty buyBelow = 0;
+    Qty sellAtOrBelow = 0;
+    for(const AuctionLevel& level : levels) {
+        const Qty buyAtOrAbove = buyShares - buyBelow;
+        buyBelow += level.buyShares;
+        sellAtOrBelow += level.sellShares;
+
+        const AuctionUncross candidate{level.price, std::min(buyAtOrAbove, sellAtOrBelow), buyAtOrAbove - sellAtOrBelow};
+        if(candidate.volume <= 0)
+            continue;
+
+        const bool isBetter = !lowest || candidate.volume > lowest->volume ||
+                              (candidate.volume == lowest->volume && getSurplusSize(candidate.surplus) < getSurplusSize(lowest->surplus));
+        if(isBetter) {
+            lowest = highest = closest = candidate;
+            allBuySurplus = candidate.surplus > 0;
+            allSellSurplus = candidate.surplus < 0;
+            continue;
+        }
+
+        if(candidate.volume != lowest->volume || getSurplusSize(candidate.surplus) != getSurplusSize(lowest->surplus))
+            continue;
+        highest = candidate;
+        allBuySurplus = allBuySurplus && candidate.surplus > 0;
+        allSellSurplus = allSellSurplus && candidate.surplus < 0;
+        if(getDistance(candidate.price, referencePrice) < getDistance(closest.price, referencePrice))
+            closest = candidate;
+    }
+
+    if(!lowest)
+        return {};
+    if(allBuySurplus)
+        return highest;
+    if(allSellSurplus)
+        return lowest;
+    return closest;
+}
+
+} // namespace Exchange
@@ -0,0 +1,86 @@
+/**
+ * @file auction.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for finding the price a call auction uncrosses at, and what the uncross executed
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef AUCTION_HPP
+#define AUCTION_HPP
+
+#include "fixedPoint.hpp"
+#include "orderExecution.hpp"
+#include <optional>
+#include <span>
+
+namespace Exchange {
+
+/**
+ * @brief Shares resting at exactly one price of the crossed part of a book, on each side
+ *
+ */
+struct AuctionLevel {
+    /// @brief Price of the level
+    Price price;
+    /// @brief Buy shares resting at price, 0 if there is no buy level there
+    Qty buyShares;
+    /// @brief Sell shares resting at price, 0 if there is no sell level there
+    Qty sellShares;
+};
+
+/**
+ * @brief Price a call auction uncrosses at, and the shares it trades there
+ *
+ */
+struct AuctionUncross {
+    /// @brief Single price every trade of the uncross happens at
+    Price price;
+    /// @brief Shares traded, the most any price could trade
+    Qty volume;
+    /// @brief Buy shares at or above price minus sell shares at or below it, the part of the more eager side left over
+    Qty surplus;
+
+    /**
+     * @brief Uncrosses are equal if every member is equal
+     *
+     * @return True if equal
+     */
+    auto operator==(const AuctionUncross &) const -> bool = default;
+};
+
+/**
+ * @brief What uncrossing a call auction did, as returned by OrderBook::uncrossAuction
+ *
+ */
+struct AuctionResult {
+    /// @brief Price, volume and surplus of the uncross, or std::nullopt if the book wasn't crossed
+    std::optional<AuctionUncross> uncross;
+    /// @brief Resting buy orders that traded, all at the uncross price
+    OrderExecution buyFills;
+    /// @brief Resting sell orders that traded, all at the uncross price
+    OrderExecution sellFills;
+};
+
+/**
+ * @brief Find the price a call auction uncrosses at, in one pass over the crossed levels
+ *
+ * Of the level prices, picks the one trading the most shares, then the one leaving the smallest surplus.
+ * If several are still tied, market pressure decides: the highest if every one of them has a buy surplus, the lowest
+ * if every one has a sell surplus. Otherwise the one closest to the reference price wins, the lower of two equally
+ * close.
+ *
+ * @param levels            Every price with buy shares at or above the best ask, or sell shares at or below the best
+ *                          bid, in ascending order of price
+ * @param referencePrice    Usually the last traded or previous closing price
+ * @return The uncross, or std::nullopt if no price trades any shares
+ */
+[[nodiscard]] auto findUncrossingPrice(std::span<const AuctionLevel> levels, Price referencePrice)
+    -> std::optional<AuctionUncross>;
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file bookSnapshot.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the fixed size depth snapshot published to reader threads
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BOOKSNAPSHOT_HPP
+#define BOOKSNAPSHOT_HPP
+
+#include "topOfBook.hpp"
+#include <array>
+#include <cstddef>
+
+namespace Exchange {
+
+/// @brief Number of price levels per side kept in a BookSnapshot
+inline constexpr std::size_t snapshotDepth = 5;
+
+/**
+ * @brief Aggregated shares resting at a single price
+ *
+ */
+struct PriceLevel {
+    /// @brief Price of the level
+    Price price = 0;
+    /// @brief Total shares resting at price
+    Qty shares = 0;
+
+    /**
+     * @brief Compare two levels field by field
+     *
+     * @param rhs PriceLevel to compare against
+     * @return True if price and shares are equal
+     */
+    auto operator==(const PriceLevel &rhs) const -> bool = default;
+};
+
+/**
+ * @brief The best snapshotDepth levels of each side of an OrderBook
+ *
+ * Trivially copyable so it can be published through a Seqlock.
+ * Bids are ordered from highest to lowest price, asks from lowest to highest.
+ */
+struct BookSnapshot {
+    /// @brief Best buying levels, only the first bidLevels are valid
+    std::array<PriceLevel, snapshotDepth> bids{};
+    /// @brief Best selling levels, only the first askLevels are valid
+    std::array<PriceLevel, snapshotDepth> asks{};
+    /// @brief Number of valid entries in bids
+    std::size_t bidLevels = 0;
+    /// @brief Number of valid entries in asks
+    std::size_t askLevels = 0;
+
+    /**
+     * @brief Get the top of book contained in this snapshot
+     *
+     * @return TopOfBook made of the first level of each side
+     */
+    [[nodiscard]] auto getTopOfBook() const -> TopOfBook {
+        TopOfBook topOfBook;
+        if (bidLevels > 0) {
+            topOfBook.bidPrice = bids[0].price;
+            topOfBook.bidShares = bids[0].shares;
+        }
+        if (askLevels > 0) {
+            topOfBook.askPrice = asks[0].price;
+            topOfBook.askShares = asks[0].shares;
+        }
+
+        return topOfBook;
+    }
+
+    /**
+     * @brief Compare two snapshots level by level
+     *
+     * @param rhs BookSnapshot to compare against
+     * @return True if every level on both sides is equal
+     */
+    auto operator==(const BookSnapshot &rhs) const -> bool = default;
+};
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file chunkPool.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Implements ChunkPool member functions
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "chunkPool.hpp"
+
+namespace Exchange {
+
+auto ChunkPool::allocate() -> ChunkIndex {
+    ++usedChunks;
+
+    if(freeHead == noChunk) {
+        chunks.emplace_back();
+        quantities.emplace_back();
+        nextChunks.push_back(noChunk);
+        sequences.push_back(0);
+        return static_cast<ChunkIndex>(chunks.size() - 1);
+    }
+
+    const ChunkIndex chunk = freeHead;
+    freeHead = nextChunks[chunk];
+    nextChunks[chunk] = noChunk;
+    return chunk;
+}
+
+void ChunkPool::release(ChunkIndex chunk) {
+    --usedChunks;
+    nextChunks[chunk] = freeHead;
+    freeHead = chunk;
+}
+
+auto ChunkPool::allocateDepthTree() -> DepthTreeIndex {
+    if(freeDepthTrees.empty()) {
+        depthTrees.emplace_back();
+        return static_cast<DepthTreeIndex>(depthTrees.size() - 1);
+    }
+
+    const DepthTreeIndex tree = freeDepthTrees.back();
+    freeDepthTrees.pop_back();
+    return tree;
+}
+
+void ChunkPool::releaseDepthTree(DepthTreeIndex tree) { freeDepthTrees.push_back(tree); }
+
+auto ChunkPool::size() const -> std::size_t { return usedChunks; }
+
+} // namespace Exchange
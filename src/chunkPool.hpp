@@ -0,0 +1,232 @@
+/**
+ * @file chunkPool.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the pool of fixed size chunks that level queues are built from
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef CHUNKPOOL_HPP
+#define CHUNKPOOL_HPP
+
+#include "orderHandle.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Exchange {
+
+/// @brief Index of a chunk in a ChunkPool
+using ChunkIndex = std::uint32_t;
+
+/// @brief Marks the end of a list of chunks
+constexpr ChunkIndex noChunk = std::numeric_limits<ChunkIndex>::max();
+
+/// @brief Number of queue entries in one chunk, so a chunk fills exactly one cache line
+constexpr std::uint32_t chunkCapacity = 16;
+
+/**
+ * @brief A cache line of consecutive entries of a level queue
+ *
+ */
+struct alignas(64) QueueChunk {
+    /// @brief Slots of queued orders, noSlot marks a cancelled order
+    std::array<OrderSlot, chunkCapacity> slots;
+};
+
+static_assert(sizeof(QueueChunk) == 64, "QueueChunk must be exactly one cache line");
+
+/**
+ * @brief Resting shares of the entries of the QueueChunk with the same index
+ *
+ * Stored apart from the slots, so a fill can be planned by scanning quantities alone.
+ */
+struct alignas(64) QuantityChunk {
+    /// @brief Raw Qty values, 0 for a cancelled order, so SIMD code can load them directly
+    std::array<std::int64_t, chunkCapacity> shares;
+};
+
+static_assert(sizeof(QuantityChunk) == 2 * 64, "QuantityChunk must be exactly two cache lines");
+
+/// @brief Index of a QueueDepthTree in a ChunkPool
+using DepthTreeIndex = std::uint32_t;
+
+/// @brief Marks a queue without a depth tree
+constexpr DepthTreeIndex noDepthTree = std::numeric_limits<DepthTreeIndex>::max();
+
+/**
+ * @brief Fenwick tree of live shares per chunk of one long queue, indexed by chunk sequence number
+ *
+ */
+struct QueueDepthTree {
+    /// @brief Sequence number of the chunk at index 1
+    std::uint32_t base = 0;
+    /// @brief 1-indexed partial sums, index 0 unused
+    std::vector<std::int64_t> sums;
+};
+
+/**
+ * @brief Chunks shared by every level queue of a book, reused through a free list
+ *
+ * A queue is a singly linked list of chunks, so a fill walks memory sequentially sixteen orders at a time,
+ * and pushing or popping only touches the end chunks. Long queues also get a depth tree from the pool. An entry is addressed by its position,
+ * chunk * chunkCapacity + offset, which stays valid until the chunk is released.
+ */
+struct ChunkPool {
+    /**
+     * @brief Take a chunk for a queue
+     *
+     * @return Index of the chunk, not linked to anything
+     */
+    auto allocate() -> ChunkIndex;
+
+    /**
+     * @brief Return a chunk to the pool
+     *
+     * @param chunk Chunk to free, must not be reachable from any queue anymore
+     */
+    void release(ChunkIndex chunk);
+
+    /**
+     * @brief Take a depth tree for a queue, reusing the storage of a released one if there is any
+     *
+     * @return Index of the tree, its contents are left for the queue to rebuild
+     */
+    auto allocateDepthTree() -> DepthTreeIndex;
+
+    /**
+     * @brief Return a depth tree to the pool
+     *
+     * @param tree Tree to free, keeping its storage for the next queue that needs one
+     */
+    void releaseDepthTree(DepthTreeIndex tree);
+
+    /**
+     * @brief Get a queue's depth tree
+     *
+     * @param tree Allocated tree
+     * @return Reference to the tree
+     */
+    [[nodiscard]] auto getDepthTree(DepthTreeIndex tree) -> QueueDepthTree & { return depthTrees[tree]; }
+
+    /**
+     * @brief Get a queue's depth tree
+     *
+     * @param tree Allocated tree
+     * @return Reference to the tree
+     */
+    [[nodiscard]] auto getDepthTree(DepthTreeIndex tree) const -> const QueueDepthTree & { return depthTrees[tree]; }
+
+    /**
+     * @brief Get the chunk after another in its queue
+     *
+     * @param chunk Chunk in a queue
+     * @return Next chunk, or noChunk if chunk is the last one
+     */
+    [[nodiscard]] auto getNext(ChunkIndex chunk) const -> ChunkIndex { return nextChunks[chunk]; }
+
+    /**
+     * @brief Link a chunk after another
+     *
+     * @param chunk Chunk to link from
+     * @param next  Chunk to follow it, or noChunk
+     */
+    void setNext(ChunkIndex chunk, ChunkIndex next) { nextChunks[chunk] = next; }
+
+    /**
+     * @brief Get a chunk's place in its queue
+     *
+     * @param chunk Chunk in a queue
+     * @return Sequence number set by its queue, larger for chunks further from the head
+     */
+    [[nodiscard]] auto getSequence(ChunkIndex chunk) const -> std::uint32_t { return sequences[chunk]; }
+
+    /**
+     * @brief Set a chunk's place in its queue
+     *
+     * @param chunk    Chunk in a queue
+     * @param sequence One more than the sequence of the chunk before it, or anything for a head chunk
+     */
+    void setSequence(ChunkIndex chunk, std::uint32_t sequence) { sequences[chunk] = sequence; }
+
+    /**
+     * @brief Get a chunk's entries
+     *
+     * @param chunk Allocated chunk
+     * @return Reference to the chunk
+     */
+    [[nodiscard]] auto getChunk(ChunkIndex chunk) -> QueueChunk & { return chunks[chunk]; }
+
+    /**
+     * @brief Get a chunk's entries
+     *
+     * @param chunk Allocated chunk
+     * @return Reference to the chunk
+     */
+    [[nodiscard]] auto getChunk(ChunkIndex chunk) const -> const QueueChunk & { return chunks[chunk]; }
+
+    /**
+     * @brief Get the resting shares of a chunk's entries
+     *
+     * @param chunk Allocated chunk
+     * @return Reference to the chunk's quantities
+     */
+    [[nodiscard]] auto getQuantities(ChunkIndex chunk) -> QuantityChunk & { return quantities[chunk]; }
+
+    /**
+     * @brief Get the resting shares of a chunk's entries
+     *
+     * @param chunk Allocated chunk
+     * @return Reference to the chunk's quantities
+     */
+    [[nodiscard]] auto getQuantities(ChunkIndex chunk) const -> const QuantityChunk & { return quantities[chunk]; }
+
+    /**
+     * @brief Get the resting shares of the queue entry at a position
+     *
+     * @param position chunk * chunkCapacity + offset
+     * @return Reference to the raw quantity
+     */
+    [[nodiscard]] auto getQuantity(std::uint32_t position) -> std::int64_t & {
+        return quantities[position / chunkCapacity].shares[position % chunkCapacity];
+    }
+
+    /**
+     * @brief Get the queue entry at a position
+     *
+     * @param position chunk * chunkCapacity + offset
+     * @return Reference to the entry
+     */
+    [[nodiscard]] auto getEntry(std::uint32_t position) -> OrderSlot & {
+        return chunks[position / chunkCapacity].slots[position % chunkCapacity];
+    }
+
+    /**
+     * @brief Get the number of chunks in use
+     *
+     * @return Number of allocated chunks
+     */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+  private:
+    std::vector<QueueChunk> chunks;
+    std::vector<QuantityChunk> quantities;
+    /// @brief Kept out of the chunks so each one holds a whole cache line of entries. Links free chunks too.
+    std::vector<ChunkIndex> nextChunks;
+    /// @brief Only read when a level answers queue position queries
+    std::vector<std::uint32_t> sequences;
+    /// @brief Only the few long queues have one, so levels just hold an index
+    std::vector<QueueDepthTree> depthTrees;
+    std::vector<DepthTreeIndex> freeDepthTrees;
+    ChunkIndex freeHead = noChunk;
+    std::size_t usedChunks = 0;
+};
+
+} // namespace Exchange
+
+#endif
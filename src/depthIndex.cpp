@@ -0,0 +1,120 @@
+/**
+ * @file depthIndex.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Implements DepthIndex member functions
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "depthIndex.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace Exchange {
+
+auto DepthIndex::add(Price price, Qty shares) -> bool {
+    if(!enabled)
+        return true;
+
+    const std::int64_t tick = price.value() - base.value();
+    if(tick < 0 || tick >= static_cast<std::int64_t>(tree.size()) - 1)
+        return false;
+
+    for(auto i = static_cast<std::size_t>(tick) + 1; i < tree.size(); i += i & (~i + 1))
+        tree[i] += shares.value();
+    total += shares.value();
+    return true;
+}
+
+void DepthIndex::rebuild(std::span<const PriceLevel> levels) {
+    tree.clear();
+    total = 0;
+    enabled = true;
+    if(levels.empty())
+        return;
+
+    const auto [lowest, highest] = std::minmax_element(levels.begin(), levels.end(),
+        [](const PriceLevel &lhs, const PriceLevel &rhs) { return lhs.price < rhs.price; });
+    const std::int64_t span = highest->price.value() - lowest->price.value() + 1;
+    if(span > maxDepthIndexTicks) {
+        enabled = false;
+        tree.shrink_to_fit();
+        return;
+    }
+
+    // Room on both sides, so levels appearing next to the current ones don't force another rebuild
+    const std::int64_t slack = std::max<std::int64_t>(32, span / 4);
+    const auto width = std::bit_ceil(static_cast<std::size_t>(span + 2 * slack));
+    base = lowest->price.value() - slack;
+    tree.assign(width + 1, 0);
+
+    for(const auto &level : levels) {
+        tree[static_cast<std::size_t>(level.price.value() - base.value()) + 1] += level.shares.value();
+        total += level.shares.value();
+    }
+    // Linear time construction, each node passes its sum up to its parent
+    for(std::size_t i = 1; i <= width; ++i)
+        if(const std::size_t parent = i + (i & (~i + 1)); parent <= width)
+            tree[parent] += tree[i];
+}
+
+void DepthIndex::clear() {
+    tree = {};
+    base = 0;
+    total = 0;
+    enabled = true;
+}
+
+auto DepthIndex::getDepthAtOrBelow(Price price) const -> Qty {
+    return sumOfFirst(price.value() - base.value() + 1);
+}
+
+auto DepthIndex::getDepthAtOrAbove(Price price) const -> Qty {
+    return total - sumOfFirst(price.value() - base.value());
+}
+
+auto DepthIndex::findPriceFromBelow(Qty shares) const -> std::optional<Price> {
+    if(shares <= 0 || shares > total)
+        return {};
+
+    // Every tick within shares - 1 still leaves some wanted, the next one reaches them
+    return base.value() + static_cast<std::int64_t>(countTicksWithin(shares.value() - 1));
+}
+
+auto DepthIndex::findPriceFromAbove(Qty shares) const -> std::optional<Price> {
+    if(shares <= 0 || shares > total)
+        return {};
+
+    // The ticks below the answer can hold at most total - shares, and the answer is the first one past them
+    return base.value() + static_cast<std::int64_t>(countTicksWithin(total - shares.value()));
+}
+
+auto DepthIndex::sumOfFirst(std::int64_t count) const -> std::int64_t {
+    if(count <= 0 || tree.empty())
+        return 0;
+
+    std::int64_t sum = 0;
+    for(auto i = static_cast<std::size_t>(std::min<std::int64_t>(count, static_cast<std::int64_t>(tree.size()) - 1)); i > 0;
+        i &= i - 1)
+        sum += tree[i];
+    return sum;
+}
+
+auto DepthIndex::countTicksWithin(std::int64_t limit) const -> std::size_t {
+    if(tree.empty())
+        return 0;
+
+    // Binary lifting down the tree, taking each node that still fits
+    std::size_t position = 0;
+    for(std::size_t step = tree.size() - 1; step > 0; step /= 2)
+        if(position + step < tree.size() && tree[position + step] <= limit) {
+            position += step;
+            limit -= tree[position];
+        }
+    return position;
+}
+
+} // namespace Exchange
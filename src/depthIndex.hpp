@@ -0,0 +1,142 @@
+/**
+ * @file depthIndex.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the Fenwick tree of resting shares by price, used for cumulative depth queries
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef DEPTHINDEX_HPP
+#define DEPTHINDEX_HPP
+
+#include "bookSnapshot.hpp"
+#include "fixedPoint.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Exchange {
+
+/// @brief Widest range of prices, in ticks, a DepthIndex covers before it gives up. Bounds its memory and rebuild cost.
+inline constexpr std::int64_t maxDepthIndexTicks = std::int64_t{1} << 16;
+
+/**
+ * @brief Resting shares of one side by price, as a Fenwick tree over a window of ticks
+ *
+ * Every depth change is one O(log W) update, where W is the window's width in ticks, and cumulative depth up to a
+ * price, or the price a number of shares reaches, are O(log W) queries. The window follows the side's levels with
+ * room to spare. The owner rebuilds it from the levels whenever a price falls outside it, and a side spread wider
+ * than maxDepthIndexTicks disables the index until a later rebuild finds it narrow enough again.
+ *
+ * An index holds no tree until it is first rebuilt with levels, and clear gives its tree back, so the owner only
+ * pays for one while a side has more levels than are quicker to walk.
+ */
+struct DepthIndex {
+    /**
+     * @brief Add to, or with a negative count take from, the shares resting at a price
+     *
+     * @param price     Price of the level
+     * @param shares    Change in its shares
+     * @return False if the index is enabled but doesn't cover price, in which case nothing changed and it must
+     *         be rebuilt, true otherwise
+     */
+    auto add(Price price, Qty shares) -> bool;
+
+    /**
+     * @brief Replace the contents with the given levels, sizing the window around them
+     *
+     * @param levels Every level of the side, in any order. Leaves the index disabled if they span too many ticks.
+     */
+    void rebuild(std::span<const PriceLevel> levels);
+
+    /**
+     * @brief Empty the index and free its tree, the next add then asks for a rebuild
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Check if the index reflects its side
+     *
+     * @return False while the side is spread too widely for it
+     */
+    [[nodiscard]] auto isEnabled() const -> bool { return enabled; }
+
+    /**
+     * @brief Check if the index can answer queries
+     *
+     * @return True if enabled and built from a side with levels
+     */
+    [[nodiscard]] auto isBuilt() const -> bool { return !tree.empty(); }
+
+    /**
+     * @brief Get the shares resting at or below a price
+     *
+     * @param price Highest price to count
+     * @return Shares at prices <= price
+     * @warning Index must be enabled
+     */
+    [[nodiscard]] auto getDepthAtOrBelow(Price price) const -> Qty;
+
+    /**
+     * @brief Get the shares resting at or above a price
+     *
+     * @param price Lowest price to count
+     * @return Shares at prices >= price
+     * @warning Index must be enabled
+     */
+    [[nodiscard]] auto getDepthAtOrAbove(Price price) const -> Qty;
+
+    /**
+     * @brief Find how high a buyer must go to take a number of shares from the lowest price up
+     *
+     * @param shares Shares wanted
+     * @return Lowest price with at least shares resting at or below it, or std::nullopt if there aren't that many
+     *         or shares isn't positive
+     * @warning Index must be enabled
+     */
+    [[nodiscard]] auto findPriceFromBelow(Qty shares) const -> std::optional<Price>;
+
+    /**
+     * @brief Find how low a seller must go to take a number of shares from the highest price down
+     *
+     * @param shares Shares wanted
+     * @return Highest price with at least shares resting at or above it, or std::nullopt if there aren't that many
+     *         or shares isn't positive
+     * @warning Index must be enabled
+     */
+    [[nodiscard]] auto findPriceFromAbove(Qty shares) const -> std::optional<Price>;
+
+  private:
+    /**
+     * @brief Get the shares in the first count ticks of the window
+     *
+     * @param count Number of ticks from the bottom of the window, clamped to its width
+     * @return Sum of their shares
+     */
+    [[nodiscard]] auto sumOfFirst(std::int64_t count) const -> std::int64_t;
+
+    /**
+     * @brief Find the most ticks, from the bottom of the window, whose shares don't exceed a limit
+     *
+     * @param limit Most shares to cover
+     * @return Number of ticks
+     */
+    [[nodiscard]] auto countTicksWithin(std::int64_t limit) const -> std::size_t;
+
+    /// @brief Fenwick tree of raw Qty values, 1-indexed, sized to a power of two
+    std::vector<std::int64_t> tree;
+    /// @brief Price of the first tick of the window
+    Price base = 0;
+    std::int64_t total = 0;
+    bool enabled = true;
+};
+
+} // namespace Exchange
+
+#endif
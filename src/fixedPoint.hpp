@@ -0,0 +1,195 @@
+/**
+ * @file fixedPoint.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the strongly typed fixed-point Price, Qty and Notional types
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef FIXEDPOINT_HPP
+#define FIXEDPOINT_HPP
+
+#include <compare>
+#include <concepts>
+#include <cstdint>
+
+/// @brief Number of decimal places one price tick represents, e.g. 2 means a tick is 0.01
+#ifndef EXCHANGE_PRICE_DECIMALS
+#define EXCHANGE_PRICE_DECIMALS 2
+#endif
+
+/// @brief Number of decimal places one unit of quantity represents, 0 for whole shares
+#ifndef EXCHANGE_QTY_DECIMALS
+#define EXCHANGE_QTY_DECIMALS 0
+#endif
+
+namespace Exchange {
+
+/// @brief 128 bit integer, __extension__ keeps -Wpedantic quiet about the non-standard type
+__extension__ using Int128 = __int128;
+
+namespace Detail {
+
+/**
+ * @brief Compute 10^exponent at compile time
+ *
+ * @param exponent Non-negative power of ten
+ * @return 10^exponent
+ */
+constexpr auto powerOfTen(int exponent) -> std::int64_t {
+    std::int64_t result = 1;
+    for (int i = 0; i < exponent; ++i)
+        result *= 10;
+    return result;
+}
+
+} // namespace Detail
+
+/**
+ * @brief An integer count of some fixed-point unit, which can't be mixed up with counts of other units
+ *
+ * Implicitly constructible from a raw integer count, so literals work naturally, but never
+ * implicitly converted back out or into another FixedPoint type. Adding a Price to a Qty doesn't compile.
+ *
+ * @tparam Tag      Empty type making each instantiation distinct
+ * @tparam Rep      Underlying integer type
+ * @tparam Decimals Number of decimal places one raw unit represents
+ */
+template <typename Tag, typename Rep, int Decimals> struct FixedPoint {
+    /// @brief Number of raw units making up 1.0
+    static constexpr std::int64_t unitsPerWhole = Detail::powerOfTen(Decimals);
+
+    /**
+     * @brief Construct a zero value
+     *
+     */
+    constexpr FixedPoint() = default;
+
+    /**
+     * @brief Construct from a raw count of units (ticks for prices, lots for quantities)
+     *
+     * Only integers are accepted, doubles must go through fromDouble so rounding is explicit.
+     *
+     * @param raw Raw count of units
+     */
+    template <typename T>
+        requires std::integral<T> || std::same_as<T, Rep>
+    constexpr FixedPoint(T raw) noexcept : raw{static_cast<Rep>(raw)} {}
+
+    /**
+     * @brief Convert a decimal number to the nearest fixed-point value
+     *
+     * @param value Decimal value, e.g. 12.34 for a price
+     * @return Nearest FixedPoint value
+     */
+    [[nodiscard]] static constexpr auto fromDouble(double value) -> FixedPoint {
+        const double scaled = value * static_cast<double>(unitsPerWhole);
+        return FixedPoint{static_cast<Rep>(scaled < 0 ? scaled - 0.5 : scaled + 0.5)};
+    }
+
+    /**
+     * @brief Get the raw count of units
+     *
+     * @return Raw count
+     */
+    [[nodiscard]] constexpr auto value() const -> Rep { return raw; }
+
+    /**
+     * @brief Convert to a decimal number, for display only
+     *
+     * @return Decimal value
+     */
+    [[nodiscard]] constexpr auto toDouble() const -> double {
+        return static_cast<double>(raw) / static_cast<double>(unitsPerWhole);
+    }
+
+    /**
+     * @brief Compare two values of the same type
+     *
+     * @param rhs Value to compare against
+     * @return Ordering of the raw counts
+     */
+    constexpr auto operator<=>(const FixedPoint &rhs) const = default;
+
+    /**
+     * @brief Add another value of the same type to this one
+     *
+     * @param rhs Value to add
+     * @return Reference to this value
+     */
+    constexpr auto operator+=(FixedPoint rhs) -> FixedPoint & {
+        raw += rhs.raw;
+        return *this;
+    }
+
+    /**
+     * @brief Subtract another value of the same type from this one
+     *
+     * @param rhs Value to subtract
+     * @return Reference to this value
+     */
+    constexpr auto operator-=(FixedPoint rhs) -> FixedPoint & {
+        raw -= rhs.raw;
+        return *this;
+    }
+
+    /**
+     * @brief Add two values of the same type
+     *
+     * @param lhs Left operand
+     * @param rhs Right operand
+     * @return lhs + rhs
+     */
+    friend constexpr auto operator+(FixedPoint lhs, FixedPoint rhs) -> FixedPoint {
+        return lhs += rhs;
+    }
+
+    /**
+     * @brief Subtract two values of the same type
+     *
+     * @param lhs Left operand
+     * @param rhs Right operand
+     * @return lhs - rhs
+     */
+    friend constexpr auto operator-(FixedPoint lhs, FixedPoint rhs) -> FixedPoint {
+        return lhs -= rhs;
+    }
+
+  private:
+    Rep raw = 0;
+};
+
+/// @brief Tag for Price
+struct PriceTag {};
+/// @brief Tag for Qty
+struct QtyTag {};
+/// @brief Tag for Notional
+struct NotionalTag {};
+
+/// @brief Price counted in ticks of 10^-EXCHANGE_PRICE_DECIMALS
+using Price = FixedPoint<PriceTag, std::int64_t, EXCHANGE_PRICE_DECIMALS>;
+
+/// @brief Quantity counted in lots of 10^-EXCHANGE_QTY_DECIMALS shares
+using Qty = FixedPoint<QtyTag, std::int64_t, EXCHANGE_QTY_DECIMALS>;
+
+/// @brief Price * Qty, kept in 128 bits so sums over a whole trading day can't overflow
+using Notional =
+    FixedPoint<NotionalTag, Int128, EXCHANGE_PRICE_DECIMALS + EXCHANGE_QTY_DECIMALS>;
+
+/**
+ * @brief Multiply a price by a quantity without overflowing
+ *
+ * @param price     Price per unit
+ * @param quantity  Number of units
+ * @return Notional value, price * quantity widened to 128 bits
+ */
+constexpr auto operator*(Price price, Qty quantity) -> Notional {
+    return Notional{static_cast<Int128>(price.value()) * quantity.value()};
+}
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ * @file levelStoragePolicy.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Implements the choice between tree and ladder level storage
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "levelStoragePolicy.hpp"
+
+namespace Exchange {
+
+namespace {
+
+/// @brief Ticks per level below which a ladder is dense enough on its own
+constexpr std::int64_t denseTicksPerLevel = 8;
+
+/// @brief Ticks per level below which a ladder pays off if levels churn
+constexpr std::int64_t churnTicksPerLevel = 64;
+
+/// @brief Ticks per level above which a ladder is given up even though levels churn
+constexpr std::int64_t sparseTicksPerLevel = 256;
+
+} // namespace
+
+auto chooseLevelStorage(const LevelActivity &activity, std::size_t levelCount, std::int64_t priceWidth,
+                        LevelStorage current) -> LevelStorage {
+    if(levelCount == 0 || priceWidth > maxLadderTicks)
+        return LevelStorage::tree;
+
+    const auto levels = static_cast<std::int64_t>(levelCount);
+    // Levels churn if one in four events creates or destroys one, trades usually take out more than one,
+    // or most orders are cancelled rather than left to trade
+    const bool churns = 4 * static_cast<std::uint64_t>(activity.levelChanges) >= activity.getEvents() ||
+                        activity.levelsSwept > 2 * static_cast<std::uint64_t>(activity.sweeps) ||
+                        2 * static_cast<std::uint64_t>(activity.cancels) >= activity.adds;
+
+    if(priceWidth <= denseTicksPerLevel * levels)
+        return LevelStorage::ladder;
+    if(current == LevelStorage::ladder)
+        return priceWidth <= sparseTicksPerLevel * levels ? LevelStorage::ladder : LevelStorage::tree;
+    return churns && priceWidth <= churnTicksPerLevel * levels ? LevelStorage::ladder : LevelStorage::tree;
+}
+
+} // namespace Exchange
@@ -0,0 +1,94 @@
+/**
+ * @file levelStoragePolicy.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the activity statistics a book uses to pick how it stores its price levels
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef LEVELSTORAGEPOLICY_HPP
+#define LEVELSTORAGEPOLICY_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Exchange {
+
+/// @brief Where one side of a book keeps its price levels
+enum class LevelStorage : std::uint8_t {
+    /// @brief Sorted arrays inside the book, used while a side has only a few levels
+    inlineArrays,
+    /// @brief Tree keyed by price, for levels spread sparsely over a wide range
+    tree,
+    /// @brief Array indexed by price, for levels packed closely together
+    ladder
+};
+
+/// @brief Widest range of prices, in ticks, a ladder may cover. Bounds both its memory and the cost of moving to it.
+inline constexpr std::int64_t maxLadderTicks = std::int64_t{1} << 16;
+
+/// @brief Number of orders and cancels between two decisions on how to store levels
+inline constexpr std::uint32_t levelActivityWindow = 1024;
+
+/**
+ * @brief Counters a book keeps over one activity window, cheap enough to bump on every event
+ *
+ */
+struct LevelActivity {
+    /// @brief Orders added
+    std::uint32_t adds = 0;
+    /// @brief Orders cancelled
+    std::uint32_t cancels = 0;
+    /// @brief Added orders that traded
+    std::uint32_t sweeps = 0;
+    /// @brief Levels emptied by those trades
+    std::uint32_t levelsSwept = 0;
+    /// @brief Levels created or removed, for any reason
+    std::uint32_t levelChanges = 0;
+
+    /**
+     * @brief Get the number of events counted so far
+     *
+     * @return Adds plus cancels
+     */
+    [[nodiscard]] auto getEvents() const -> std::uint32_t { return adds + cancels; }
+};
+
+/**
+ * @brief Cost of every move a book has made between level storages
+ *
+ */
+struct LevelMigrationStats {
+    /// @brief Number of moves
+    std::uint64_t migrations = 0;
+    /// @brief Levels copied across all moves
+    std::uint64_t levelsMoved = 0;
+    /// @brief Time spent moving
+    std::int64_t totalNanoseconds = 0;
+    /// @brief Longest single move
+    std::int64_t maxNanoseconds = 0;
+};
+
+/**
+ * @brief Pick the storage one side of a book should use once it has more than a few levels
+ *
+ * A ladder turns every level insert and erase into a bit flip, and finds the next level with a bitmap scan,
+ * but costs memory for every tick in its range. It wins when levels are dense, or moderately dense and the book
+ * keeps creating and destroying them through sweeps and cancels. Otherwise the tree's memory is proportional
+ * to its levels. The current storage is kept unless the case against it is clear, so books don't flip back and forth.
+ *
+ * @param activity      Counters over the last window
+ * @param levelCount    Live levels on the side
+ * @param priceWidth    Ticks between the side's best and worst price, inclusive
+ * @param current       Large storage the side uses now, tree or ladder
+ * @return LevelStorage::tree or LevelStorage::ladder
+ */
+[[nodiscard]] auto chooseLevelStorage(const LevelActivity &activity, std::size_t levelCount, std::int64_t priceWidth,
+                                      LevelStorage current) -> LevelStorage;
+
+} // namespace Exchange
+
+#endif
@@ -10,58 +10,630 @@
  */
 
 #include "limitPrice.hpp"
-#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <numeric>
+#include <span>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 namespace Exchange {
 
-auto LimitPrice::addOrder(const Order &order) -> std::list<Order>::iterator {
-  if(order.getLimitPrice() != limitPrice)
-    throw std::invalid_argument("Tried adding order with differing limitPrice to limitPrice object");
+namespace {
+
+/// @brief Queues shorter than this are never compacted, it wouldn't save anything
+constexpr std::size_t minCompactionLength = 32;
+
+/// @brief Queues spanning fewer chunks than this answer position queries by walking them, without a depth tree
+constexpr std::uint32_t minDepthTreeChunks = 8;
+
+/**
+ * @brief Sum a depth tree over the chunks before a sequence number
+ *
+ * @param tree      Tree of a queue
+ * @param sequence  Sequence number of a chunk in the tree's range
+ * @return Live shares in chunks of the tree with a smaller sequence number
+ */
+auto sumChunksBefore(const QueueDepthTree &tree, std::uint32_t sequence) -> std::int64_t {
+  std::int64_t sum = 0;
+  for (std::size_t i = sequence - tree.base; i > 0; i -= i & (~i + 1))
+    sum += tree.sums[i];
+  return sum;
+}
+
+/**
+ * @brief Count how many entries, from the front, a number of shares consumes completely
+ *
+ * @param quantities  Raw resting quantities of consecutive queue entries, none negative
+ * @param shares      Shares available to fill them
+ * @return Largest count whose quantities sum to at most shares
+ */
+auto countFullyConsumed(std::span<const std::int64_t> quantities, std::int64_t shares) -> std::uint32_t {
+  std::uint32_t count = 0;
+  std::int64_t consumed = 0;
+
+#if defined(__AVX2__)
+  // Prefix sums four entries at a time. Quantities aren't negative, so the sums only grow
+  // and the first lane above shares is the first entry left standing.
+  const __m256i limit = _mm256_set1_epi64x(shares);
+  __m256i carry = _mm256_setzero_si256();
+  for (; count + 4 <= quantities.size(); count += 4) {
+    __m256i sums = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&quantities[count]));
+    sums = _mm256_add_epi64(sums, _mm256_blend_epi32(_mm256_permute4x64_epi64(sums, 0x90), _mm256_setzero_si256(), 0x03));
+    sums = _mm256_add_epi64(sums, _mm256_blend_epi32(_mm256_permute4x64_epi64(sums, 0x40), _mm256_setzero_si256(), 0x0F));
+    sums = _mm256_add_epi64(sums, carry);
+
+    const auto over = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(sums, limit))));
+    if (over != 0)
+      return count + static_cast<std::uint32_t>(std::countr_zero(over));
+    carry = _mm256_permute4x64_epi64(sums, 0xFF);
+  }
+  consumed = _mm256_extract_epi64(carry, 0);
+#endif
+
+  for (; count < quantities.size(); ++count) {
+    consumed += quantities[count];
+    if (consumed > shares)
+      break;
+  }
+  return count;
+}
+
+/// @brief Quantities below this convert between int64 and double exactly through the mantissa alone
+constexpr std::int64_t maxMantissaLots = std::int64_t{1} << 52;
+
+/**
+ * @brief Allocate shares in proportion to resting quantities, rounding down
+ *
+ * Each allocation is floor(quantity * shares / restingShares), exact while quantity * shares stays below 2^53.
+ * Past that the floor can be off by one either way, which callers absorb by capping the total.
+ *
+ * @param quantities      Raw resting quantities of consecutive queue entries, none negative
+ * @param shares          Raw shares to share out
+ * @param restingShares   Raw sum of the quantities of every entry sharing them, more than shares
+ * @param minAllocation   Raw allocations below this are dropped to 0
+ * @param fitsInMantissa  True if every quantity is below maxMantissaLots
+ * @param allocations     Raw allocation of each entry, the same size as quantities
+ * @return Sum of the allocations
+ */
+auto allocateProRata(std::span<const std::int64_t> quantities, double shares, double restingShares, std::int64_t minAllocation,
+                     bool fitsInMantissa, std::span<std::int64_t> allocations) -> std::int64_t {
+  std::size_t count = 0;
+  std::int64_t allocated = 0;
+
+#if defined(__AVX2__)
+  // AVX2 has no int64 <-> double conversion, but below 2^52 a value is its own mantissa bits under the exponent of 2^52
+  if (fitsInMantissa) {
+    const __m256i magicBits = _mm256_set1_epi64x(0x4330000000000000);
+    const __m256d magic = _mm256_castsi256_pd(magicBits);
+    const __m256d numerators = _mm256_set1_pd(shares);
+    const __m256d denominators = _mm256_set1_pd(restingShares);
+    const __m256i minimums = _mm256_set1_epi64x(minAllocation);
+    __m256i sums = _mm256_setzero_si256();
+    for (; count + 4 <= quantities.size(); count += 4) {
+      const __m256i resting = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&quantities[count]));
+      const __m256d exact = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(resting, magicBits)), magic);
+      const __m256d rounded = _mm256_floor_pd(_mm256_div_pd(_mm256_mul_pd(exact, numerators), denominators));
+      __m256i allocation = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(rounded, magic)), magicBits);
+      allocation = _mm256_andnot_si256(_mm256_cmpgt_epi64(minimums, allocation), allocation);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(&allocations[count]), allocation);
+      sums = _mm256_add_epi64(sums, allocation);
+    }
+    std::array<std::int64_t, 4> lanes{};
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes.data()), sums);
+    allocated = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  }
+#else
+  static_cast<void>(fitsInMantissa);
+#endif
+
+  // Truncating a non-negative quotient is the same floor as above, so both paths allocate identically
+  for (; count < quantities.size(); ++count) {
+    const auto allocation = static_cast<std::int64_t>(static_cast<double>(quantities[count]) * shares / restingShares);
+    allocations[count] = allocation < minAllocation ? 0 : allocation;
+    allocated += allocations[count];
+  }
+  return allocated;
+}
+
+/**
+ * @brief Take shares in time priority from consecutive queue entries, leaving the rest of each for pro rata
+ *
+ * @param quantities  Raw resting quantities of the entries
+ * @param fifoLeft    Shares still to take in time priority, reduced by what was taken
+ * @param taken       Raw shares taken from each entry
+ * @param remaining   Raw shares each entry has left
+ */
+void takeInTimePriority(std::span<const std::int64_t> quantities, std::int64_t &fifoLeft,
+                        std::span<std::int64_t> taken, std::span<std::int64_t> remaining) {
+  for (std::size_t i = 0; i < quantities.size(); ++i) {
+    taken[i] = std::min(quantities[i], fifoLeft);
+    fifoLeft -= taken[i];
+    remaining[i] = quantities[i] - taken[i];
+  }
+}
+
+} // namespace
+
+auto LimitPrice::addOrder(OrderPool &pool, OrderSlot slot) -> Result<void> {
+  if (pool.getCold(slot).limitPrice != limitPrice)
+    return reject(RejectReason::priceMismatch);
+
+  ChunkPool &chunks = pool.getQueueChunks();
+  if (tailChunk == noChunk || tailOffset == chunkCapacity) {
+    const ChunkIndex chunk = chunks.allocate();
+    if (tailChunk == noChunk) {
+      headChunk = chunk;
+      tailSequence = 0;
+    } else {
+      chunks.setNext(tailChunk, chunk);
+      ++tailSequence;
+    }
+    chunks.setSequence(chunk, tailSequence);
+    tailChunk = chunk;
+    tailOffset = 0;
+  }
+
+  const std::uint32_t position = tailChunk * chunkCapacity + tailOffset++;
+  HotOrder &order = pool.getHot(slot);
+  chunks.getEntry(position) = slot;
+  chunks.getQuantity(position) = order.shares.value();
+  ++queueLength;
 
-  limitOrders.emplace_back(order);
-  depth += order.getShares();
-  return --limitOrders.end();
+  order.position = position;
+  depth += order.shares;
+  if ((order.flags & OrderFlags::hidden) != 0)
+    hiddenDepth += order.shares;
+  updateDepthTree(chunks, tailChunk, order.shares.value());
+  return {};
 }
 
-auto LimitPrice::removeOrder(std::list<Order>::const_iterator pos)
-    -> OrderType {
-  OrderType type = pos->getOrderType();
-  depth -= pos->getShares();
-  limitOrders.erase(pos);
+void LimitPrice::removeOrder(OrderPool &pool, OrderSlot slot) {
+  const HotOrder &order = pool.getHot(slot);
+  ChunkPool &chunks = pool.getQueueChunks();
+  chunks.getEntry(order.position) = noSlot;
+  chunks.getQuantity(order.position) = 0;
+  ++tombstones;
+  depth -= order.shares;
+  if ((order.flags & OrderFlags::hidden) != 0)
+    hiddenDepth -= order.shares;
+  updateDepthTree(chunks, order.position / chunkCapacity, (Qty{0} - order.shares).value());
 
-  return type;
+  compactIfMostlyDead(pool);
 }
 
 auto LimitPrice::isEmpty() const -> bool { return depth == 0; }
 
-auto LimitPrice::getVolume() const -> int { return volume; }
+auto LimitPrice::getPrice() const -> Price { return limitPrice; }
+
+auto LimitPrice::getDepth() const -> Qty { return depth; }
+
+auto LimitPrice::getQueueLength() const -> std::size_t { return queueLength; }
 
-auto LimitPrice::getPrice() const -> int { return limitPrice; }
+auto LimitPrice::getSharesAhead(const OrderPool &pool, OrderSlot slot) const -> Qty {
+  const ChunkPool &chunks = pool.getQueueChunks();
+  const std::uint32_t position = pool.getHot(slot).position;
+  const ChunkIndex chunk = position / chunkCapacity;
 
-auto LimitPrice::getDepth() const -> int { return depth; }
+  const auto &quantities = chunks.getQuantities(chunk).shares;
+  const std::uint32_t start = chunk == headChunk ? headOffset : 0;
+  std::int64_t ahead = std::accumulate(quantities.begin() + start, quantities.begin() + position % chunkCapacity,
+                                       std::int64_t{0});
+  if (chunk == headChunk)
+    return ahead;
 
-auto LimitPrice::executeNumberOfShares(int baseOrderId, int numShares)
-    -> OrderExecution {
+  if (depthTree != noDepthTree) {
+    const QueueDepthTree &tree = chunks.getDepthTree(depthTree);
+    return ahead + sumChunksBefore(tree, chunks.getSequence(chunk)) - sumChunksBefore(tree, chunks.getSequence(headChunk));
+  }
+
+  for (ChunkIndex before = headChunk; before != chunk; before = chunks.getNext(before))
+    ahead += getChunkShares(chunks, before);
+  return ahead;
+}
+
+auto LimitPrice::executeNumberOfShares(OrderPool &pool, int baseOrderId,
+                                       Qty numShares)
+    -> Result<OrderExecution> {
+  return executeNumberOfShares(pool, baseOrderId, numShares, limitPrice);
+}
+
+auto LimitPrice::executeNumberOfShares(OrderPool &pool, int baseOrderId, Qty numShares, Price tradePrice,
+                                       SelfTradePrevention selfTradePrevention, std::uint32_t accountId,
+                                       RestingRisk risk) -> Result<OrderExecution> {
   if (numShares > depth)
-    throw std::invalid_argument(
-        "Can't execute more shares in LimitPrice than exist in depth");
+    return reject(RejectReason::insufficientDepth);
 
+  ChunkPool &chunks = pool.getQueueChunks();
   OrderExecution totalOrderExecution(baseOrderId);
+  const bool preventsSelfTrades = selfTradePrevention != SelfTradePrevention::none && accountId != noAccount;
+
+  // Plan each chunk's fill from its quantities alone, then emit and pop every fully consumed order at once
+  std::array<int, chunkCapacity> filledIds{};
+  while (numShares > 0 && queueLength > 0) {
+    const auto &slots = chunks.getChunk(headChunk).slots;
+    auto &quantities = chunks.getQuantities(headChunk).shares;
+    const std::uint32_t end = headChunk == tailChunk ? tailOffset : chunkCapacity;
 
-  while (numShares > 0) {
-    Order &frontOrder = limitOrders.front();
-    OrderExecution firstOrderExec = frontOrder.execute(baseOrderId, numShares);
-    numShares -= firstOrderExec.getTotalSharesExecuted();
-    totalOrderExecution += firstOrderExec;
+    const std::uint32_t consumed =
+        countFullyConsumed(std::span{quantities}.subspan(headOffset, end - headOffset), numShares.value());
+    std::uint32_t numFilled = 0;
+    Qty filledShares = 0;
+    std::uint32_t offset = headOffset;
+    for (; offset < headOffset + consumed; ++offset) {
+      const OrderSlot slot = slots[offset];
+      if (slot == noSlot) {
+        --tombstones;
+        continue;
+      }
+      // The plan ends at the first order of the base order's own account, decided by this one compare per order
+      const HotOrder &order = pool.getHot(slot);
+      if (preventsSelfTrades && order.accountId == accountId) [[unlikely]]
+        break;
+      if ((order.flags & OrderFlags::hidden) != 0) [[unlikely]]
+        hiddenDepth -= quantities[offset];
+      filledIds[numFilled++] = order.orderId;
+      filledShares += quantities[offset];
+      if (risk.ledger != nullptr)
+        risk.ledger->fill(order.accountId, risk.side, quantities[offset], limitPrice);
+      pool.release(slot);
+    }
+    totalOrderExecution.addFullFills(tradePrice, filledShares, std::span{filledIds}.first(numFilled));
+    numShares -= filledShares;
+    depth -= filledShares;
+    Qty chunkShares = filledShares;
 
-    if (frontOrder.getShares() == 0)
-      limitOrders.pop_front();
+    queueLength -= offset - headOffset;
+    headOffset = offset;
+
+    // Whatever is left is less than the next order, so that one is only partially filled, unless it's our own
+    if (headOffset < end && numShares > 0) {
+      HotOrder &order = pool.getHot(slots[headOffset]);
+      if (preventsSelfTrades && order.accountId == accountId) [[unlikely]] {
+        chunkShares += preventSelfTrade(pool, selfTradePrevention, numShares, totalOrderExecution, risk);
+      } else {
+        totalOrderExecution.addFill(order.orderId, tradePrice, numShares, false);
+        if (risk.ledger != nullptr)
+          risk.ledger->fill(order.accountId, risk.side, numShares, limitPrice);
+        if ((order.flags & OrderFlags::hidden) != 0) [[unlikely]]
+          hiddenDepth -= numShares;
+        order.shares -= numShares;
+        quantities[headOffset] -= numShares.value();
+        depth -= numShares;
+        chunkShares += numShares;
+        numShares = 0;
+      }
+    }
+
+    if (depthTree != noDepthTree)
+      updateDepthTree(chunks, headChunk, (Qty{0} - chunkShares).value());
+    if (headOffset == chunkCapacity)
+      popHeadChunk(chunks);
   }
 
-  volume += totalOrderExecution.getTotalSharesExecuted();
-  depth -= totalOrderExecution.getTotalSharesExecuted();
+  compactIfMostlyDead(pool);
 
   return totalOrderExecution;
 }
 
+auto LimitPrice::preventSelfTrade(OrderPool &pool, SelfTradePrevention selfTradePrevention, Qty &numShares,
+                                  OrderExecution &execution, RestingRisk risk) -> Qty {
+  ChunkPool &chunks = pool.getQueueChunks();
+  const OrderSlot slot = chunks.getChunk(headChunk).slots[headOffset];
+  HotOrder &order = pool.getHot(slot);
+
+  Qty restingCancelled = order.shares;
+  Qty baseCancelled = numShares;
+  if (selfTradePrevention == SelfTradePrevention::cancelNewest)
+    restingCancelled = 0;
+  else if (selfTradePrevention == SelfTradePrevention::cancelOldest)
+    baseCancelled = 0;
+  else if (selfTradePrevention == SelfTradePrevention::decrement)
+    restingCancelled = baseCancelled = std::min(order.shares, numShares);
+
+  execution.cancelShares(baseCancelled);
+  numShares -= baseCancelled;
+  depth -= restingCancelled;
+  if ((order.flags & OrderFlags::hidden) != 0)
+    hiddenDepth -= restingCancelled;
+  if (restingCancelled == 0)
+    return restingCancelled;
+
+  const bool cancelledCompletely = restingCancelled == order.shares;
+  execution.addSelfTradeCancel(order.orderId, restingCancelled, cancelledCompletely);
+  if (risk.ledger != nullptr)
+    risk.ledger->release(order.accountId, risk.side, restingCancelled, limitPrice);
+  if (!cancelledCompletely) {
+    order.shares -= restingCancelled;
+    chunks.getQuantities(headChunk).shares[headOffset] -= restingCancelled.value();
+    return restingCancelled;
+  }
+
+  // At the head, so it's popped like a fill rather than leaving a tombstone
+  pool.release(slot);
+  chunks.getQuantities(headChunk).shares[headOffset] = 0;
+  ++headOffset;
+  --queueLength;
+  return restingCancelled;
+}
+
+auto LimitPrice::executeProRata(OrderPool &pool, int baseOrderId, Qty numShares, const MatchingRules &rules)
+    -> Result<OrderExecution> {
+  return executeProRata(pool, baseOrderId, numShares, rules, limitPrice);
+}
+
+auto LimitPrice::executeProRata(OrderPool &pool, int baseOrderId, Qty numShares, const MatchingRules &rules,
+                                Price tradePrice, RestingRisk risk) -> Result<OrderExecution> {
+  // Taking the whole level fills everyone whatever the rules, time priority only orders the report
+  if (numShares >= depth)
+    return executeNumberOfShares(pool, baseOrderId, numShares, tradePrice, SelfTradePrevention::none, noAccount,
+                                 risk);
+
+  ChunkPool &chunks = pool.getQueueChunks();
+  ProRataPlan plan = planProRata(chunks, numShares, rules);
+  OrderExecution totalOrderExecution(baseOrderId);
+  depth -= numShares;
+
+  std::array<std::int64_t, chunkCapacity> allocations{};
+  std::array<int, chunkCapacity> filledIds{};
+  for (ChunkIndex chunk = headChunk; chunk != noChunk && plan.isAllocating(); chunk = chunks.getNext(chunk)) {
+    const auto [start, end] = allocateChunk(chunks, chunk, plan, allocations);
+    auto &slots = chunks.getChunk(chunk).slots;
+    auto &quantities = chunks.getQuantities(chunk).shares;
+
+    std::uint32_t numFilled = 0;
+    std::int64_t filledShares = 0;
+    std::int64_t chunkShares = 0;
+    for (std::uint32_t offset = start; offset < end; ++offset) {
+      const std::int64_t allocation = allocations[offset];
+      if (allocation == 0)
+        continue;
+      chunkShares += allocation;
+
+      HotOrder &order = pool.getHot(slots[offset]);
+      if ((order.flags & OrderFlags::hidden) != 0) [[unlikely]]
+        hiddenDepth -= allocation;
+      if (risk.ledger != nullptr)
+        risk.ledger->fill(order.accountId, risk.side, allocation, limitPrice);
+      if (allocation < quantities[offset]) {
+        totalOrderExecution.addFill(order.orderId, tradePrice, allocation, false);
+        order.shares -= allocation;
+        quantities[offset] -= allocation;
+        continue;
+      }
+
+      // Filled away from the head, so it leaves a tombstone like a cancel
+      filledIds[numFilled++] = order.orderId;
+      filledShares += allocation;
+      pool.release(slots[offset]);
+      slots[offset] = noSlot;
+      quantities[offset] = 0;
+      ++tombstones;
+    }
+    totalOrderExecution.addFullFills(tradePrice, filledShares, std::span{filledIds}.first(numFilled));
+
+    if (depthTree != noDepthTree)
+      updateDepthTree(chunks, chunk, -chunkShares);
+  }
+
+  popLeadingTombstones(chunks);
+  compactIfMostlyDead(pool);
+
+  return totalOrderExecution;
+}
+
+auto LimitPrice::planProRata(const ChunkPool &chunks, Qty numShares, const MatchingRules &rules) const
+    -> ProRataPlan {
+  const std::int64_t shares = numShares.value();
+
+  // The top order is simply the first one taken in time priority
+  std::int64_t topShares = 0;
+  if (rules.topOrderPriority) {
+    std::uint32_t offset = headOffset;
+    for (ChunkIndex chunk = headChunk; chunk != noChunk && topShares == 0; chunk = chunks.getNext(chunk), offset = 0) {
+      const auto &quantities = chunks.getQuantities(chunk).shares;
+      const std::uint32_t end = chunk == tailChunk ? tailOffset : chunkCapacity;
+      for (; offset < end && topShares == 0; ++offset)
+        topShares = std::min(quantities[offset], shares);
+    }
+  }
+
+  // Split as quotient and remainder, so a percentage of any fill fits in 64 bits
+  const std::int64_t afterTop = shares - topShares;
+  const std::int64_t fifoShares = topShares + afterTop / 100 * rules.fifoPercent + afterTop % 100 * rules.fifoPercent / 100;
+  const std::int64_t proRataShares = shares - fifoShares;
+
+  ProRataPlan plan;
+  plan.fifoLeft = fifoShares;
+  plan.shares = static_cast<double>(proRataShares);
+  plan.restingShares = static_cast<double>(depth.value() - fifoShares);
+  plan.minAllocation = std::max<std::int64_t>(rules.minAllocation.value(), 1);
+  plan.proRataLeft = proRataShares;
+  plan.fitsInMantissa = depth.value() < maxMantissaLots;
+
+  // Allocating is cheap enough to run twice, once here to learn how much rounding leaves over
+  ProRataPlan dryRun = plan;
+  std::array<std::int64_t, chunkCapacity> allocations{};
+  std::int64_t allocated = 0;
+  for (ChunkIndex chunk = headChunk; chunk != noChunk; chunk = chunks.getNext(chunk)) {
+    const auto [start, end] = allocateChunk(chunks, chunk, dryRun, allocations);
+    allocated += std::accumulate(allocations.begin() + start, allocations.begin() + end, std::int64_t{0});
+  }
+  plan.leftoverLeft = shares - allocated;
+  return plan;
+}
+
+auto LimitPrice::allocateChunk(const ChunkPool &chunks, ChunkIndex chunk, ProRataPlan &plan,
+                               std::array<std::int64_t, chunkCapacity> &allocations) const
+    -> std::pair<std::uint32_t, std::uint32_t> {
+  const auto &quantities = chunks.getQuantities(chunk).shares;
+  const std::uint32_t start = chunk == headChunk ? headOffset : 0;
+  const std::uint32_t end = chunk == tailChunk ? tailOffset : chunkCapacity;
+  const auto entries = std::span{quantities}.subspan(start, end - start);
+  const auto allocated = std::span{allocations}.subspan(start, end - start);
+
+  // Past the time priority stage, and with nothing rounded away to hand out, the kernel's allocation is final
+  if (plan.fifoLeft == 0) {
+    const std::int64_t proRata =
+        allocateProRata(entries, plan.shares, plan.restingShares, plan.minAllocation, plan.fitsInMantissa, allocated);
+    if (plan.leftoverLeft == 0 && proRata <= plan.proRataLeft) {
+      plan.proRataLeft -= proRata;
+      return {start, end};
+    }
+  }
+
+  std::array<std::int64_t, chunkCapacity> taken{};
+  std::array<std::int64_t, chunkCapacity> remaining{};
+  takeInTimePriority(entries, plan.fifoLeft, std::span{taken}.first(entries.size()),
+                     std::span{remaining}.first(entries.size()));
+  allocateProRata(std::span{remaining}.first(entries.size()), plan.shares, plan.restingShares, plan.minAllocation, plan.fitsInMantissa,
+                  allocated);
+
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    const std::int64_t proRata = std::min(allocated[i], plan.proRataLeft);
+    plan.proRataLeft -= proRata;
+    const std::int64_t leftover = std::min(remaining[i] - proRata, plan.leftoverLeft);
+    plan.leftoverLeft -= leftover;
+    allocated[i] = taken[i] + proRata + leftover;
+  }
+  return {start, end};
+}
+
+void LimitPrice::popLeadingTombstones(ChunkPool &chunks) {
+  while (chunks.getEntry(headChunk * chunkCapacity + headOffset) == noSlot) {
+    --tombstones;
+    --queueLength;
+    if (++headOffset == chunkCapacity)
+      popHeadChunk(chunks);
+  }
+}
+
+void LimitPrice::popHeadChunk(ChunkPool &chunks) {
+  const ChunkIndex nextChunk = chunks.getNext(headChunk);
+  chunks.release(headChunk);
+  headChunk = nextChunk;
+  headOffset = 0;
+
+  if (headChunk == noChunk)
+    tailChunk = noChunk;
+}
+
+void LimitPrice::compactIfMostlyDead(OrderPool &pool) {
+  ChunkPool &chunks = pool.getQueueChunks();
+
+  // An empty level is about to be removed, hand its chunks back
+  if (depth == 0) {
+    for (ChunkIndex chunk = headChunk; chunk != noChunk;) {
+      const ChunkIndex nextChunk = chunks.getNext(chunk);
+      chunks.release(chunk);
+      chunk = nextChunk;
+    }
+    headChunk = tailChunk = noChunk;
+    headOffset = tailOffset = queueLength = tombstones = 0;
+    if (depthTree != noDepthTree) {
+      chunks.releaseDepthTree(depthTree);
+      depthTree = noDepthTree;
+    }
+    return;
+  }
+
+  // Compacting costs one pass over the queue, paid for by at least half of it being dead
+  if (queueLength < minCompactionLength || tombstones * 2 < queueLength)
+    return;
+
+  // Slide live entries towards the head, writing never overtakes reading so it can be done in place
+  ChunkIndex readChunk = headChunk;
+  ChunkIndex writeChunk = headChunk;
+  std::uint32_t readOffset = headOffset;
+  std::uint32_t writeOffset = 0;
+  std::uint32_t liveEntries = 0;
+
+  for (std::uint32_t i = 0; i < queueLength; ++i) {
+    const OrderSlot slot = chunks.getEntry(readChunk * chunkCapacity + readOffset);
+    if (++readOffset == chunkCapacity) {
+      readChunk = chunks.getNext(readChunk);
+      readOffset = 0;
+    }
+    if (slot == noSlot)
+      continue;
+
+    if (writeOffset == chunkCapacity) {
+      writeChunk = chunks.getNext(writeChunk);
+      writeOffset = 0;
+    }
+    const std::uint32_t position = writeChunk * chunkCapacity + writeOffset++;
+    chunks.getEntry(position) = slot;
+    chunks.getQuantity(position) = pool.getHot(slot).shares.value();
+    pool.getHot(slot).position = position;
+    ++liveEntries;
+  }
+
+  for (ChunkIndex chunk = chunks.getNext(writeChunk); chunk != noChunk;) {
+    const ChunkIndex nextChunk = chunks.getNext(chunk);
+    chunks.release(chunk);
+    chunk = nextChunk;
+  }
+  chunks.setNext(writeChunk, noChunk);
+
+  tailChunk = writeChunk;
+  tailOffset = writeOffset;
+  tailSequence = chunks.getSequence(writeChunk);
+  headOffset = 0;
+  queueLength = liveEntries;
+  tombstones = 0;
+
+  // Surviving chunks kept their sequence numbers, but every chunk's shares moved
+  if (depthTree != noDepthTree)
+    rebuildDepthTree(chunks);
+}
+
+auto LimitPrice::getChunkShares(const ChunkPool &chunks, ChunkIndex chunk) const -> std::int64_t {
+  const auto &quantities = chunks.getQuantities(chunk).shares;
+  const std::uint32_t start = chunk == headChunk ? headOffset : 0;
+  const std::uint32_t end = chunk == tailChunk ? tailOffset : chunkCapacity;
+  return std::accumulate(quantities.begin() + start, quantities.begin() + end, std::int64_t{0});
+}
+
+void LimitPrice::updateDepthTree(ChunkPool &chunks, ChunkIndex chunk, std::int64_t delta) {
+  if (depthTree == noDepthTree) {
+    if (queueLength >= minDepthTreeChunks * chunkCapacity) {
+      depthTree = chunks.allocateDepthTree();
+      rebuildDepthTree(chunks);
+    }
+    return;
+  }
+
+  // A chunk past the end of the tree is new, rebasing on the head also drops the popped chunks' zeros
+  QueueDepthTree &tree = chunks.getDepthTree(depthTree);
+  const std::size_t index = chunks.getSequence(chunk) - tree.base + 1;
+  if (index >= tree.sums.size()) {
+    rebuildDepthTree(chunks);
+    return;
+  }
+
+  for (std::size_t i = index; i < tree.sums.size(); i += i & (~i + 1))
+    tree.sums[i] += delta;
+}
+
+void LimitPrice::rebuildDepthTree(ChunkPool &chunks) {
+  // Room for the queue to double before the next rebuild, keeping rebuilds amortised O(1) per added chunk
+  QueueDepthTree &tree = chunks.getDepthTree(depthTree);
+  tree.base = chunks.getSequence(headChunk);
+  const std::uint32_t chunkCount = tailSequence - tree.base + 1;
+  tree.sums.assign(std::bit_ceil(2 * chunkCount) + 1, 0);
+
+  for (ChunkIndex chunk = headChunk; chunk != noChunk; chunk = chunks.getNext(chunk))
+    tree.sums[chunks.getSequence(chunk) - tree.base + 1] = getChunkShares(chunks, chunk);
+
+  // Linear build, each node passes its sum up to its parent
+  for (std::size_t i = 1; i < tree.sums.size(); ++i) {
+    const std::size_t parent = i + (i & (~i + 1));
+    if (parent < tree.sums.size())
+      tree.sums[parent] += tree.sums[i];
+  }
+}
+
 } // namespace Exchange
\ No newline at end of file
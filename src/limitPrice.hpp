@@ -12,14 +12,37 @@
 #ifndef LIMITPRICE_HPP
 #define LIMITPRICE_HPP
 
-#include "order.hpp"
-#include <list>
+#include "matchingRules.hpp"
+#include "orderPool.hpp"
+#include "result.hpp"
+#include "riskLedger.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 
 namespace Exchange {
 
+/**
+ * @brief Where a level settles the risk of its resting orders as they trade or are cancelled
+ *
+ * Settled inside the fill loop, while each order's record is still live, as fully filled orders are released from
+ * the pool there.
+ */
+struct RestingRisk {
+    /// @brief Ledger the orders were reserved in, nullptr to settle nothing
+    RiskLedger *ledger = nullptr;
+    /// @brief Side the level's orders rest on
+    OrderType side = OrderType::buy;
+};
+
 /**
  * @brief The Limit Price struct, which holds information for all orders at a given limit price
  * 
+ * Orders are kept in time priority as a queue of OrderPool slots, built from cache line sized chunks shared by
+ * every level of the book. Cancelling only leaves a tombstone in the queue, which fills skip over, and the queue
+ * is compacted once most of it is dead. Once the queue spans several chunks, it takes a depth tree from the pool,
+ * a Fenwick tree over its chunks' shares that answers how many shares are ahead of an order without walking the queue.
  */
 struct LimitPrice {
     /**
@@ -27,25 +50,25 @@ struct LimitPrice {
      * 
      * @param limitPrice Price of the limitPrice object to keep track off
      */
-    explicit LimitPrice(int limitPrice) : limitPrice{limitPrice} {}
+    explicit LimitPrice(Price limitPrice) : limitPrice{limitPrice} {}
     
     /**
      * @brief Adds an order to the end of the given limitPrice
      * 
-     * @param order Order object to insert into this limitPrice
-     * @return std::list<Order>::iterator to inserted object
-     * @throws std::invalid_argument if order object's price is not equal to this limitPrice
+     * @param pool Pool the order is stored in
+     * @param slot Slot of the order to link into this limitPrice
+     * @return Nothing on success, or RejectReason::priceMismatch if the order's price is not equal to this limitPrice
      */
-    auto addOrder(const Order &order) -> std::list<Order>::iterator;
+    auto addOrder(OrderPool &pool, OrderSlot slot) -> Result<void>;
 
     /**
-     * @brief Removes an order from the limitPrice object
+     * @brief Removes an order from the limitPrice object in O(1), without releasing its slot
      * 
-     * @param pos Iterator to the position to remove
-     * @return The type of the order removed.
-     * @warning Doesn't check to ensure iterator is valid
+     * @param pool Pool the order is stored in
+     * @param slot Slot of the order to remove
+     * @warning Doesn't check that the order is in this limitPrice
      */
-    auto removeOrder(std::list<Order>::const_iterator pos) -> OrderType;
+    void removeOrder(OrderPool &pool, OrderSlot slot);
 
     /**
      * @brief Check if limitPrice has any orders in it
@@ -55,42 +78,290 @@ struct LimitPrice {
     [[nodiscard]] auto isEmpty() const -> bool;
 
     /**
-     * @brief Get the volume of all transactions that have occurred in shares
+     * @brief Get the price of this LimitPrice object
+     * 
+     * @return This LimitPrice's price
+     */
+    [[nodiscard]] auto getPrice() const -> Price;
+
+    /**
+     * @brief Get the number of shares available in this limitPrice
      * 
      * @return Number of shares 
      */
-    [[nodiscard]] auto getVolume() const -> int;
+    [[nodiscard]] auto getDepth() const -> Qty;
 
     /**
-     * @brief Get the price of this LimitPrice object
+     * @brief Get the number of shares this limitPrice shows in published depth
      * 
-     * @return This LimitPrice's price
+     * @return Number of shares of orders that aren't hidden
      */
-    [[nodiscard]] auto getPrice() const -> int;
+    [[nodiscard]] auto getDisplayedDepth() const -> Qty { return depth - hiddenDepth; }
 
     /**
-     * @brief Get the number of shares available in this limitPrice
+     * @brief Get the number of queue entries, live or dead, that haven't been compacted away
      * 
-     * @return Number of shares 
+     * @return Number of entries
+     */
+    [[nodiscard]] auto getQueueLength() const -> std::size_t;
+
+    /**
+     * @brief Get the number of live orders
+     * 
+     * @return Queue entries that aren't tombstones
+     */
+    [[nodiscard]] auto getOrderCount() const -> std::size_t { return queueLength - tombstones; }
+
+    /**
+     * @brief Get the shares queued ahead of an order, in O(log n) for long queues
+     * 
+     * @param pool Pool the order is stored in
+     * @param slot Slot of an order resting in this limitPrice
+     * @return Resting shares of every live order with better time priority
+     * @warning Doesn't check that the order is in this limitPrice
      */
-    [[nodiscard]] auto getDepth() const -> int;
+    [[nodiscard]] auto getSharesAhead(const OrderPool &pool, OrderSlot slot) const -> Qty;
 
     /**
-     * @brief Will execute a certain number of shares at this price, modifying orders, and deleting fully executed orders.
+     * @brief Visit live orders in time priority without changing anything
      * 
+     * @param pool  Pool the orders are stored in
+     * @param visit Called with the HotOrder of each order, returns false to stop
+     */
+    template <typename Visitor> void visitOrders(const OrderPool &pool, Visitor &&visit) const {
+      const ChunkPool &chunks = pool.getQueueChunks();
+      std::uint32_t offset = headOffset;
+      for (ChunkIndex chunk = headChunk; chunk != noChunk; chunk = chunks.getNext(chunk), offset = 0) {
+        const auto &slots = chunks.getChunk(chunk).slots;
+        const std::uint32_t end = chunk == tailChunk ? tailOffset : chunkCapacity;
+        for (; offset < end; ++offset) {
+          if (slots[offset] == noSlot)
+            continue;
+          if (!visit(pool.getHot(slots[offset])))
+            return;
+        }
+      }
+    }
+
+    /**
+     * @brief Will execute a certain number of shares at this price, modifying orders, and releasing fully executed orders.
+     * 
+     * @param pool Pool the orders are stored in
+     * @param baseOrderId The base order that is trying to be filled here
+     * @param numShares Number of shares to fulfill
+     * @return OrderExecution object with shares executed information, or RejectReason::insufficientDepth
+     *         if numShares is more than the depth of the limit, in which case nothing is executed
+     */
+    auto executeNumberOfShares(OrderPool &pool, int baseOrderId, Qty numShares)
+        -> Result<OrderExecution>;
+
+    /**
+     * @brief Will execute a certain number of shares, reporting the trades at another price than this limitPrice's,
+     *        and keeping the base order from trading with its own account's orders
+     * 
+     * A resting order of the base order's account is cancelled or decremented by selfTradePrevention instead of
+     * trading, so fewer than numShares may trade. Cancels are reported in the execution.
+     * 
+     * @param pool Pool the orders are stored in
      * @param baseOrderId The base order that is trying to be filled here
      * @param numShares Number of shares to fulfill
-     * @return OrderExecution object with shares executed information
-     * @warning Will not accept more shares than exist depth in the limit
+     * @param tradePrice Price every trade happens at, such as an auction's uncrossing price
+     * @param selfTradePrevention What the base order does on meeting its own account, none to trade anyway
+     * @param accountId Account of the base order, noAccount never prevents a trade
+     * @param risk Ledger to settle the resting orders' fills and cancels in, at this limitPrice
+     * @return OrderExecution object with shares executed information, or RejectReason::insufficientDepth
+     *         if numShares is more than the depth of the limit, in which case nothing is executed
      */
-    auto executeNumberOfShares(int baseOrderId, int numShares)
-        -> OrderExecution;
+    auto executeNumberOfShares(OrderPool &pool, int baseOrderId, Qty numShares, Price tradePrice,
+                               SelfTradePrevention selfTradePrevention = SelfTradePrevention::none,
+                               std::uint32_t accountId = noAccount, RestingRisk risk = {}) -> Result<OrderExecution>;
+
+    /**
+     * @brief Will execute a certain number of shares at this price shared out pro rata, modifying orders, and releasing
+     *        fully executed orders
+     * 
+     * @param pool Pool the orders are stored in
+     * @param baseOrderId The base order that is trying to be filled here
+     * @param numShares Number of shares to fulfill
+     * @param rules Pro-rata variant to allocate by, the algorithm itself isn't checked
+     * @return OrderExecution object with shares executed information, where every order left partially filled
+     *         is reported, or RejectReason::insufficientDepth if numShares is more than the depth of the limit,
+     *         in which case nothing is executed
+     */
+    auto executeProRata(OrderPool &pool, int baseOrderId, Qty numShares, const MatchingRules &rules)
+        -> Result<OrderExecution>;
+
+    /**
+     * @brief Will execute a certain number of shares shared out pro rata, reporting the trades at another price
+     *        than this limitPrice's
+     * 
+     * @param pool Pool the orders are stored in
+     * @param baseOrderId The base order that is trying to be filled here
+     * @param numShares Number of shares to fulfill
+     * @param rules Pro-rata variant to allocate by, the algorithm itself isn't checked
+     * @param tradePrice Price every trade happens at, such as an auction's uncrossing price
+     * @param risk Ledger to settle the resting orders' fills in, at this limitPrice
+     * @return OrderExecution object with shares executed information, or RejectReason::insufficientDepth
+     *         if numShares is more than the depth of the limit, in which case nothing is executed
+     */
+    auto executeProRata(OrderPool &pool, int baseOrderId, Qty numShares, const MatchingRules &rules, Price tradePrice,
+                        RestingRisk risk = {}) -> Result<OrderExecution>;
+
+    /**
+     * @brief Visit the fills executeProRata would make, without changing anything
+     * 
+     * @param pool      Pool the orders are stored in
+     * @param numShares Number of shares to fulfill, less than the depth of the limit
+     * @param rules     Pro-rata variant to allocate by
+     * @param visit     Called in time priority with the id of each order that would trade, its shares traded,
+     *                  and whether that fills it completely
+     */
+    template <typename Visitor>
+    void visitProRataFills(const OrderPool &pool, Qty numShares, const MatchingRules &rules, Visitor &&visit) const {
+      const ChunkPool &chunks = pool.getQueueChunks();
+      ProRataPlan plan = planProRata(chunks, numShares, rules);
+      std::array<std::int64_t, chunkCapacity> allocations{};
+      for (ChunkIndex chunk = headChunk; chunk != noChunk && plan.isAllocating(); chunk = chunks.getNext(chunk)) {
+        const auto [start, end] = allocateChunk(chunks, chunk, plan, allocations);
+        const auto &slots = chunks.getChunk(chunk).slots;
+        const auto &quantities = chunks.getQuantities(chunk).shares;
+        for (std::uint32_t offset = start; offset < end; ++offset)
+          if (allocations[offset] > 0)
+            visit(pool.getHot(slots[offset]).orderId, Qty{allocations[offset]}, allocations[offset] == quantities[offset]);
+      }
+    }
 
   private:
-    int limitPrice;
-    int depth = 0;
-    int volume = 0;
-    std::list<Order> limitOrders;
+    /// @brief Shares a pro-rata fill still has to allocate, by stage, carried from one chunk to the next
+    struct ProRataPlan {
+      /// @brief Shares of the top order and the time priority stage still to allocate
+      std::int64_t fifoLeft = 0;
+      /// @brief Shares of the pro rata stage, as a double for the allocation kernel
+      double shares = 0;
+      /// @brief Shares left resting after the time priority stage, the pro rata stage's denominator
+      double restingShares = 0;
+      /// @brief Raw minimum allocation, smaller pro rata allocations are dropped
+      std::int64_t minAllocation = 0;
+      /// @brief Pro rata shares still to allocate, so rounding can never hand out more than the fill
+      std::int64_t proRataLeft = 0;
+      /// @brief Shares rounding and the minimum held back, allocated in time priority at the end
+      std::int64_t leftoverLeft = 0;
+      /// @brief True if every quantity converts to a double and back exactly through the mantissa
+      bool fitsInMantissa = false;
+
+      /**
+       * @brief Check if anything is left to allocate
+       * 
+       * @return True while a stage has shares left
+       */
+      [[nodiscard]] auto isAllocating() const -> bool { return fifoLeft + proRataLeft + leftoverLeft > 0; }
+    };
+
+    /**
+     * @brief Take the head order, of the base order's own account, off the queue or decrement it, instead of trading
+     * 
+     * @param pool                  Pool the orders are stored in
+     * @param selfTradePrevention   Anything but none
+     * @param numShares             Shares the base order still has to fill here, reduced by what is cancelled
+     * @param execution             Execution the cancels are reported in
+     * @param risk                  Ledger to release the shares taken off the resting order in
+     * @return Shares taken off the resting order
+     */
+    auto preventSelfTrade(OrderPool &pool, SelfTradePrevention selfTradePrevention, Qty &numShares,
+                          OrderExecution &execution, RestingRisk risk) -> Qty;
+
+    /**
+     * @brief Work out the shares of each stage of a pro-rata fill, and how many the pro rata stage rounds away
+     * 
+     * @param chunks    Chunks the queue is built from
+     * @param numShares Shares to fill, less than depth
+     * @param rules     Pro-rata variant to allocate by
+     * @return Plan to pass to allocateChunk for every chunk in queue order
+     */
+    [[nodiscard]] auto planProRata(const ChunkPool &chunks, Qty numShares, const MatchingRules &rules) const
+        -> ProRataPlan;
+
+    /**
+     * @brief Allocate a pro-rata fill to the entries of one chunk
+     * 
+     * @param chunks      Chunks the queue is built from
+     * @param chunk       Next chunk in queue order
+     * @param plan        Plan from planProRata, updated with what this chunk took
+     * @param allocations Raw shares allocated to each entry of the chunk, set for the returned range
+     * @return First and one past the last offset of the chunk's entries
+     */
+    auto allocateChunk(const ChunkPool &chunks, ChunkIndex chunk, ProRataPlan &plan,
+                       std::array<std::int64_t, chunkCapacity> &allocations) const
+        -> std::pair<std::uint32_t, std::uint32_t>;
+
+    /**
+     * @brief Move live orders to the start of the queue if enough of it is dead, updating their positions
+     * 
+     * @param pool Pool the orders are stored in
+     */
+    void compactIfMostlyDead(OrderPool &pool);
+
+    Price limitPrice;
+    Qty depth = 0;
+    /// @brief Part of depth belonging to hidden orders, kept up to date wherever depth is
+    Qty hiddenDepth = 0;
+
+    /**
+     * @brief Release the head chunk once every entry in it has been consumed
+     * 
+     * @param chunks Chunks the queue is built from
+     */
+    void popHeadChunk(ChunkPool &chunks);
+
+    /**
+     * @brief Drop the tombstones at the front of the queue, left by orders filled away from the head
+     * 
+     * @param chunks Chunks the queue is built from
+     * @warning The queue must still hold a live order
+     */
+    void popLeadingTombstones(ChunkPool &chunks);
+
+    /**
+     * @brief Get the live shares of one chunk of the queue
+     * 
+     * @param chunks Chunks the queue is built from
+     * @param chunk  Chunk in this queue
+     * @return Sum of its quantities from the head or its start, to the tail or its end
+     */
+    [[nodiscard]] auto getChunkShares(const ChunkPool &chunks, ChunkIndex chunk) const -> std::int64_t;
+
+    /**
+     * @brief Record a change to a chunk's live shares in the depth tree, taking one once the queue is long enough
+     * 
+     * @param chunks Chunks the queue is built from, with the change already applied to the quantities
+     * @param chunk  Chunk that changed
+     * @param delta  Change to its live shares
+     */
+    void updateDepthTree(ChunkPool &chunks, ChunkIndex chunk, std::int64_t delta);
+
+    /**
+     * @brief Rebuild the depth tree from the queue's quantities, rebased on the head chunk
+     * 
+     * @param chunks Chunks the queue is built from, owning the tree
+     */
+    void rebuildDepthTree(ChunkPool &chunks);
+
+    /// @brief Chunk holding the oldest entries, filled first
+    ChunkIndex headChunk = noChunk;
+    /// @brief Chunk new orders are added to
+    ChunkIndex tailChunk = noChunk;
+    /// @brief Offset of the oldest entry in headChunk
+    std::uint32_t headOffset = 0;
+    /// @brief Number of entries used in tailChunk
+    std::uint32_t tailOffset = 0;
+    /// @brief Number of entries from head to tail, including tombstones
+    std::uint32_t queueLength = 0;
+    /// @brief Number of cancelled entries still in the queue
+    std::uint32_t tombstones = 0;
+    /// @brief Sequence number of tailChunk, the head's is read from the pool
+    std::uint32_t tailSequence = 0;
+    /// @brief Tree of live shares per chunk, noDepthTree while the queue is short
+    DepthTreeIndex depthTree = noDepthTree;
 };
 
 } // namespace Exchange
@@ -0,0 +1,48 @@
+/**
+ * @file matchingRules.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the rules a book uses to share a fill between the orders resting at one price
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef MATCHINGRULES_HPP
+#define MATCHINGRULES_HPP
+
+#include "fixedPoint.hpp"
+#include <cstdint>
+
+namespace Exchange {
+
+/// @brief How a fill that doesn't take a whole level is shared between its orders
+enum class MatchingAlgorithm : std::uint8_t {
+    /// @brief Strict price-time priority, the oldest order is filled first
+    fifo,
+    /// @brief In proportion to each order's resting shares, rounding down, with what rounding leaves filled in time priority
+    proRata
+};
+
+/**
+ * @brief Matching rules of one book, fixed when the book is created
+ *
+ * Under pro-rata, a fill is allocated in stages. The top order first, if it has priority, then fifoPercent of what's
+ * left in time priority, then the rest pro rata over what every order has left, and finally the shares rounding and
+ * minAllocation held back, again in time priority. A fill that takes a whole level fills every order either way.
+ */
+struct MatchingRules {
+    /// @brief How fills are shared out
+    MatchingAlgorithm algorithm = MatchingAlgorithm::fifo;
+    /// @brief Under pro-rata, fill the oldest order at the level before sharing out the rest
+    bool topOrderPriority = false;
+    /// @brief Under pro-rata, percentage of the fill allocated in time priority first, 0 for pure pro-rata
+    std::uint8_t fifoPercent = 0;
+    /// @brief Under pro-rata, smallest allocation worth giving an order, smaller ones go to the time priority stage
+    Qty minAllocation = 0;
+};
+
+} // namespace Exchange
+
+#endif
@@ -10,29 +10,30 @@
  */
 
 #include "order.hpp"
+#include <algorithm>
 
 namespace Exchange {
 
 auto Order::getOrderType() const -> OrderType { return orderType; }
 
-auto Order::getLimitPrice() const -> int { return limitPrice; }
+auto Order::getLimitPrice() const -> Price { return limitPrice; }
 
 auto Order::getOrderId() const -> int { return orderId; }
 
-auto Order::getShares() const -> int { return shares; }
+auto Order::getShares() const -> Qty { return shares; }
 
 auto Order::getTimeInForce() const -> int { return timeInForce; }
 
-auto Order::execute(int baseOrderId, int numShares) -> OrderExecution {
+auto Order::execute(int baseOrderId, Qty numShares) -> OrderExecution {
   OrderExecution orderExecution{baseOrderId};
   orderExecution.executeOrder(*this, numShares);
-  shares = std::max(0, shares - numShares); // either 0 for full execution, or a
+  shares = std::max(Qty{0}, shares - numShares); // either 0 for full execution, or a
                                             // partial amount remaining
 
   return orderExecution;
 }
 
-auto Order::copyWithNewShareCount(const int newShares) const -> Order {
+auto Order::copyWithNewShareCount(const Qty newShares) const -> Order {
   Order newOrder(*this);
   newOrder.shares = newShares;
   return newOrder;
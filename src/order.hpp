@@ -12,7 +12,10 @@
 #ifndef ORDER_HPP
 #define ORDER_HPP
 
+#include "fixedPoint.hpp"
 #include "orderExecution.hpp"
+#include <cstdint>
+#include <limits>
 
 namespace Exchange {
 
@@ -20,7 +23,7 @@ namespace Exchange {
  * @brief Order types possible for an order: currently buy or sell
  * 
  */
-enum OrderType {
+enum OrderType : std::uint8_t {
     buy,
     sell
 };
@@ -39,8 +42,8 @@ struct Order {
      * @param limitPrice    Price for order
      * @param timeInForce   Time the order is valid for
      */
-    Order(int orderId, OrderType orderType, int shares, int limitPrice, int timeInForce = 0)
-        : orderId{orderId}, orderType{orderType}, shares{shares}, limitPrice{limitPrice}, timeInForce{timeInForce} {}
+    Order(int orderId, OrderType orderType, Qty shares, Price limitPrice, int timeInForce = 0)
+        : shares{shares}, limitPrice{limitPrice}, orderId{orderId}, timeInForce{timeInForce}, orderType{orderType} {}
 
     /**
      * @brief Get the type of order
@@ -54,7 +57,7 @@ struct Order {
      * 
      * @return Order's price
      */
-    [[nodiscard]] auto getLimitPrice() const -> int;
+    [[nodiscard]] auto getLimitPrice() const -> Price;
 
     /**
      * @brief Get the id of order
@@ -68,7 +71,7 @@ struct Order {
      * 
      * @return Number of shares
      */
-    [[nodiscard]] auto getShares() const -> int;
+    [[nodiscard]] auto getShares() const -> Qty;
 
     /**
      * @brief Get the time in force of this order
@@ -84,7 +87,7 @@ struct Order {
      * @param numShares Number of shares executed
      * @return OrderExecution with this order fulfilled, partially or fully
      */
-    auto execute(int baseOrderId, int numShares) -> OrderExecution;
+    auto execute(int baseOrderId, Qty numShares) -> OrderExecution;
 
     /**
      * @brief Copy this Order object, but set a new sharecount in the new Order
@@ -92,18 +95,85 @@ struct Order {
      * @param newShares Number of shares to set in copied Order
      * @return New Order
      */
-    [[nodiscard]] auto copyWithNewShareCount(const int newShares) const
+    [[nodiscard]] auto copyWithNewShareCount(const Qty newShares) const
         -> Order;
 
   private:
+    // Largest first, so the struct has no internal padding
+    Qty shares;
+    Price limitPrice;
     int orderId;
-    OrderType orderType;
-    int shares;
-    int limitPrice;
 
     // TODO: Do this.
     /// @brief Currently does nothing, but will hopefully in the future be used to remove expired orders. TIF = 0 is indefinite
     int timeInForce;
+    OrderType orderType;
+};
+
+/// @brief Account of orders sent without one. Outside every valid account ID, so these orders are never indexed by
+/// account, never prevented from self-trading, and rejected by books with a risk ledger.
+inline constexpr std::uint32_t noAccount = std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * @brief What an aggressive order does when it would trade with a resting order of its own account
+ * 
+ */
+enum class SelfTradePrevention : std::uint8_t {
+    /// @brief Trade anyway
+    none,
+    /// @brief Cancel the rest of the aggressive order, the resting order keeps its place
+    cancelNewest,
+    /// @brief Cancel the resting order and keep matching
+    cancelOldest,
+    /// @brief Cancel the resting order and the rest of the aggressive order
+    cancelBoth,
+    /// @brief Take the smaller of the two off both, without a trade, cancelling whichever reaches zero
+    decrement
+};
+
+/// @brief Bits of OrderRequest::flags, copied into the order's HotOrder. An order with none is an ordinary limit order.
+struct OrderFlags {
+    /// @brief Never takes liquidity, rejected if it would cross on arrival
+    static constexpr std::uint8_t postOnly = 1U << 0;
+    /// @brief With postOnly, repriced one tick behind the best displayed contra price instead of rejected. Still
+    /// rejected if hidden orders would cross it there.
+    static constexpr std::uint8_t repricePostOnly = 1U << 1;
+    /// @brief Matches like any other order, but is left out of published depth
+    static constexpr std::uint8_t hidden = 1U << 2;
+    /// @brief Only trades on arrival if at least OrderRequest::minQuantity is in reach, not counting shares self-trade
+    /// prevention would take away, and is cancelled if it would cross without. Whatever is left after it trades rests
+    /// as an ordinary order.
+    static constexpr std::uint8_t minimumQuantity = 1U << 3;
+};
+
+/**
+ * @brief Everything a client submits with a new order
+ *
+ * Once accepted, the request is kept as the cold part of a resting order (see orderPool.hpp): it is only read
+ * again for reporting, never by matching.
+ */
+struct OrderRequest {
+    /// @brief Buy or sell
+    OrderType orderType = OrderType::buy;
+    /// @brief What to do instead of trading against the same account. Only price-time matching applies it, pro-rata
+    /// books reject orders that set it. Kept next to orderType, where it fits in padding.
+    SelfTradePrevention selfTradePrevention = SelfTradePrevention::none;
+    /// @brief OrderFlags bits, also fitting in padding
+    std::uint8_t flags = 0;
+    /// @brief Number of shares, must be positive
+    Qty shares = 0;
+    /// @brief Worst price the order may trade at
+    Price limitPrice = 0;
+    /// @brief Fewest shares the order may trade on arrival, only with OrderFlags::minimumQuantity
+    Qty minQuantity = 0;
+    /// @brief Time the order is valid for, 0 is indefinite. TODO: Make meaningful
+    int timeInForce = 0;
+    /// @brief Account submitting the order, IDs should be dense from 0
+    std::uint32_t accountId = noAccount;
+    /// @brief Client's own identifier for the order, echoed back in reports
+    std::uint64_t clientOrderId = 0;
+    /// @brief Time the order was received, in whatever clock the gateway stamps it with
+    std::int64_t timestamp = 0;
 };
 
 } // namespace Exchange
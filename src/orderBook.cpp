@@ -10,139 +10,1029 @@
  */
 
 #include "orderBook.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <utility>
 
 namespace Exchange {
 
-auto OrderBook::addOrder(OrderType orderType, int shares, int limitPrice, int timeInForce) -> OrderExecution {
-    return addOrder(Order{currentOrderId++, orderType, shares, limitPrice, timeInForce});
+auto OrderBook::addOrder(OrderType orderType, Qty shares, Price limitPrice, int timeInForce) -> Result<OrderExecution> {
+    return addOrder(OrderRequest{.orderType = orderType, .shares = shares, .limitPrice = limitPrice, .timeInForce = timeInForce});
 }
 
-auto OrderBook::addOrder(const Order& order) -> OrderExecution {
-    const auto orderPrice = order.getLimitPrice();
-    const auto orderId = order.getOrderId();
-    auto& buyOrSellMap = (order.getOrderType() == OrderType::buy) ? buyMap : sellMap;
+auto OrderBook::addOrder(const OrderRequest& request) -> Result<OrderExecution> {
+    if(request.shares <= 0)
+        return reject(RejectReason::invalidQuantity);
+    if(!priceBands.isInsideCollar(request.limitPrice))
+        return reject(RejectReason::outsidePriceBand);
+    // Pro-rata allocation shares a fill over every order at a level, it has no one order to stop or cancel at
+    if(request.selfTradePrevention != SelfTradePrevention::none && matchingRules.algorithm == MatchingAlgorithm::proRata) [[unlikely]]
+        return reject(RejectReason::selfTradeUnsupported);
 
-    if(isExecutable(order))
-        return executeOrder(order);
+    // The only session check continuous orders pay
+    if(sessionState != SessionState::continuous) [[unlikely]]
+        return addOrderOutOfSession(request);
 
-    // if the limit existed in the past, we need to re-instate it to keep track of volume, etc.
-    if(archivedLimitMaps.contains(orderPrice)) {
-        buyOrSellMap.emplace(orderPrice, archivedLimitMaps.at(orderPrice));
-        archivedLimitMaps.erase(orderPrice);
+    // Ordinary orders skip this on their flags, post-only ones are decided by one compare against the best contra price
+    if((request.flags & OrderFlags::postOnly) != 0 && wouldCross(request)) [[unlikely]]
+        return addCrossingPostOnlyOrder(request);
+
+    if(const auto reserved = reserveRisk(request); !reserved)
+        return reject(reserved.error());
+
+    auto orderExecution = addValidOrder(currentOrderId++, request);
+    publishMarketData();
+
+    ++levelActivity.adds;
+    recordLevelActivity();
+
+    return orderExecution;
+}
+
+auto OrderBook::addCrossingPostOnlyOrder(const OrderRequest& request) -> Result<OrderExecution> {
+    const auto price = getPostOnlyPrice(request);
+    if(!price)
+        return reject(price.error());
+
+    // Repriced before anything is reserved, so the risk ledger and collar see the price it will rest at
+    OrderRequest repriced = request;
+    repriced.limitPrice = *price;
+    return addOrder(repriced);
+}
+
+auto OrderBook::getPostOnlyPrice(const OrderRequest& request) const -> Result<Price> {
+    if(request.orderType == OrderType::buy)
+        return getPostOnlyPrice<OrderType::buy>(request);
+    return getPostOnlyPrice<OrderType::sell>(request);
+}
+
+template <OrderType side>
+auto OrderBook::getPostOnlyPrice(const OrderRequest& request) const -> Result<Price> {
+    if((request.flags & OrderFlags::repricePostOnly) == 0)
+        return reject(RejectReason::postOnlyWouldCross);
+
+    // Repriced behind the published best only, so the price given back never shows where hidden orders rest
+    const PriceLevel displayed = getBestDisplayedLevel<SideTraits<side>::opposite>();
+    if(displayed.shares == 0)
+        return reject(RejectReason::postOnlyWouldCross);
+    const Price price = side == OrderType::buy ? displayed.price - Price{1} : displayed.price + Price{1};
+
+    // Hidden orders better than the published best would still be crossed
+    if(isExecutable<side>(price))
+        return reject(RejectReason::postOnlyWouldCross);
+    return price;
+}
+
+auto OrderBook::wouldCross(const OrderRequest& request) const -> bool {
+    if(request.orderType == OrderType::buy)
+        return isExecutable<OrderType::buy>(request.limitPrice);
+    return isExecutable<OrderType::sell>(request.limitPrice);
+}
+
+auto OrderBook::reserveRisk(const OrderRequest& request) -> Result<void> {
+    if(riskLedger == nullptr)
+        return {};
+    return riskLedger->reserve(request.accountId, request.orderType, request.shares, request.limitPrice);
+}
+
+void OrderBook::releaseRisk(const OrderRequest& request) {
+    if(riskLedger != nullptr)
+        riskLedger->release(request.accountId, request.orderType, request.shares, request.limitPrice);
+}
+
+auto OrderBook::addValidOrder(int orderId, const OrderRequest& request) -> OrderExecution {
+    // The only place the side is looked at, matching below is compiled separately for each side
+    if(request.orderType == OrderType::buy)
+        return addOrder<OrderType::buy>(orderId, request);
+    return addOrder<OrderType::sell>(orderId, request);
+}
+
+auto OrderBook::addOrderOutOfSession(const OrderRequest& request) -> Result<OrderExecution> {
+    if(sessionState == SessionState::closed)
+        return reject(RejectReason::sessionClosed);
+
+    // Queued orders are counted straight away, they're as good as resting to the account
+    if(const auto reserved = reserveRisk(request); !reserved)
+        return reject(reserved.error());
+
+    // A queued order keeps the ID it's given now, so it can be cancelled before it's replayed
+    if(sessionState == SessionState::halted) {
+        if(const auto queued = queueCommand({.kind = QueuedCommand::Kind::add, .orderId = currentOrderId, .handle = {}, .request = request}); !queued) {
+            releaseRisk(request);
+            return reject(queued.error());
+        }
+        return OrderExecution{currentOrderId++};
     }
-    // Can continue as normal adding to the LimitPrice
-    auto [limitPriceIterator, isNewElem] = buyOrSellMap.try_emplace(orderPrice, orderPrice);
-    auto orderIterator = limitPriceIterator->second.addOrder(order);
-    idToOrderIteratorMap.insert({orderId, orderIterator});
 
-    priceToLimitMap.insert_or_assign(orderPrice, limitPriceIterator->second);
+    // Orders collected for an auction wait for the uncross, however far they cross
+    auto orderExecution = restValidOrder(currentOrderId++, request);
+    publishMarketData();
+
+    ++levelActivity.adds;
+    recordLevelActivity();
 
+    return orderExecution;
+}
+
+auto OrderBook::restValidOrder(int orderId, const OrderRequest& request) -> OrderExecution {
+    OrderExecution orderExecution{orderId};
+    orderExecution.setRestingHandle(request.orderType == OrderType::buy
+                                        ? restOrder<OrderType::buy>(orderId, request, request.shares)
+                                        : restOrder<OrderType::sell>(orderId, request, request.shares));
+    return orderExecution;
+}
+
+template <OrderType side>
+auto OrderBook::addOrder(int orderId, const OrderRequest& request) -> OrderExecution {
+    if(isExecutable<side>(request.limitPrice)) {
+        if(isExecutable<side>(request)) [[likely]]
+            return executeOrder<side>(orderId, request);
+
+        // Kept from trading by its flags, it can't rest crossing the book either, so it's cancelled
+        OrderExecution cancelled{orderId};
+        cancelled.cancelShares(request.shares);
+        releaseRisk(request);
+        return cancelled;
+    }
 
     // if order is simply added without executing, return an empty order execution with the ID of the order
-    return OrderExecution{order.getOrderId()};
+    OrderExecution orderExecution{orderId};
+    orderExecution.setRestingHandle(restOrder<side>(orderId, request, request.shares));
+    return orderExecution;
+}
+
+template <OrderType side>
+auto OrderBook::restOrder(int orderId, const OrderRequest& request, Qty shares) -> OrderHandle {
+    const LevelIndex levelIndex = findOrCreateLevel<side>(request.limitPrice);
+    const OrderSlot slot = orderPool.allocate(
+        HotOrder{.shares = shares, .orderId = orderId, .level = levelIndex, .accountId = request.accountId, .flags = request.flags},
+        request);
+
+    // Can't be rejected, the level was found by the order's own price
+    levels[levelIndex].limit.addOrder(orderPool, slot);
+    updateDepth<side>(request.limitPrice, shares);
+    orderIndex.insert(orderId, slot);
+
+    return orderPool.getHandle(slot);
+}
+
+template <OrderType side>
+auto OrderBook::findOrCreateLevel(Price price) -> LevelIndex {
+    // Single find-or-insert for the level, the order then keeps its index
+    auto [levelIndex, isNewLevel] = getLevels<side>().findOrInsert(price);
+    if(!isNewLevel)
+        return levelIndex;
+
+    ++levelActivity.levelChanges;
+
+    Level level{LimitPrice{price}, side};
+    if(freeLevels.empty()) {
+        levelIndex = static_cast<LevelIndex>(levels.size());
+        levels.push_back(level);
+    } else {
+        levelIndex = freeLevels.back();
+        freeLevels.pop_back();
+        levels[levelIndex] = level;
+    }
+
+    return levelIndex;
+}
+
+auto OrderBook::simulateOrder(const OrderRequest& request, std::span<int> filledIds) const -> Result<SimulatedExecution> {
+    if(request.shares <= 0)
+        return reject(RejectReason::invalidQuantity);
+    if(!priceBands.isInsideCollar(request.limitPrice))
+        return reject(RejectReason::outsidePriceBand);
+    // The walk never looks at accounts, so it would report fills addOrder cancels instead
+    if(request.selfTradePrevention != SelfTradePrevention::none)
+        return reject(RejectReason::selfTradeUnsupported);
+
+    // Nothing matches outside continuous trading
+    if(sessionState != SessionState::continuous)
+        return SimulatedExecution{};
+
+    if(request.orderType == OrderType::buy)
+        return simulateOrder<OrderType::buy>(request, filledIds);
+    return simulateOrder<OrderType::sell>(request, filledIds);
+}
+
+auto OrderBook::simulateOrder(OrderType orderType, Qty shares, Price limitPrice, std::span<int> filledIds) const
+    -> Result<SimulatedExecution> {
+    return simulateOrder(OrderRequest{.orderType = orderType, .shares = shares, .limitPrice = limitPrice}, filledIds);
+}
+
+template <OrderType side>
+auto OrderBook::simulateOrder(const OrderRequest& request, std::span<int> filledIds) const -> SimulatedExecution {
+    SimulatedExecution execution;
+    if(!isExecutable<side>(request))
+        return execution;
+
+    Qty sharesLeft = request.shares;
+    const Price sweepLimit = priceBands.getSweepLimit<side>(request.limitPrice);
+
+    getLevels<SideTraits<side>::opposite>().visitBestFirstWhile([&](Price price, LevelIndex levelIndex) {
+        if(!SideTraits<side>::crosses(sweepLimit, price))
+            return false;
+
+        const LimitPrice& limit = levels[levelIndex].limit;
+        const Qty sharesInLevel = std::min(sharesLeft, limit.getDepth());
+        execution.sharesExecuted += sharesInLevel;
+        execution.moneyExchanged += price * sharesInLevel;
+        ++execution.levelsTouched;
+        sharesLeft -= sharesInLevel;
+
+        // Once the buffer is full, a level taken whole only needs counting
+        if(sharesInLevel == limit.getDepth() && execution.filledOrders >= filledIds.size()) {
+            execution.filledOrders += limit.getOrderCount();
+            return sharesLeft > 0;
+        }
+
+        if(matchingRules.algorithm == MatchingAlgorithm::proRata && sharesInLevel < limit.getDepth()) {
+            limit.visitProRataFills(orderPool, sharesInLevel, matchingRules, [&](int orderId, Qty shares, bool filledCompletely) {
+                if(!filledCompletely) {
+                    if(execution.partiallyFilledOrders++ == 0)
+                        execution.partiallyFilledOrder = {orderId, shares};
+                    return;
+                }
+                if(execution.filledOrders < filledIds.size())
+                    filledIds[execution.filledIdsRecorded++] = orderId;
+                ++execution.filledOrders;
+            });
+            return false;
+        }
+
+        Qty levelLeft = sharesInLevel;
+        limit.visitOrders(orderPool, [&](const HotOrder& order) {
+            if(order.shares > levelLeft) {
+                execution.partiallyFilledOrder = {order.orderId, levelLeft};
+                ++execution.partiallyFilledOrders;
+                return false;
+            }
+            if(execution.filledOrders < filledIds.size())
+                filledIds[execution.filledIdsRecorded++] = order.orderId;
+            ++execution.filledOrders;
+            levelLeft -= order.shares;
+            return levelLeft > 0;
+        });
+
+        return sharesLeft > 0;
+    });
+
+    return execution;
+}
+
+auto OrderBook::cancelOrder(int orderId) -> Result<void> {
+    if(sessionState == SessionState::halted) [[unlikely]]
+        return queueCommand({.kind = QueuedCommand::Kind::cancelById, .orderId = orderId, .handle = {}, .request = {}});
+
+    const OrderSlot slot = orderIndex.erase(orderId);
+    if(slot == noSlot)
+        return reject(RejectReason::unknownOrderId);
+
+    removeRestingOrder(slot);
+    publishMarketData();
+
+    ++levelActivity.cancels;
+    recordLevelActivity();
+
+    return {};
+}
+
+auto OrderBook::cancelOrder(OrderHandle handle) -> Result<void> {
+    if(sessionState == SessionState::halted) [[unlikely]]
+        return queueCommand({.kind = QueuedCommand::Kind::cancelByHandle, .orderId = 0, .handle = handle, .request = {}});
+
+    // Stale handles are caught here, by the slot's generation having moved on
+    if(!orderPool.isLive(handle))
+        return reject(RejectReason::unknownOrderId);
+
+    orderIndex.erase(orderPool.getHot(handle.slot).orderId);
+    removeRestingOrder(handle.slot);
+    publishMarketData();
+
+    ++levelActivity.cancels;
+    recordLevelActivity();
+
+    return {};
+}
+
+auto OrderBook::cancelAccountOrders(std::uint32_t accountId) -> std::size_t {
+    return cancelAccountOrdersWhere(accountId, [](OrderType, Price) { return true; });
+}
+
+auto OrderBook::cancelAccountOrders(std::uint32_t accountId, OrderType side) -> std::size_t {
+    return cancelAccountOrdersWhere(accountId, [side](OrderType orderSide, Price) { return orderSide == side; });
+}
+
+auto OrderBook::cancelAccountOrders(std::uint32_t accountId, OrderType side, Price minPrice, Price maxPrice)
+    -> std::size_t {
+    return cancelAccountOrdersWhere(accountId, [=](OrderType orderSide, Price price) {
+        return orderSide == side && price >= minPrice && price <= maxPrice;
+    });
 }
 
-void OrderBook::cancelOrder(int orderId) {
-    const auto& orderIterator = idToOrderIteratorMap.at(orderId);
-    const int price = orderIterator->getLimitPrice();
+template <typename Predicate>
+auto OrderBook::cancelAccountOrdersWhere(std::uint32_t accountId, Predicate shouldCancel) -> std::size_t {
+    if(accountId == noAccount)
+        return 0;
+
+    // Orders that haven't reached the book yet go too, or they would rest once the halt lifts
+    const std::size_t queued = std::erase_if(haltQueue, [&](const QueuedCommand& command) {
+        const bool cancels = command.kind == QueuedCommand::Kind::add && command.request.accountId == accountId &&
+                             shouldCancel(command.request.orderType, command.request.limitPrice);
+        if(cancels)
+            releaseRisk(command.request);
+        return cancels;
+    });
 
-    LimitPrice& limitPrice = priceToLimitMap.at(price);
-    OrderType removedType = limitPrice.removeOrder(orderIterator);
-    idToOrderIteratorMap.erase(orderId);
+    // Cancelling unlinks an order, so each next is read before, and the walk ends at the newest order found now
+    const AccountIndex& accounts = orderPool.getAccounts();
+    const OrderSlot last = accounts.getLast(accountId);
+    std::size_t cancelled = 0;
+    for(OrderSlot slot = accounts.getFirst(accountId), next = noSlot; slot != noSlot; slot = slot == last ? noSlot : next) {
+        next = accounts.getNext(slot);
+        const HotOrder& order = orderPool.getHot(slot);
+        const Level& level = levels[order.level];
+        if(!shouldCancel(level.side, level.limit.getPrice()))
+            continue;
+
+        orderIndex.erase(order.orderId);
+        removeRestingOrder(slot);
+        ++cancelled;
+    }
+
+    if(cancelled > 0) {
+        publishMarketData();
+        levelActivity.cancels += static_cast<std::uint32_t>(cancelled);
+        recordLevelActivity();
+    }
+
+    return cancelled + queued;
+}
+
+void OrderBook::removeRestingOrder(OrderSlot slot) {
+    const LevelIndex levelIndex = orderPool.getHot(slot).level;
+    Level& level = levels[levelIndex];
+    const Qty shares = orderPool.getHot(slot).shares;
+    if(riskLedger != nullptr)
+        riskLedger->release(orderPool.getHot(slot).accountId, level.side, shares, level.limit.getPrice());
+    level.limit.removeOrder(orderPool, slot);
+    orderPool.release(slot);
+
+    if(level.side == OrderType::buy)
+        updateDepth<OrderType::buy>(level.limit.getPrice(), Qty{0} - shares);
+    else
+        updateDepth<OrderType::sell>(level.limit.getPrice(), Qty{0} - shares);
 
     // Need to erase empty limitPrices here, as gives incorrect info on lowest bids/asks
-    // TODO: See if can do better than O(logn) for cancelling orders in empty case
-    if(limitPrice.isEmpty())
-        removeLimitMap(price, removedType);
+    if(level.limit.isEmpty()) {
+        if(level.side == OrderType::buy)
+            removeLimit<OrderType::buy>(levelIndex);
+        else
+            removeLimit<OrderType::sell>(levelIndex);
+    }
 }
 
-auto OrderBook::executeOrder(const Order& order) -> OrderExecution {
-    const int startingShares = order.getShares();
-    const int baseOrderId = order.getOrderId();
-    int sharesLeftToExec = startingShares;
+template <OrderType side>
+auto OrderBook::executeOrder(int orderId, const OrderRequest& request) -> OrderExecution {
+    constexpr OrderType contraSide = SideTraits<side>::opposite;
 
-    OrderExecution totalExec{baseOrderId};
+    const Qty startingShares = request.shares;
+    const Price orderPrice = request.limitPrice;
+    Qty sharesLeftToExec = startingShares;
 
-    while(sharesLeftToExec > 0 && isExecutable(order)) {
-        OrderType targetLimitType = (order.getOrderType() == OrderType::sell) ? OrderType::buy : OrderType::sell;
-        LimitPrice& targetLimit = (order.getOrderType() == OrderType::sell) ? (--buyMap.end())->second : sellMap.begin()->second;
-        
-        const int sharesToExecInLimit = std::min(sharesLeftToExec, targetLimit.getDepth());
+    OrderExecution totalExec{orderId};
 
-        OrderExecution limitExecution = targetLimit.executeNumberOfShares(baseOrderId, sharesToExecInLimit);
+    // Clamped to the dynamic band once, so stopping at it costs the sweep nothing per level
+    const Price sweepLimit = priceBands.getSweepLimit<side>(orderPrice);
+    Price lastTradePrice = orderPrice;
 
-        for(const auto fulfilledId : limitExecution.getFulfilledOrderIds())
-            idToOrderIteratorMap.erase(fulfilledId);
+    while(sharesLeftToExec > 0 && isExecutable<side>(sweepLimit)) {
+        const LevelIndex targetLevel = getBestLevel<contraSide>();
+        const LimitPrice& targetLimit = levels[targetLevel].limit;
+        const Qty sharesToExecInLimit = std::min(sharesLeftToExec, targetLimit.getDepth());
+
+        const Price levelPrice = targetLimit.getPrice();
+        const OrderExecution limitExecution = executeLevel<contraSide>(
+            targetLevel, orderId, sharesToExecInLimit, levelPrice, request.selfTradePrevention, request.accountId);
+        // Self-trade prevention may only have cancelled at this level
+        if(limitExecution.getTotalSharesExecuted() > 0)
+            lastTradePrice = levelPrice;
+        volumeHistory.addVolume(levelPrice, limitExecution.getTotalSharesExecuted());
+        totalExec.append(limitExecution);
+        sharesLeftToExec = startingShares - totalExec.getTotalSharesExecuted() - totalExec.getSharesCancelled();
+
+        // The level only saw the shares it could fill, cancelling the newest order cancels everything it has left
+        const bool cancelsNewest = request.selfTradePrevention == SelfTradePrevention::cancelNewest ||
+                                   request.selfTradePrevention == SelfTradePrevention::cancelBoth;
+        if(cancelsNewest && limitExecution.getSharesCancelled() > 0) {
+            totalExec.cancelShares(sharesLeftToExec);
+            sharesLeftToExec = 0;
+        }
+    }
 
-        if(targetLimit.isEmpty())
-            removeLimitMap(targetLimit.getPrice(), targetLimitType);
+    if(sharesLeftToExec < startingShares)
+        ++levelActivity.sweeps;
 
-        totalExec += limitExecution;
-        sharesLeftToExec = startingShares - totalExec.getTotalSharesExecuted();
+    // Stopped by the band rather than its own limit, so what's left would cross the book if it rested
+    if(sharesLeftToExec > 0 && isExecutable<side>(orderPrice)) {
+        totalExec.cancelShares(sharesLeftToExec);
+        sharesLeftToExec = 0;
     }
 
     if(sharesLeftToExec > 0) 
-        addOrder(order.copyWithNewShareCount(sharesLeftToExec));
+        totalExec.setRestingHandle(restOrder<side>(orderId, request, sharesLeftToExec));
 
     totalVolume += totalExec.getTotalSharesExecuted();
+    if(totalExec.getTotalSharesExecuted() > 0)
+        priceBands.recordTrade(lastTradePrice);
+
+    // Reserved at the order's limit price, whatever prices it traded at
+    if(riskLedger != nullptr) {
+        riskLedger->fill(request.accountId, side, totalExec.getTotalSharesExecuted(), orderPrice);
+        riskLedger->release(request.accountId, side, totalExec.getSharesCancelled(), orderPrice);
+    }
 
     return totalExec;
 }
 
-auto OrderBook::getVolumeAtLimit(int price) const -> int {
-    int volumeAtLimit = 0;
-    if(priceToLimitMap.contains(price))
-        volumeAtLimit += priceToLimitMap.at(price).getVolume();
-    if(archivedLimitMaps.contains(price))
-        volumeAtLimit += archivedLimitMaps.at(price).getVolume();
+template <OrderType side>
+auto OrderBook::executeLevel(LevelIndex levelIndex, int orderId, Qty shares, Price tradePrice,
+                             SelfTradePrevention selfTradePrevention, std::uint32_t accountId) -> OrderExecution {
+    LimitPrice& limit = levels[levelIndex].limit;
+    const Price levelPrice = limit.getPrice();
+    const Qty depthBefore = limit.getDepth();
+
+    // The level settles its orders' risk while filling them, before it releases their records
+    const RestingRisk risk{riskLedger, side};
+    // Can't be rejected, callers cap shares at the level's depth
+    OrderExecution levelExecution =
+        std::move(matchingRules.algorithm == MatchingAlgorithm::proRata
+                      ? limit.executeProRata(orderPool, orderId, shares, matchingRules, tradePrice, risk)
+                      : limit.executeNumberOfShares(orderPool, orderId, shares, tradePrice, selfTradePrevention,
+                                                    accountId, risk))
+            .value();
+    // Traded shares, and any self-trade prevention took off resting orders
+    updateDepth<side>(levelPrice, limit.getDepth() - depthBefore);
+
+    for(const auto fulfilledId : levelExecution.getFulfilledOrderIds())
+        orderIndex.erase(fulfilledId);
+    for(const auto cancelledId : levelExecution.getSelfTradeCancelledIds())
+        orderIndex.erase(cancelledId);
 
-    return volumeAtLimit;
+    if(limit.isEmpty()) {
+        removeLimit<side>(levelIndex);
+        ++levelActivity.levelsSwept;
+    }
+
+    return levelExecution;
 }
 
-auto OrderBook::getBestBid() const -> std::optional<int> {
-    if(buyMap.empty())
+auto OrderBook::setSessionState(SessionState state) -> Result<void> {
+    if(!isValidTransition(sessionState, state))
+        return reject(RejectReason::invalidTransition);
+    if(state == SessionState::continuous && !buyLevels.empty() && !sellLevels.empty() &&
+       buyLevels.getBestPrice() >= sellLevels.getBestPrice())
+        return reject(RejectReason::bookCrossed);
+
+    const SessionState previous = sessionState;
+    sessionState = state;
+
+    // Reserved once, so queueing during any later halt never allocates
+    if(state == SessionState::halted) {
+        haltQueue.reserve(haltQueueCapacity);
+        replayedExecutions.reserve(haltQueueCapacity);
+    }
+    if(previous == SessionState::halted && state != SessionState::halted)
+        replayQueuedCommands();
+
+    return {};
+}
+
+auto OrderBook::getSessionState() const -> SessionState { return sessionState; }
+
+void OrderBook::setRiskLedger(RiskLedger* ledger) { riskLedger = ledger; }
+
+void OrderBook::setPriceBands(const PriceBandRules& rules, Price referencePrice) {
+    priceBands.setRules(rules, referencePrice);
+}
+
+auto OrderBook::getPriceBands() const -> const PriceBands& { return priceBands; }
+
+auto OrderBook::getReplayedExecutions() const -> std::span<const OrderExecution> { return replayedExecutions; }
+
+auto OrderBook::replayCrossingPostOnlyOrder(int orderId, const OrderRequest& request) -> OrderExecution {
+    // Already accepted with its ID, so anything addOrder would reject is cancelled instead
+    OrderExecution cancelled = cancelQueuedOrder(orderId, request);
+
+    const auto price = getPostOnlyPrice(request);
+    if(!price || !priceBands.isInsideCollar(*price))
+        return cancelled;
+    OrderRequest repriced = request;
+    repriced.limitPrice = *price;
+    if(!reserveRisk(repriced))
+        return cancelled;
+    return addValidOrder(orderId, repriced);
+}
+
+auto OrderBook::cancelQueuedOrder(int orderId, const OrderRequest& request) -> OrderExecution {
+    OrderExecution cancelled{orderId};
+    cancelled.cancelShares(request.shares);
+    releaseRisk(request);
+    return cancelled;
+}
+
+auto OrderBook::queueCommand(const QueuedCommand& command) -> Result<void> {
+    if(haltQueue.size() >= haltQueueCapacity)
+        return reject(RejectReason::haltQueueFull);
+    haltQueue.push_back(command);
+    return {};
+}
+
+void OrderBook::replayQueuedCommands() {
+    replayedExecutions.clear();
+    if(sessionState == SessionState::closed) {
+        for(const QueuedCommand& command : haltQueue)
+            if(command.kind == QueuedCommand::Kind::add)
+                releaseRisk(command.request);
+        haltQueue.clear();
+        return;
+    }
+
+    // Replayed straight into matching, each command already passed addOrder's or cancelOrder's checks when queued,
+    // and only the collar can have changed since
+    for(const QueuedCommand& command : haltQueue) {
+        switch(command.kind) {
+        case QueuedCommand::Kind::add:
+            // setPriceBands may have moved the collar since the order was queued
+            if(!priceBands.isInsideCollar(command.request.limitPrice)) [[unlikely]]
+                replayedExecutions.push_back(cancelQueuedOrder(command.orderId, command.request));
+            else if(sessionState != SessionState::continuous)
+                replayedExecutions.push_back(restValidOrder(command.orderId, command.request));
+            else if((command.request.flags & OrderFlags::postOnly) != 0 && wouldCross(command.request)) [[unlikely]]
+                replayedExecutions.push_back(replayCrossingPostOnlyOrder(command.orderId, command.request));
+            else
+                replayedExecutions.push_back(addValidOrder(command.orderId, command.request));
+            ++levelActivity.adds;
+            break;
+        case QueuedCommand::Kind::cancelById:
+            // A cancel for an order that filled or never existed is dropped, as if it raced the fill
+            if(const OrderSlot slot = orderIndex.erase(command.orderId); slot != noSlot) {
+                removeRestingOrder(slot);
+                ++levelActivity.cancels;
+            }
+            break;
+        case QueuedCommand::Kind::cancelByHandle:
+            if(orderPool.isLive(command.handle)) {
+                orderIndex.erase(orderPool.getHot(command.handle.slot).orderId);
+                removeRestingOrder(command.handle.slot);
+                ++levelActivity.cancels;
+            }
+            break;
+        }
+        recordLevelActivity();
+    }
+    haltQueue.clear();
+
+    publishMarketData();
+}
+
+auto OrderBook::getIndicativeUncross(Price referencePrice) const -> std::optional<AuctionUncross> {
+    return findUncrossingPrice(collectAuctionLevels(), referencePrice);
+}
+
+auto OrderBook::uncrossAuction(Price referencePrice) -> Result<AuctionResult> {
+    if(sessionState != SessionState::preOpen && sessionState != SessionState::auction)
+        return reject(RejectReason::invalidTransition);
+
+    // Each side's trades are reported like an order's, under an ID of their own
+    const int uncrossId = currentOrderId++;
+    AuctionResult result{findUncrossingPrice(collectAuctionLevels(), referencePrice), OrderExecution{uncrossId},
+                         OrderExecution{uncrossId}};
+    if(result.uncross) {
+        result.buyFills = executeAuctionSide<OrderType::buy>(uncrossId, result.uncross->volume, result.uncross->price);
+        result.sellFills = executeAuctionSide<OrderType::sell>(uncrossId, result.uncross->volume, result.uncross->price);
+        volumeHistory.addVolume(result.uncross->price, result.uncross->volume);
+        totalVolume += result.uncross->volume;
+        priceBands.recordTrade(result.uncross->price);
+    }
+
+    // Trading the most volume the crossed prices allow leaves the book uncrossed, so the move isn't refused
+    [[maybe_unused]] const Result<void> opened = setSessionState(SessionState::continuous);
+    assert(opened);
+
+    publishMarketData();
+    return result;
+}
+
+template <OrderType side>
+auto OrderBook::executeAuctionSide(int orderId, Qty shares, Price tradePrice) -> OrderExecution {
+    OrderExecution execution{orderId};
+    while(shares > 0) {
+        const LevelIndex levelIndex = getBestLevel<side>();
+        const Qty sharesInLevel = std::min(shares, levels[levelIndex].limit.getDepth());
+        execution.append(executeLevel<side>(levelIndex, orderId, sharesInLevel, tradePrice, SelfTradePrevention::none, noAccount));
+        shares -= sharesInLevel;
+    }
+    return execution;
+}
+
+auto OrderBook::collectAuctionLevels() const -> std::vector<AuctionLevel> {
+    std::vector<AuctionLevel> auctionLevels;
+    if(buyLevels.empty() || sellLevels.empty() || buyLevels.getBestPrice() < sellLevels.getBestPrice())
+        return auctionLevels;
+
+    // Sells come best first, so ascending, buys best first too, so descending. Merge the two into ascending order.
+    const Price bestBid = buyLevels.getBestPrice();
+    const Price bestAsk = sellLevels.getBestPrice();
+    sellLevels.visitBestFirstWhile([&](Price price, LevelIndex levelIndex) {
+        if(price > bestBid)
+            return false;
+        auctionLevels.push_back(AuctionLevel{price, 0, levels[levelIndex].limit.getDepth()});
+        return true;
+    });
+
+    const auto sellsEnd = static_cast<std::ptrdiff_t>(auctionLevels.size());
+    buyLevels.visitBestFirstWhile([&](Price price, LevelIndex levelIndex) {
+        if(price < bestAsk)
+            return false;
+        auctionLevels.push_back(AuctionLevel{price, levels[levelIndex].limit.getDepth(), 0});
+        return true;
+    });
+    std::reverse(auctionLevels.begin() + sellsEnd, auctionLevels.end());
+    std::inplace_merge(auctionLevels.begin(), auctionLevels.begin() + sellsEnd, auctionLevels.end(),
+                       [](const AuctionLevel& lhs, const AuctionLevel& rhs) { return lhs.price < rhs.price; });
+
+    // A price with levels on both sides now appears twice in a row, fold each pair into one
+    auto last = auctionLevels.begin();
+    for(auto level = auctionLevels.begin(); level != auctionLevels.end(); ++level) {
+        if(level != auctionLevels.begin() && level->price == std::prev(last)->price) {
+            std::prev(last)->buyShares += level->buyShares;
+            std::prev(last)->sellShares += level->sellShares;
+        } else {
+            *last++ = *level;
+        }
+    }
+    auctionLevels.erase(last, auctionLevels.end());
+    return auctionLevels;
+}
+
+auto OrderBook::getVolumeAtLimit(Price price) const -> Qty {
+    return volumeHistory.getVolume(price);
+}
+
+auto OrderBook::getOrderDetails(int orderId) const -> Result<ColdOrder> {
+    const OrderSlot slot = orderIndex.find(orderId);
+    if(slot == noSlot)
+        return reject(RejectReason::unknownOrderId);
+
+    return orderPool.getCold(slot);
+}
+
+auto OrderBook::getQueuePosition(int orderId) const -> Result<Qty> {
+    const OrderSlot slot = orderIndex.find(orderId);
+    if(slot == noSlot)
+        return reject(RejectReason::unknownOrderId);
+
+    return levels[orderPool.getHot(slot).level].limit.getSharesAhead(orderPool, slot);
+}
+
+auto OrderBook::getQueuePosition(OrderHandle handle) const -> Result<Qty> {
+    if(!orderPool.isLive(handle))
+        return reject(RejectReason::unknownOrderId);
+
+    return levels[orderPool.getHot(handle.slot).level].limit.getSharesAhead(orderPool, handle.slot);
+}
+
+auto OrderBook::getBestBid() const -> std::optional<Price> {
+    const PriceLevel bestBid = getBestDisplayedLevel<OrderType::buy>();
+    if(bestBid.shares == 0)
         return {};
 
-    return std::prev(buyMap.end())->second.getPrice();
+    return bestBid.price;
 }
 
-auto OrderBook::getBestAsk() const -> std::optional<int> {
-    if(sellMap.empty())
+auto OrderBook::getBestAsk() const -> std::optional<Price> {
+    const PriceLevel bestAsk = getBestDisplayedLevel<OrderType::sell>();
+    if(bestAsk.shares == 0)
         return {};
 
-    return sellMap.begin()->second.getPrice();
+    return bestAsk.price;
 }
 
-auto OrderBook::getTotalVolume() const -> int {
+auto OrderBook::getTotalVolume() const -> Qty {
     return totalVolume;
 }
 
-auto OrderBook::isExecutable(const Order& order) const -> bool {
-    const auto orderType = order.getOrderType();
-    const auto price = order.getLimitPrice();
+auto OrderBook::getTopOfBook() const -> TopOfBook {
+    TopOfBook topOfBook;
 
-    auto bestAsk = getBestAsk();
-    auto bestBid = getBestBid();
+    const PriceLevel bestBid = getBestDisplayedLevel<OrderType::buy>();
+    topOfBook.bidPrice = bestBid.price;
+    topOfBook.bidShares = bestBid.shares;
+    const PriceLevel bestAsk = getBestDisplayedLevel<OrderType::sell>();
+    topOfBook.askPrice = bestAsk.price;
+    topOfBook.askShares = bestAsk.shares;
 
-    if(orderType == OrderType::buy && bestAsk && price >= bestAsk.value())
+    return topOfBook;
+}
+
+template <OrderType side>
+auto OrderBook::getBestDisplayedLevel() const -> PriceLevel {
+    if(getLevels<side>().empty())
+        return {};
+
+    const LimitPrice& best = levels[getBestLevel<side>()].limit;
+    if(best.getDisplayedDepth() > 0) [[likely]]
+        return PriceLevel{best.getPrice(), best.getDisplayedDepth()};
+
+    // Levels holding only hidden orders aren't published, so the top is the first level showing anything
+    PriceLevel displayed;
+    getLevels<side>().visitBestFirstWhile([&](Price price, LevelIndex levelIndex) {
+        const Qty shares = levels[levelIndex].limit.getDisplayedDepth();
+        if(shares > 0)
+            displayed = PriceLevel{price, shares};
+        return shares == 0;
+    });
+    return displayed;
+}
+
+auto OrderBook::getTopOfBookUpdates() const -> const ConflatingSlot<TopOfBook>& {
+    return topOfBookUpdates;
+}
+
+auto OrderBook::getSnapshot() const -> BookSnapshot {
+    BookSnapshot snapshot;
+
+    // Hidden shares aren't published, and levels holding nothing else are left out
+    buyLevels.visitBestFirstWhile([&](Price price, LevelIndex level) {
+        if(const Qty shares = levels[level].limit.getDisplayedDepth(); shares > 0)
+            snapshot.bids[snapshot.bidLevels++] = PriceLevel{price, shares};
+        return snapshot.bidLevels < snapshotDepth;
+    });
+    sellLevels.visitBestFirstWhile([&](Price price, LevelIndex level) {
+        if(const Qty shares = levels[level].limit.getDisplayedDepth(); shares > 0)
+            snapshot.asks[snapshot.askLevels++] = PriceLevel{price, shares};
+        return snapshot.askLevels < snapshotDepth;
+    });
+
+    return snapshot;
+}
+
+auto OrderBook::getPublishedSnapshot() const -> BookSnapshot {
+    return publishedSnapshot.read();
+}
+
+template <OrderType side>
+auto OrderBook::isExecutable(Price price) const -> bool {
+    const auto& contraLevels = getLevels<SideTraits<side>::opposite>();
+    if(contraLevels.empty())
+        return false;
+
+    // Best contra level is the lowest ask for a buy, the highest bid for a sell
+    return SideTraits<side>::crosses(price, contraLevels.getBestPrice());
+}
+
+template <OrderType side>
+auto OrderBook::isExecutable(const OrderRequest& request) const -> bool {
+    if(!isExecutable<side>(request.limitPrice))
+        return false;
+    // Ordinary orders are done with after one more test
+    if(request.flags == 0) [[likely]]
         return true;
-    if(orderType == OrderType::sell && bestBid && price <= bestBid)
+
+    // Callers reprice or reject crossing post-only orders first, this only makes sure one never takes liquidity
+    if((request.flags & OrderFlags::postOnly) != 0)
+        return false;
+    return (request.flags & OrderFlags::minimumQuantity) == 0 || isMinimumQuantityInReach<side>(request);
+}
+
+template <OrderType side>
+auto OrderBook::isMinimumQuantityInReach(const OrderRequest& request) const -> bool {
+    const Price sweepLimit = priceBands.getSweepLimit<side>(request.limitPrice);
+    if(request.selfTradePrevention == SelfTradePrevention::none || request.accountId == noAccount)
+        return getAvailableShares(side, sweepLimit) >= request.minQuantity;
+
+    // Self-trade prevention cancels or decrements instead of trading with the order's own account, so walk the
+    // queues as matching would, up to the minimum
+    Qty sharesLeft = request.shares;
+    Qty traded = 0;
+    auto isWalking = [&] { return sharesLeft > 0 && traded < request.minQuantity; };
+    getLevels<SideTraits<side>::opposite>().visitBestFirstWhile([&](Price price, LevelIndex levelIndex) {
+        if(!SideTraits<side>::crosses(sweepLimit, price))
+            return false;
+
+        levels[levelIndex].limit.visitOrders(orderPool, [&](const HotOrder& order) {
+            if(order.accountId != request.accountId) {
+                const Qty shares = std::min(sharesLeft, order.shares);
+                traded += shares;
+                sharesLeft -= shares;
+            } else if(request.selfTradePrevention == SelfTradePrevention::decrement) {
+                sharesLeft -= std::min(sharesLeft, order.shares);
+            } else if(request.selfTradePrevention != SelfTradePrevention::cancelOldest) {
+                sharesLeft = 0;
+            }
+            return isWalking();
+        });
+        return isWalking();
+    });
+    return traded >= request.minQuantity;
+}
+
+template <OrderType side>
+auto OrderBook::getLevels() -> PriceLevels<side>& {
+    if constexpr(side == OrderType::buy)
+        return buyLevels;
+    else
+        return sellLevels;
+}
+
+template <OrderType side>
+auto OrderBook::getLevels() const -> const PriceLevels<side>& {
+    if constexpr(side == OrderType::buy)
+        return buyLevels;
+    else
+        return sellLevels;
+}
+
+template <OrderType side>
+auto OrderBook::getBestLevel() const -> LevelIndex {
+    return getLevels<side>().getBestLevel();
+}
+
+template <OrderType side>
+void OrderBook::removeLimit(LevelIndex level) {
+    // Volume lives in volumeHistory, so the level can simply be destroyed
+    getLevels<side>().erase(levels[level].limit.getPrice());
+    freeLevels.push_back(level);
+    ++levelActivity.levelChanges;
+}
+
+auto OrderBook::getAvailableShares(OrderType side, Price limitPrice) const -> Qty {
+    if(side == OrderType::buy && sellDepth.isBuilt())
+        return sellDepth.getDepthAtOrBelow(limitPrice);
+    if(side == OrderType::sell && buyDepth.isBuilt())
+        return buyDepth.getDepthAtOrAbove(limitPrice);
+
+    // Side too small or too widely spread for its index, walk its levels instead
+    Qty available = 0;
+    auto addIfCrosses = [&](Price price, LevelIndex level) {
+        if(side == OrderType::buy ? SideTraits<OrderType::buy>::crosses(limitPrice, price)
+                                  : SideTraits<OrderType::sell>::crosses(limitPrice, price))
+            available += levels[level].limit.getDepth();
+    };
+    if(side == OrderType::buy)
+        sellLevels.visitBestFirst(sellLevels.size(), addIfCrosses);
+    else
+        buyLevels.visitBestFirst(buyLevels.size(), addIfCrosses);
+    return available;
+}
+
+auto OrderBook::getImpactPrice(OrderType side, Qty shares) const -> std::optional<Price> {
+    if(side == OrderType::buy && sellDepth.isBuilt())
+        return sellDepth.findPriceFromBelow(shares);
+    if(side == OrderType::sell && buyDepth.isBuilt())
+        return buyDepth.findPriceFromAbove(shares);
+
+    // Side too small or too widely spread for its index, walk its levels instead
+    std::optional<Price> impactPrice;
+    Qty wanted = shares;
+    auto takeUntilFilled = [&](Price price, LevelIndex level) {
+        if(wanted <= 0)
+            return;
+        wanted -= levels[level].limit.getDepth();
+        if(wanted <= 0)
+            impactPrice = price;
+    };
+    if(side == OrderType::buy)
+        sellLevels.visitBestFirst(sellLevels.size(), takeUntilFilled);
+    else
+        buyLevels.visitBestFirst(buyLevels.size(), takeUntilFilled);
+    return impactPrice;
+}
+
+auto OrderBook::getLevelStorage(OrderType side) const -> LevelStorage {
+    return side == OrderType::buy ? buyLevels.getStorage() : sellLevels.getStorage();
+}
+
+auto OrderBook::getLevelMigrationStats() const -> const LevelMigrationStats& {
+    return levelMigrationStats;
+}
+
+auto OrderBook::getMatchingRules() const -> const MatchingRules& {
+    return matchingRules;
+}
+
+void OrderBook::recordLevelActivity() {
+    if(levelActivity.getEvents() < levelActivityWindow)
+        return;
+
+    adaptLevelStorage<OrderType::buy>();
+    adaptLevelStorage<OrderType::sell>();
+    levelActivity = LevelActivity{};
+
+    // A side too wide for its depth index may have narrowed since
+    if(!buyDepth.isEnabled() && (buyLevels.empty() || buyLevels.getBestPrice() - buyLevels.getWorstPrice() < maxDepthIndexTicks))
+        rebuildDepthIndex<OrderType::buy>();
+    if(!sellDepth.isEnabled() && (sellLevels.empty() || sellLevels.getWorstPrice() - sellLevels.getBestPrice() < maxDepthIndexTicks))
+        rebuildDepthIndex<OrderType::sell>();
+}
+
+template <OrderType side>
+auto OrderBook::getDepthIndex() -> DepthIndex& {
+    if constexpr(side == OrderType::buy)
+        return buyDepth;
+    else
+        return sellDepth;
+}
+
+template <OrderType side>
+void OrderBook::updateDepth(Price price, Qty shares) {
+    if(!publishedDepthChanged && isInPublishedDepth<side>(price))
+        publishedDepthChanged = true;
+    if(getLevels<side>().getStorage() == LevelStorage::inlineArrays || !getDepthIndex<side>().add(price, shares))
+        rebuildDepthIndex<side>();
+}
+
+template <OrderType side>
+auto OrderBook::isInPublishedDepth(Price price) const -> bool {
+    const std::size_t publishedLevels = side == OrderType::buy ? lastSnapshot.bidLevels : lastSnapshot.askLevels;
+    if(publishedLevels < snapshotDepth)
         return true;
-    
-    return false;
+
+    // A full side only changes if the price is at or better than its worst published level
+    const PriceLevel& worst = (side == OrderType::buy ? lastSnapshot.bids : lastSnapshot.asks)[snapshotDepth - 1];
+    return !SideTraits<side>::isBetter(worst.price, price);
 }
 
-void OrderBook::removeLimitMap(int price, OrderType orderType) {
-    if(orderType == OrderType::buy) {
-        archivedLimitMaps.emplace(price, priceToLimitMap.at(price));
-        buyMap.erase(price);
-    }
-    else {
-        archivedLimitMaps.emplace(price, priceToLimitMap.at(price));
-        sellMap.erase(price);
+template <OrderType side>
+void OrderBook::rebuildDepthIndex() {
+    // A side in its inline arrays is quicker to walk than to index, and a small book stays small without a tree
+    if(getLevels<side>().getStorage() == LevelStorage::inlineArrays) {
+        if(getDepthIndex<side>().isBuilt() || !getDepthIndex<side>().isEnabled())
+            getDepthIndex<side>().clear();
+        return;
     }
 
-    priceToLimitMap.erase(price);
+    std::vector<PriceLevel> sideDepth;
+    sideDepth.reserve(getLevels<side>().size());
+    getLevels<side>().visitBestFirst(getLevels<side>().size(), [&](Price price, LevelIndex level) {
+        sideDepth.push_back(PriceLevel{price, levels[level].limit.getDepth()});
+    });
+    getDepthIndex<side>().rebuild(sideDepth);
+}
+
+template <OrderType side>
+void OrderBook::adaptLevelStorage() {
+    auto& sideLevels = getLevels<side>();
+    // A side with only a few levels is inline whatever its activity, keep its choice for when it grows
+    if(sideLevels.getStorage() == LevelStorage::inlineArrays)
+        return;
+
+    const Price best = sideLevels.getBestPrice();
+    const Price worst = sideLevels.getWorstPrice();
+    const std::int64_t priceWidth = (best > worst ? best - worst : worst - best).value() + 1;
+    const LevelStorage target = chooseLevelStorage(levelActivity, sideLevels.size(), priceWidth, sideLevels.getLargeStorage());
+    if(target == sideLevels.getLargeStorage())
+        return;
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t moved = sideLevels.setLargeStorage(target);
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    ++levelMigrationStats.migrations;
+    levelMigrationStats.levelsMoved += moved;
+    levelMigrationStats.totalNanoseconds += nanoseconds;
+    levelMigrationStats.maxNanoseconds = std::max<std::int64_t>(levelMigrationStats.maxNanoseconds, nanoseconds);
+}
+
+void OrderBook::publishMarketData() {
+    // Only rebuilt once a depth change lands inside what was last published
+    if(!publishedDepthChanged)
+        return;
+    publishedDepthChanged = false;
+
+    const BookSnapshot snapshot = getSnapshot();
+    if(snapshot == lastSnapshot)
+        return;
+
+    lastSnapshot = snapshot;
+    publishedSnapshot.write(snapshot);
+
+    const TopOfBook topOfBook = snapshot.getTopOfBook();
+    if(topOfBook == lastTopOfBook)
+        return;
+
+    lastTopOfBook = topOfBook;
+    topOfBookUpdates.publish(topOfBook);
+}
+
+auto setSessionState(std::span<OrderBook> books, SessionState state) -> std::size_t {
+    std::size_t moved = 0;
+    for(OrderBook& book : books)
+        moved += book.setSessionState(state) ? 1 : 0;
+    return moved;
 }
 
-}; // namespace Exchange
\ No newline at end of file
+}; // namespace Exchange
@@ -12,18 +12,35 @@
 #ifndef ORDERBOOK_HPP
 #define ORDERBOOK_HPP
 
+#include "auction.hpp"
+#include "bookSnapshot.hpp"
+#include "depthIndex.hpp"
 #include "limitPrice.hpp"
-#include <map>
+#include "levelStoragePolicy.hpp"
+#include "matchingRules.hpp"
+#include "priceBands.hpp"
+#include "orderIndex.hpp"
+#include "priceLevels.hpp"
+#include "riskLedger.hpp"
+#include "sessionState.hpp"
+#include "sideTraits.hpp"
+#include "simulatedExecution.hpp"
+#include "topOfBook.hpp"
+#include "volumeHistory.hpp"
 #include <optional>
-#include <unordered_map>
+#include <span>
+#include <vector>
 
 namespace Exchange {
 
 /**
  * @brief Limit order book data structure
  *  
- * Holds buy and sell trees of limit prices, as well as unordered maps
- * mapping IDs to orders, and prices to limits.
+ * Holds the sorted buy and sell levels of limit prices, a pool of the orders resting in them,
+ * and flat tables mapping IDs to orders and prices to traded volume.
+ * 
+ * An OrderBook is owned by a single writer thread. The only members safe to call from other threads
+ * are getTopOfBookUpdates and getPublishedSnapshot, which never block the writer.
  */
 struct OrderBook {
     /**
@@ -32,6 +49,13 @@ struct OrderBook {
      */
     OrderBook() = default;
 
+    /**
+     * @brief Construct an empty OrderBook object that shares fills between resting orders by the given rules
+     * 
+     * @param matchingRules Price-time or pro-rata matching, and the pro-rata variant
+     */
+    explicit OrderBook(const MatchingRules &matchingRules) : matchingRules{matchingRules} {}
+
     /**
      * @brief Adds a new order to the OrderBook
      * 
@@ -39,18 +63,181 @@ struct OrderBook {
      * @param shares        Number of shares
      * @param limitPrice    Price of Order
      * @param timeInForce   Time until order expires TODO: Make meaningful
-     * @return OrderExecution, containing order's unique ID, and info about any orders executed by adding this order
+     * @return OrderExecution, containing order's unique ID, and info about any orders executed by adding this order,
+     *         or RejectReason::invalidQuantity if shares isn't positive. See addOrder(const OrderRequest&) for
+     *         books outside continuous trading.
+     */
+    auto addOrder(OrderType orderType, Qty shares, Price limitPrice,
+                  int timeInForce = 0) -> Result<OrderExecution>;
+
+    /**
+     * @brief Adds a new order to the OrderBook, along with the details that are only kept for reporting
+     * 
+     * @param request Order to add
+     * @return OrderExecution, containing order's unique ID, and info about any orders executed by adding this order,
+     *         or RejectReason::invalidQuantity if shares isn't positive. A halted book only returns the ID, or
+     *         RejectReason::haltQueueFull, and a closed one RejectReason::sessionClosed. RejectReason::outsidePriceBand
+     *         if the limit price is outside the static price band, and with a risk ledger set, any rejection
+     *         RiskLedger::reserve gives. A sweep stops at the dynamic price band, cancelling the shares it has left.
+     *         RejectReason::postOnlyWouldCross if the order is post-only and would cross without asking to be
+     *         repriced, see OrderFlags. RejectReason::selfTradeUnsupported if the order sets self-trade
+     *         prevention on a pro-rata book.
      */
-    auto addOrder(OrderType orderType, int shares, int limitPrice,
-                  int timeInForce = 0) -> OrderExecution;
+    auto addOrder(const OrderRequest &request) -> Result<OrderExecution>;
+
+    /**
+     * @brief Work out what addOrder would execute for an order right now, without changing the book or allocating
+     * 
+     * Self-trade prevention isn't simulated, orders asking for it are rejected. The sweep stops at the
+     * dynamic price band as addOrder's would, and post-only or minimum quantity orders that couldn't trade don't.
+     * Hidden orders are traded against like any other.
+     * 
+     * @param request   Order to simulate
+     * @param filledIds Buffer for the ids of the resting orders that would be filled completely, in time priority.
+     *                  Ids past its size are counted but not recorded.
+     * @return The would-be execution, RejectReason::invalidQuantity if shares isn't positive,
+     *         RejectReason::outsidePriceBand if the limit price is outside the static price band, or
+     *         RejectReason::selfTradeUnsupported if the order sets self-trade prevention
+     */
+    [[nodiscard]] auto simulateOrder(const OrderRequest &request, std::span<int> filledIds = {}) const
+        -> Result<SimulatedExecution>;
+
+    /**
+     * @brief Work out what addOrder would execute for an order right now, without changing the book or allocating
+     * 
+     * @param orderType     Buy or sell
+     * @param shares        Number of shares
+     * @param limitPrice    Price of Order
+     * @param filledIds     Buffer for the ids of the resting orders that would be filled completely
+     * @return The would-be execution, or RejectReason::invalidQuantity if shares isn't positive
+     */
+    [[nodiscard]] auto simulateOrder(OrderType orderType, Qty shares, Price limitPrice,
+                                     std::span<int> filledIds = {}) const -> Result<SimulatedExecution>;
 
     /**
      * @brief Cancel order with given orderId
      * 
      * @param orderId OrderId to cancel
-     * @warning Doesn't check to make sure orderId exists
+     * @return Nothing on success, or RejectReason::unknownOrderId if no resting order has the given orderId
+     *         (routine when a cancel races a fill). A halted book queues the cancel, returning nothing, or
+     *         RejectReason::haltQueueFull.
+     */
+    auto cancelOrder(int orderId) -> Result<void>;
+
+    /**
+     * @brief Cancel the order a handle refers to, without looking up its ID
+     * 
+     * @param handle Handle from OrderExecution::getRestingHandle
+     * @return Nothing on success, or RejectReason::unknownOrderId if the handle is stale, i.e. the order
+     *         already filled or was cancelled. A halted book queues the cancel, as cancelOrder(int) does.
+     */
+    auto cancelOrder(OrderHandle handle) -> Result<void>;
+
+    /**
+     * @brief Cancel every resting order of an account, in time to the number of its orders rather than the book's
+     * 
+     * Used to cancel on disconnect, so it applies straight away even while halted, and drops the account's queued
+     * orders too.
+     * 
+     * @param accountId Account to cancel, orders sent with noAccount can't be mass cancelled
+     * @return Number of orders cancelled
+     */
+    auto cancelAccountOrders(std::uint32_t accountId) -> std::size_t;
+
+    /**
+     * @brief Cancel every resting order of an account on one side
+     * 
+     * @param accountId Account to cancel
+     * @param side      Side to cancel
+     * @return Number of orders cancelled
+     */
+    auto cancelAccountOrders(std::uint32_t accountId, OrderType side) -> std::size_t;
+
+    /**
+     * @brief Cancel every resting order of an account on one side, with a limit price in a range
+     * 
+     * @param accountId Account to cancel
+     * @param side      Side to cancel
+     * @param minPrice  Lowest limit price to cancel
+     * @param maxPrice  Highest limit price to cancel
+     * @return Number of orders cancelled
+     */
+    auto cancelAccountOrders(std::uint32_t accountId, OrderType side, Price minPrice, Price maxPrice) -> std::size_t;
+
+    /**
+     * @brief Move the book to another trading session state
+     * 
+     * In preOpen and auction, orders rest without matching. In halted, orders and cancels are queued in a buffer
+     * allocated once, and replayed in arrival order when the book leaves halted, see getReplayedExecutions. Orders
+     * still queued when a halted book closes are dropped, and those the static price band has moved away from
+     * while halted are cancelled on replay. In closed, new orders are rejected.
+     * 
+     * @param state State to move to
+     * @return Nothing on success, RejectReason::invalidTransition if isValidTransition forbids the move, or
+     *         RejectReason::bookCrossed if moving to continuous while the book is crossed, see uncrossAuction
+     */
+    auto setSessionState(SessionState state) -> Result<void>;
+
+    /**
+     * @brief Check every order against its account's limits before it reaches the book, and keep the ledger's
+     * counters in step with the book's fills and cancels
+     * 
+     * The ledger is shared with the other books its accounts trade on, and must outlive the book or be unset.
+     * Set it before the book takes orders, as orders already resting were never counted.
+     * 
+     * @param ledger Ledger to check against, or nullptr to stop checking
+     */
+    void setRiskLedger(RiskLedger *ledger);
+
+    /**
+     * @brief Set the book's price bands, a static collar orders must be priced inside, and a dynamic band sweeps
+     * stop at
+     * 
+     * @param rules             Widths of both bands
+     * @param referencePrice    Centre of the static band, and of the dynamic band until the book first trades
+     */
+    void setPriceBands(const PriceBandRules &rules, Price referencePrice);
+
+    /**
+     * @brief Get the book's price bands, as of its last trade
+     * 
+     * @return Edges of both bands
+     */
+    [[nodiscard]] auto getPriceBands() const -> const PriceBands&;
+
+    /**
+     * @brief Get the trading session state the book is in
+     * 
+     * @return Current state, continuous for a new book
+     */
+    [[nodiscard]] auto getSessionState() const -> SessionState;
+
+    /**
+     * @brief Get what the orders queued during the last halt executed when they were replayed
+     * 
+     * @return One execution per queued order, in arrival order, valid until the book is next halted
+     */
+    [[nodiscard]] auto getReplayedExecutions() const -> std::span<const OrderExecution>;
+
+    /**
+     * @brief Get the price the book would uncross at right now, without trading
+     * 
+     * @param referencePrice Price that breaks ties market pressure leaves, usually the last traded price
+     * @return The would-be uncross, or std::nullopt if the book isn't crossed
+     */
+    [[nodiscard]] auto getIndicativeUncross(Price referencePrice) const -> std::optional<AuctionUncross>;
+
+    /**
+     * @brief Trade every crossed share that can trade at a single price, and move to continuous matching
+     * 
+     * Within the level at the uncrossing price, shares are allocated by the book's matching rules.
+     * The book moves to continuous through setSessionState, even if it wasn't crossed.
+     * 
+     * @param referencePrice Price that breaks ties market pressure leaves, usually the last traded price
+     * @return The uncross and the resting orders it filled on each side, reported under one new order ID, or
+     *         RejectReason::invalidTransition unless the book is in preOpen or auction
      */
-    void cancelOrder(int orderId);
+    auto uncrossAuction(Price referencePrice) -> Result<AuctionResult>;
 
     /**
      * @brief Get the volume at a specific limit price
@@ -58,79 +245,571 @@ struct OrderBook {
      * @param price LimitPrice to check
      * @return Number of shares traded at a given limit
      */
-    [[nodiscard]] auto getVolumeAtLimit(int price) const -> int;
+    [[nodiscard]] auto getVolumeAtLimit(Price price) const -> Qty;
+
+    /**
+     * @brief Get the shares an order could trade right now, at its limit price or better
+     * 
+     * Counts hidden orders, as matching trades with them, so answers are for the book's own checks and aren't to be
+     * published.
+     * 
+     * @param side          Side of the order asking
+     * @param limitPrice    Worst price the order would accept
+     * @return Shares resting on the opposite side at limitPrice or better
+     */
+    [[nodiscard]] auto getAvailableShares(OrderType side, Price limitPrice) const -> Qty;
+
+    /**
+     * @brief Get the worst price an order for a number of shares would trade at right now
+     * 
+     * Counts hidden orders, as getAvailableShares does.
+     * 
+     * @param side      Side of the order asking
+     * @param shares    Shares the order wants
+     * @return Price of the last level the order would reach, or std::nullopt if the opposite side doesn't hold
+     *         that many shares or shares isn't positive
+     */
+    [[nodiscard]] auto getImpactPrice(OrderType side, Qty shares) const -> std::optional<Price>;
 
     /**
-     * @brief Get the best bidding price
+     * @brief Get the request a resting order was accepted from
      * 
-     * @return Best bid (buying) price available, or std::nullopt if no buy order available
+     * @param orderId Id of the resting order
+     * @return The original request, or RejectReason::unknownOrderId if no resting order has the given orderId
      */
-    [[nodiscard]] auto getBestBid() const -> std::optional<int>;
+    [[nodiscard]] auto getOrderDetails(int orderId) const -> Result<ColdOrder>;
 
     /**
-     * @brief Get the best asking price
+     * @brief Get how many shares have time priority over a resting order at its price, in O(log n)
      * 
-     * @return Best ask (selling) price available, or std::nullopt if no sell order available
+     * @param orderId Id of the resting order
+     * @return Shares that would have to trade before the order does, or RejectReason::unknownOrderId
+     *         if no resting order has the given orderId
      */
-    [[nodiscard]] auto getBestAsk() const -> std::optional<int>;
+    [[nodiscard]] auto getQueuePosition(int orderId) const -> Result<Qty>;
+
+    /**
+     * @brief Get how many shares have time priority over the order a handle refers to, without looking up its ID
+     * 
+     * @param handle Handle from OrderExecution::getRestingHandle
+     * @return Shares that would have to trade before the order does, or RejectReason::unknownOrderId
+     *         if the handle is stale
+     */
+    [[nodiscard]] auto getQueuePosition(OrderHandle handle) const -> Result<Qty>;
+
+    /**
+     * @brief Get the best bidding price, as published. Levels holding only hidden orders are skipped.
+     * 
+     * @return Best bid (buying) price available, or std::nullopt if no buy order is displayed
+     */
+    [[nodiscard]] auto getBestBid() const -> std::optional<Price>;
+
+    /**
+     * @brief Get the best asking price, as published. Levels holding only hidden orders are skipped.
+     * 
+     * @return Best ask (selling) price available, or std::nullopt if no sell order is displayed
+     */
+    [[nodiscard]] auto getBestAsk() const -> std::optional<Price>;
 
     /**
      * @brief Get the total volume traded in this orderBook
      * 
      * @return Number of shares traded in orderBook
      */
-    [[nodiscard]] auto getTotalVolume() const -> int;
+    [[nodiscard]] auto getTotalVolume() const -> Qty;
+
+    /**
+     * @brief Get the current best bid and offer, along with the shares resting at each
+     * 
+     * @return TopOfBook snapshot of the current state of the orderBook
+     */
+    [[nodiscard]] auto getTopOfBook() const -> TopOfBook;
+
+    /**
+     * @brief Get the slot that top of book changes are published to
+     * 
+     * A new value is only published when the price or size at the best bid/ask changes.
+     * Readers that fall behind only ever see the most recent top of book.
+     * 
+     * @return Conflating slot holding the latest TopOfBook
+     */
+    [[nodiscard]] auto getTopOfBookUpdates() const -> const ConflatingSlot<TopOfBook>&;
+
+    /**
+     * @brief Build a snapshot of the best snapshotDepth levels of each side from the live book
+     * @warning Only call from the writer thread, use getPublishedSnapshot from other threads
+     * 
+     * @return BookSnapshot of the current state of the orderBook
+     */
+    [[nodiscard]] auto getSnapshot() const -> BookSnapshot;
+
+    /**
+     * @brief Get the latest snapshot published by the writer thread. Safe to call from any thread.
+     * 
+     * @return Consistent BookSnapshot as of the end of the last completed addOrder/cancelOrder
+     */
+    [[nodiscard]] auto getPublishedSnapshot() const -> BookSnapshot;
+
+    /**
+     * @brief Get where one side currently keeps its price levels
+     * 
+     * @param side Side to check
+     * @return Inline arrays, tree or ladder
+     */
+    [[nodiscard]] auto getLevelStorage(OrderType side) const -> LevelStorage;
+
+    /**
+     * @brief Get how often, and at what cost, the book has moved its levels between storages
+     * 
+     * @return Counters since the book was created
+     */
+    [[nodiscard]] auto getLevelMigrationStats() const -> const LevelMigrationStats&;
+
+    /**
+     * @brief Get the rules this book shares fills between resting orders by
+     * 
+     * @return Rules the book was created with
+     */
+    [[nodiscard]] auto getMatchingRules() const -> const MatchingRules&;
 
   private:
+    /// @brief A live price level, along with the side it's on
+    struct Level {
+        LimitPrice limit;
+        OrderType side;
+    };
+
+    /// @brief An order or cancel sent while the book was halted, replayed once it resumes
+    struct QueuedCommand {
+        /// @brief What to replay
+        enum class Kind : std::uint8_t { add, cancelById, cancelByHandle };
+
+        Kind kind;
+        /// @brief Id given to the order when it was queued, or the id to cancel
+        int orderId;
+        /// @brief Handle to cancel, only for cancelByHandle
+        OrderHandle handle;
+        /// @brief Order to add, only for add
+        OrderRequest request;
+    };
+
+    /**
+     * @brief Handle an order sent outside continuous trading, off the path continuous orders take
+     * 
+     * @param request Order to add, with positive shares
+     * @return As addOrder(const OrderRequest&)
+     */
+    auto addOrderOutOfSession(const OrderRequest &request) -> Result<OrderExecution>;
+
+    /**
+     * @brief Queue a command while halted, without allocating
+     * 
+     * @param command Command to replay
+     * @return Nothing, or RejectReason::haltQueueFull if haltQueueCapacity commands are already queued
+     */
+    auto queueCommand(const QueuedCommand &command) -> Result<void>;
+
+    /**
+     * @brief Replay every queued command in the book's new state, publishing market data once at the end
+     * 
+     */
+    void replayQueuedCommands();
+
+    /**
+     * @brief Rest a validated order without matching, as orders collected for an auction do
+     * 
+     * @param orderId   Id assigned to the order
+     * @param request   Order to rest
+     * @return OrderExecution holding only the order's ID and resting handle
+     */
+    auto restValidOrder(int orderId, const OrderRequest &request) -> OrderExecution;
+
+    /**
+     * @brief Reject a post-only order that would cross, or add it repriced one tick behind the best displayed
+     * contra price
+     * 
+     * @param request Post-only order that would cross
+     * @return As addOrder(const OrderRequest&)
+     */
+    auto addCrossingPostOnlyOrder(const OrderRequest &request) -> Result<OrderExecution>;
+
+    /**
+     * @brief Replay a post-only order queued while halted that now crosses, repricing it as addOrder would
+     * 
+     * @param orderId ID the order was given when queued
+     * @param request Post-only order that would cross, already counted in the risk ledger at its own price
+     * @return The order's execution, all of it cancelled if it can't be repriced, or if its new price is outside
+     *         the static price band or breaches its account's limits
+     */
+    auto replayCrossingPostOnlyOrder(int orderId, const OrderRequest &request) -> OrderExecution;
+
+    /**
+     * @brief Cancel an order queued while halted that can no longer be replayed, releasing its risk
+     * 
+     * @param orderId ID the order was given when queued
+     * @param request Order as queued, counted in the risk ledger at its own price
+     * @return The order's execution, all of it cancelled
+     */
+    auto cancelQueuedOrder(int orderId, const OrderRequest &request) -> OrderExecution;
+
+    /**
+     * @brief Get the price a crossing post-only order rests at, dispatching on its side
+     * 
+     * @param request Post-only order that would cross
+     * @return As getPostOnlyPrice<side>
+     */
+    [[nodiscard]] auto getPostOnlyPrice(const OrderRequest &request) const -> Result<Price>;
+
+    /**
+     * @brief Get the price a crossing post-only order rests at, one tick behind the best displayed contra price
+     * 
+     * @tparam side Side of the order
+     * @param request Post-only order that would cross
+     * @return The new price, or RejectReason::postOnlyWouldCross if the order doesn't ask to be repriced, or
+     *         hidden orders would still cross it there
+     */
+    template <OrderType side>
+    [[nodiscard]] auto getPostOnlyPrice(const OrderRequest &request) const -> Result<Price>;
+
+    /**
+     * @brief Check if an order would cross the book, dispatching on its side
+     * 
+     * @param request Order to check
+     * @return True if its limit price crosses the best price of the opposite side
+     */
+    [[nodiscard]] auto wouldCross(const OrderRequest &request) const -> bool;
+
+    /**
+     * @brief Count an order in the risk ledger, if there is one
+     * 
+     * @param request Order about to reach the book
+     * @return Nothing, or why the ledger rejected the order
+     */
+    auto reserveRisk(const OrderRequest &request) -> Result<void>;
+
+    /**
+     * @brief Stop counting an order that was reserved but never reached the book, if there is a risk ledger
+     * 
+     * @param request Order dropped
+     */
+    void releaseRisk(const OrderRequest &request);
+
     /**
-     * @brief Adds an order given an order object
+     * @brief Adds a validated order. Dispatches once on the order's side, everything below is specialised on it.
      * 
-     * @param order Order to add to orderBook
+     * @param orderId   Id assigned to the order
+     * @param request   Order to add to orderBook
      * @return OrderExecution, containing order's unique ID, and info about any orders executed by adding this order 
      */
-    auto addOrder(const Order &order) -> OrderExecution;
+    auto addValidOrder(int orderId, const OrderRequest &request) -> OrderExecution;
 
     /**
-     * @brief Execute a given order against the existing orderBook
+     * @brief Adds an order on a side known at compile time
      * 
-     * @param order To execute in orderBook
+     * @tparam side Side of the order
+     * @param orderId   Id assigned to the order
+     * @param request   Order to add to orderBook
+     * @return OrderExecution, containing order's unique ID, and info about any orders executed by adding this order 
+     */
+    template <OrderType side>
+    auto addOrder(int orderId, const OrderRequest &request) -> OrderExecution;
+
+    /**
+     * @brief Execute a given order against the existing orderBook, resting whatever is left over
+     * 
+     * @tparam side Side of the order
+     * @param orderId   Id assigned to the order
+     * @param request   Order to execute in orderBook
      * @return OrderExecution, containing order's unique ID, and info about any orders executed by this order  
      */
-    auto executeOrder(const Order &order) -> OrderExecution;
+    template <OrderType side>
+    auto executeOrder(int orderId, const OrderRequest &request) -> OrderExecution;
+
+    /**
+     * @brief Trade shares against one level, keeping the book's indexes in step and removing the level if it empties
+     * 
+     * Traded volume is left to the caller, as an uncross trades every share against a level on both sides.
+     * 
+     * @tparam side Side of the level
+     * @param levelIndex            Best level of its side
+     * @param orderId               Id the trades are reported under
+     * @param shares                Shares to trade, at most the level's depth
+     * @param tradePrice            Price the shares trade at
+     * @param selfTradePrevention   What the order does on meeting its own account's orders
+     * @param accountId             Account of the order
+     * @return Execution against the level, by the book's matching rules
+     */
+    template <OrderType side>
+    auto executeLevel(LevelIndex levelIndex, int orderId, Qty shares, Price tradePrice,
+                      SelfTradePrevention selfTradePrevention, std::uint32_t accountId) -> OrderExecution;
+
+    /**
+     * @brief Trade shares against a side in price priority, all at one price, for an auction uncross
+     * 
+     * @tparam side Side of the resting orders
+     * @param orderId       Id the trades are reported under
+     * @param shares        Shares to trade, at most those resting at or better than tradePrice
+     * @param tradePrice    Uncrossing price
+     * @return Every trade made
+     */
+    template <OrderType side>
+    auto executeAuctionSide(int orderId, Qty shares, Price tradePrice) -> OrderExecution;
+
+    /**
+     * @brief Collect the shares of every crossed level of both sides, in ascending order of price
+     * 
+     * @return Levels to uncross, empty if the book isn't crossed
+     */
+    [[nodiscard]] auto collectAuctionLevels() const -> std::vector<AuctionLevel>;
+
+    /**
+     * @brief Walk the opposite side as executeOrder would, reading only
+     * 
+     * @tparam side Side of the order
+     * @param request   Order to simulate
+     * @param filledIds Buffer for the ids of completely filled orders
+     * @return The would-be execution
+     */
+    template <OrderType side>
+    [[nodiscard]] auto simulateOrder(const OrderRequest &request, std::span<int> filledIds) const -> SimulatedExecution;
+
+    /**
+     * @brief Rest an order in its level without trying to execute it
+     * 
+     * @tparam side Side of the order
+     * @param orderId   Id assigned to the order
+     * @param request   Order to rest
+     * @param shares    Number of shares left to rest
+     * @return Handle of the rested order
+     */
+    template <OrderType side>
+    auto restOrder(int orderId, const OrderRequest &request, Qty shares) -> OrderHandle;
+
+    /**
+     * @brief Cancel the orders of an account, resting or queued while halted, that a predicate picks
+     * 
+     * @param accountId     Account to cancel
+     * @param shouldCancel  Called with the side and limit price of each order, returns true to cancel it
+     * @return Number of orders cancelled
+     */
+    template <typename Predicate>
+    auto cancelAccountOrdersWhere(std::uint32_t accountId, Predicate shouldCancel) -> std::size_t;
+
+    /**
+     * @brief Take a resting order out of its level and free its slot, removing the level if it empties
+     * 
+     * @param slot Slot of the order, already removed from orderIndex
+     */
+    void removeRestingOrder(OrderSlot slot);
+
+    /**
+     * @brief Find the level at a price, creating it if there isn't one
+     * 
+     * @tparam side Side of the level
+     * @param price Price of the level
+     * @return Index of the level
+     */
+    template <OrderType side>
+    auto findOrCreateLevel(Price price) -> LevelIndex;
+
+    /**
+     * @brief Check if an order at the given price could execute against the opposite side right now
+     * 
+     * @tparam side Side of the order
+     * @param price Limit price of the order
+     * @return True if the best opposite level crosses price, false otherwise 
+     */
+    template <OrderType side>
+    [[nodiscard]] auto isExecutable(Price price) const -> bool;
+
+    /**
+     * @brief Check if an arriving order may execute right now, by its price and its OrderFlags
+     * 
+     * @tparam side Side of the order
+     * @param request Order to check
+     * @return True if it crosses and neither post-only nor short of its minimum quantity
+     */
+    template <OrderType side>
+    [[nodiscard]] auto isExecutable(const OrderRequest &request) const -> bool;
+
+    /**
+     * @brief Check if a minimum quantity order would trade at least its minimum on arrival
+     * 
+     * @tparam side Side of the order
+     * @param request Crossing order with OrderFlags::minimumQuantity
+     * @return True if minQuantity shares are in reach, not counting any self-trade prevention would take away
+     */
+    template <OrderType side>
+    [[nodiscard]] auto isMinimumQuantityInReach(const OrderRequest &request) const -> bool;
+
+    /**
+     * @brief Get the best level of one side that shows any shares in published depth
+     * 
+     * @tparam side Side to get
+     * @return Price and displayed shares of the level, or an empty PriceLevel if every order of the side is hidden
+     */
+    template <OrderType side>
+    [[nodiscard]] auto getBestDisplayedLevel() const -> PriceLevel;
+
+    /**
+     * @brief Get the levels of one side
+     * 
+     * @tparam side Side to get
+     * @return buyLevels or sellLevels
+     */
+    template <OrderType side>
+    [[nodiscard]] auto getLevels() -> PriceLevels<side>&;
+
+    /**
+     * @brief Get the levels of one side
+     * 
+     * @tparam side Side to get
+     * @return buyLevels or sellLevels
+     */
+    template <OrderType side>
+    [[nodiscard]] auto getLevels() const -> const PriceLevels<side>&;
+
+    /**
+     * @brief Get the best (highest bid or lowest ask) level of one side
+     * 
+     * @tparam side Side to get the best level of
+     * @return Index of the best level
+     * @warning Side must not be empty
+     */
+    template <OrderType side>
+    [[nodiscard]] auto getBestLevel() const -> LevelIndex;
+
+    /**
+     * @brief Remove a level from the live buy/sell levels, and free its index
+     * 
+     * @tparam side Side the level is on
+     * @param level Index of the level to delete
+     * @warning Doesn't check to see if level is in the buy/sell levels
+     */
+    template <OrderType side>
+    void removeLimit(LevelIndex level);
 
     /**
-     * @brief Check if an order is currently able to execute another order, given the state of the orderBook
+     * @brief Get the cumulative depth of one side
      * 
-     * @param order Order to check against existing OrderBook
-     * @return True if an existing order can fulfill the order being passed in, false otherwise 
+     * @tparam side Side to get
+     * @return buyDepth or sellDepth
      */
-    [[nodiscard]] auto isExecutable(const Order &order) const -> bool;
+    template <OrderType side>
+    [[nodiscard]] auto getDepthIndex() -> DepthIndex&;
 
     /**
-     * @brief Remove a limitMap from the active buy/sell maps and archive it
+     * @brief Record a change in the shares resting at a price, rebuilding the side's depth index if it
+     * doesn't cover the price. Sides still in their inline arrays keep no index.
      * 
-     * @param price         Price of limitMap to delete
-     * @param orderType     Whether it is a buying or selling limitMap
-     * @warning Doesn't check to see if limitMap exists in the buy/sell Map
+     * @tparam side Side of the level
+     * @param price     Price of the level
+     * @param shares    Change in its shares
      */
-    void removeLimitMap(int price, OrderType orderType);
+    template <OrderType side>
+    void updateDepth(Price price, Qty shares);
 
-    std::map<int, LimitPrice> buyMap;
-    std::map<int, LimitPrice> sellMap;
+    /**
+     * @brief Rebuild one side's depth index from its levels, or free it while the side is in its inline arrays
+     * 
+     * @tparam side Side to rebuild
+     */
+    template <OrderType side>
+    void rebuildDepthIndex();
+
+    /**
+     * @brief Count an add or cancel, and once per activity window reconsider how each side stores its levels,
+     * and retry disabled depth indexes. Called between events, so this never lands in the middle of matching.
+     * 
+     */
+    void recordLevelActivity();
+
+    /**
+     * @brief Move one side to the large storage its recent activity calls for, timing the move
+     * 
+     * @tparam side Side to reconsider
+     */
+    template <OrderType side>
+    void adaptLevelStorage();
 
-    // This is used when no more orders exist in a LimitPrice,
-    // Necessary in order to keep storing information about volume, etc
-    std::unordered_map<int, LimitPrice> archivedLimitMaps;
+    /**
+     * @brief Publish the depth snapshot and top of book to readers, if they changed since the last publish.
+     * Does nothing unless updateDepth saw a change inside the last published snapshot.
+     * 
+     */
+    void publishMarketData();
+
+    /**
+     * @brief Check if a depth change at a price could alter the published snapshot
+     * 
+     * @tparam side Side of the level
+     * @param price Price of the level
+     * @return True if the side published fewer than snapshotDepth levels, or price is no worse than its last one
+     */
+    template <OrderType side>
+    [[nodiscard]] auto isInPublishedDepth(Price price) const -> bool;
 
-    std::unordered_map<int, std::list<Order>::iterator> idToOrderIteratorMap;
-    
-    /// @brief Can avoid having 2 maps for buying and selling, as the ranges should never overlap
-    std::unordered_map<int, LimitPrice&> priceToLimitMap;
+    PriceLevels<OrderType::buy> buyLevels;
+    PriceLevels<OrderType::sell> sellLevels;
 
-    int totalVolume = 0;
+    MatchingRules matchingRules;
+
+    /// @brief Collar checked on every order, and the dynamic band every sweep is clamped to
+    PriceBands priceBands;
+
+    /// @brief Pre-trade risk checks, shared with other books and not owned, or nullptr to skip them
+    RiskLedger *riskLedger = nullptr;
+
+    /// @brief Trading session state, anything but continuous leaves addOrder's fast path
+    SessionState sessionState = SessionState::continuous;
+
+    /// @brief Storage for the levels of both sides, indexed by LevelIndex, with freed indices reused
+    std::vector<Level> levels;
+    std::vector<LevelIndex> freeLevels;
+
+    /// @brief Every resting order, split into the hot records matching walks and cold records kept for reporting
+    OrderPool orderPool;
+
+    /// @brief Shares traded at every price, kept apart from the live LimitPrices so empty levels can be destroyed
+    VolumeHistory volumeHistory;
+
+    /// @brief Resting shares by price of each side, for cumulative depth queries
+    DepthIndex buyDepth;
+    DepthIndex sellDepth;
+
+    /// @brief Activity over the current window, and the cost of every storage move made so far
+    LevelActivity levelActivity;
+    LevelMigrationStats levelMigrationStats;
+
+    /// @brief Slot of every resting order by ID, only needed when cancelling by ID instead of handle
+    OrderIndex orderIndex;
+
+    /// @brief Last values published to readers, used to detect changes
+    TopOfBook lastTopOfBook;
+    BookSnapshot lastSnapshot;
+    /// @brief Set by updateDepth when a change lands inside lastSnapshot, cleared on publish
+    bool publishedDepthChanged = false;
+
+    /// @brief Commands sent while halted, reserved to haltQueueCapacity on the first halt
+    std::vector<QueuedCommand> haltQueue;
+    std::vector<OrderExecution> replayedExecutions;
+
+    ConflatingSlot<TopOfBook> topOfBookUpdates;
+    Seqlock<BookSnapshot> publishedSnapshot;
+
+    Qty totalVolume = 0;
     int currentOrderId = 0;
 };
 
+/**
+ * @brief Move many books to the same session state in one pass, as a market-wide open, halt or close does
+ * 
+ * @param books Books to move
+ * @param state State to move them to
+ * @return Number of books that moved, the others keep their state as OrderBook::setSessionState rejected them
+ */
+auto setSessionState(std::span<OrderBook> books, SessionState state) -> std::size_t;
+
 } // namespace Exchange
 
 #endif
\ No newline at end of file
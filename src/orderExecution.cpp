@@ -11,17 +11,22 @@
 
 #include "orderExecution.hpp"
 #include "order.hpp"
-#include <stdexcept>
+#include <cassert>
 
 namespace Exchange {
 
-auto OrderExecution::operator+=(const OrderExecution &rhs) -> OrderExecution & {
+auto OrderExecution::merge(const OrderExecution &rhs) -> Result<void> {
   if (baseId != rhs.baseId)
-    throw std::invalid_argument(
-        "BaseID of added OrderExecutions must be equal");
+    return reject(RejectReason::mismatchedBaseId);
   if (partiallyFulfilledOrder && rhs.partiallyFulfilledOrder)
-    throw std::invalid_argument(
-        "2 added OrderExecutions can't both have partially fulfilled orders");
+    return reject(RejectReason::multiplePartialFills);
+
+  append(rhs);
+  return {};
+}
+
+void OrderExecution::append(const OrderExecution &rhs) {
+  assert(baseId == rhs.baseId && !(partiallyFulfilledOrder && rhs.partiallyFulfilledOrder));
 
   fulfilledOrderIds.insert(fulfilledOrderIds.end(),
                            rhs.fulfilledOrderIds.begin(),
@@ -32,27 +37,48 @@ auto OrderExecution::operator+=(const OrderExecution &rhs) -> OrderExecution & {
 
   if (rhs.partiallyFulfilledOrder)
     partiallyFulfilledOrder = rhs.partiallyFulfilledOrder;
+  otherPartialFills.insert(otherPartialFills.end(), rhs.otherPartialFills.begin(), rhs.otherPartialFills.end());
+
+  sharesCancelled += rhs.sharesCancelled;
+  selfTradeCancelledIds.insert(selfTradeCancelledIds.end(), rhs.selfTradeCancelledIds.begin(),
+                               rhs.selfTradeCancelledIds.end());
+  if (rhs.selfTradeDecrementedOrder)
+    selfTradeDecrementedOrder = rhs.selfTradeDecrementedOrder;
+}
 
-  return *this;
+void OrderExecution::executeOrder(const Order& order, Qty shares) {
+    const bool filledCompletely = shares >= order.getShares();
+    addFill(order.getOrderId(), order.getLimitPrice(), filledCompletely ? order.getShares() : shares, filledCompletely);
 }
 
-void OrderExecution::executeOrder(const Order& order) {
-    moneyExchanged += order.getLimitPrice() * order.getShares();
-    fulfilledOrderIds.push_back(order.getOrderId());
-    totalSharesExcecuted += order.getShares();
+void OrderExecution::addFill(int orderId, Price price, Qty shares, bool filledCompletely) {
+    moneyExchanged += price * shares;
+    totalSharesExcecuted += shares;
+
+    if(filledCompletely)
+        fulfilledOrderIds.push_back(orderId);
+    else if(partiallyFulfilledOrder)
+        otherPartialFills.emplace_back(orderId, shares);
+    else
+        partiallyFulfilledOrder = {orderId, shares};
+}
+
+void OrderExecution::addFullFills(Price price, Qty shares, std::span<const int> orderIds) {
+    moneyExchanged += price * shares;
+    totalSharesExcecuted += shares;
+    fulfilledOrderIds.insert(fulfilledOrderIds.end(), orderIds.begin(), orderIds.end());
 }
 
-void OrderExecution::executeOrder(const Order& order, int shares) {
-    if(shares >= order.getShares())
-        executeOrder(order);
-    else {
-        moneyExchanged += order.getLimitPrice() * shares;
-        partiallyFulfilledOrder = {order.getOrderId(), shares};
-        totalSharesExcecuted += shares;
-    }
+void OrderExecution::addSelfTradeCancel(int orderId, Qty shares, bool cancelledCompletely) {
+    if(cancelledCompletely)
+        selfTradeCancelledIds.push_back(orderId);
+    else
+        selfTradeDecrementedOrder = {orderId, shares};
 }
 
-auto OrderExecution::getTotalSharesExecuted() const -> int {
+void OrderExecution::cancelShares(Qty shares) { sharesCancelled += shares; }
+
+auto OrderExecution::getTotalSharesExecuted() const -> Qty {
   return totalSharesExcecuted;
 }
 
@@ -62,15 +88,37 @@ auto OrderExecution::hasPartialExecution() const -> bool {
 
 auto OrderExecution::getBaseId() const -> int { return baseId; }
 
-auto OrderExecution::getMoneyExchanged() const -> int { return moneyExchanged; }
+auto OrderExecution::getMoneyExchanged() const -> Notional { return moneyExchanged; }
 
 auto OrderExecution::getFulfilledOrderIds() const -> const std::vector<int> & {
   return fulfilledOrderIds;
 }
 
 auto OrderExecution::getPartiallyFulfilledOrder() const
-    -> const std::optional<std::pair<int, int>> & {
+    -> const std::optional<std::pair<int, Qty>> & {
   return partiallyFulfilledOrder;
 }
 
+auto OrderExecution::getOtherPartialFills() const -> const std::vector<std::pair<int, Qty>> & {
+  return otherPartialFills;
+}
+
+auto OrderExecution::getSharesCancelled() const -> Qty { return sharesCancelled; }
+
+auto OrderExecution::getSelfTradeCancelledIds() const -> const std::vector<int> & {
+  return selfTradeCancelledIds;
+}
+
+auto OrderExecution::getSelfTradeDecrementedOrder() const -> const std::optional<std::pair<int, Qty>> & {
+  return selfTradeDecrementedOrder;
+}
+
+auto OrderExecution::getRestingHandle() const -> std::optional<OrderHandle> {
+  return restingHandle;
+}
+
+void OrderExecution::setRestingHandle(OrderHandle handle) {
+  restingHandle = handle;
+}
+
 } // namespace Exchange
\ No newline at end of file
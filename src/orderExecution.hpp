@@ -12,7 +12,11 @@
 #ifndef ORDEREXECUTION_HPP
 #define ORDEREXECUTION_HPP
 
+#include "fixedPoint.hpp"
+#include "orderHandle.hpp"
+#include "result.hpp"
 #include <optional>
+#include <span>
 #include <utility>
 #include <vector>
 
@@ -38,9 +42,20 @@ struct OrderExecution {
      * @brief Adds another order to this OrderExecution, appending all fulfilled orders, summing money Exchanged, etc
      * 
      * @param rhs OrderExecution object to sum to this OrderExecution
-     * @return Reference to this OrderExecution object
+     * @return Nothing on success, RejectReason::mismatchedBaseId or RejectReason::multiplePartialFills
+     *         if the executions can't be combined, in which case this OrderExecution is unchanged
      */
-    auto operator+=(const OrderExecution &rhs) -> OrderExecution &;
+    [[nodiscard]] auto merge(const OrderExecution &rhs) -> Result<void>;
+
+    /**
+     * @brief Adds another execution of the same base order that is known to combine, as merge does without checking
+     * 
+     * For the book's own sweeps, where only the last level can leave an order partially filled.
+     * 
+     * @param rhs OrderExecution object to sum to this OrderExecution
+     * @warning rhs must have the same base ID, and this and rhs must not both have a partial execution
+     */
+    void append(const OrderExecution &rhs);
 
     /**
      * @brief Adds number of shares from order to this OrderExecution, or all shares in the order if shares > order.shares
@@ -48,14 +63,50 @@ struct OrderExecution {
      * @param order     Order to add to this execution
      * @param shares    Number of shares to execute from that order
      */
-    void executeOrder(const Order& order, int shares);
+    void executeOrder(const Order& order, Qty shares);
+
+    /**
+     * @brief Record shares traded against a resting order
+     * 
+     * @param orderId           Id of the resting order
+     * @param price             Price the shares traded at
+     * @param shares            Number of shares traded
+     * @param filledCompletely  True if the resting order has no shares left. Pro-rata matching can leave several
+     *                          orders partially filled, all but the first are kept as other partial fills.
+     */
+    void addFill(int orderId, Price price, Qty shares, bool filledCompletely);
+
+    /**
+     * @brief Record several resting orders filled completely at one price
+     * 
+     * @param price     Price the shares traded at
+     * @param shares    Total shares traded across the orders
+     * @param orderIds  Ids of the resting orders, in the order they were filled
+     */
+    void addFullFills(Price price, Qty shares, std::span<const int> orderIds);
+
+    /**
+     * @brief Record shares taken off a resting order of the base order's own account instead of trading
+     * 
+     * @param orderId               Id of the resting order
+     * @param shares                Shares taken off it
+     * @param cancelledCompletely   True if the resting order has no shares left
+     */
+    void addSelfTradeCancel(int orderId, Qty shares, bool cancelledCompletely);
+
+    /**
+     * @brief Record shares of the base order cancelled by self-trade prevention, which neither trade nor rest
+     * 
+     * @param shares Number of shares cancelled
+     */
+    void cancelShares(Qty shares);
 
     /**
      * @brief Get the total shares executed by this execution
      * 
      * @return Number of shares
      */
-    [[nodiscard]] auto getTotalSharesExecuted() const -> int;
+    [[nodiscard]] auto getTotalSharesExecuted() const -> Qty;
 
     /**
      * @brief Get if this execution has partially executed any order
@@ -74,9 +125,9 @@ struct OrderExecution {
     /**
      * @brief Get the amount of money exchanged by this execution
      * 
-     * @return Dollar amount
+     * @return Sum of price * shares over every execution, in 128 bits so it can't overflow
      */
-    [[nodiscard]] auto getMoneyExchanged() const -> int;
+    [[nodiscard]] auto getMoneyExchanged() const -> Notional;
 
     /**
      * @brief Get a vector all orders FULLY fulfilled by this object (no partial executions)
@@ -91,24 +142,68 @@ struct OrderExecution {
      * @return Pair of orderId and number of shares executed by the partial execution, or std::nullopt if no partial execution
      */
     [[nodiscard]] auto getPartiallyFulfilledOrder() const
-        -> const std::optional<std::pair<int, int>> &;
+        -> const std::optional<std::pair<int, Qty>> &;
 
-  private:
     /**
-     * @brief Fully executes the given order
+     * @brief Get the orders partially fulfilled after the first, which only pro-rata matching leaves
      * 
-     * @param order Order to fully execute
+     * @return Pairs of orderId and number of shares executed, in time priority
      */
-    void executeOrder(const Order& order);
+    [[nodiscard]] auto getOtherPartialFills() const -> const std::vector<std::pair<int, Qty>> &;
 
+    /**
+     * @brief Get the shares of the base order cancelled by self-trade prevention
+     * 
+     * @return Number of shares, 0 unless the base order met a resting order of its own account
+     */
+    [[nodiscard]] auto getSharesCancelled() const -> Qty;
+
+    /**
+     * @brief Get the resting orders self-trade prevention cancelled outright
+     * 
+     * @return Ids of the cancelled orders, in time priority
+     */
+    [[nodiscard]] auto getSelfTradeCancelledIds() const -> const std::vector<int> &;
+
+    /**
+     * @brief Get the resting order self-trade prevention decremented without cancelling it, if any
+     * 
+     * @return Pair of orderId and number of shares taken off, or std::nullopt
+     */
+    [[nodiscard]] auto getSelfTradeDecrementedOrder() const -> const std::optional<std::pair<int, Qty>> &;
+
+    /**
+     * @brief Get the handle of the base order, if any of it was left resting in the book
+     * 
+     * @return Handle to pass to OrderBook::cancelOrder, or std::nullopt if the base order didn't rest
+     */
+    [[nodiscard]] auto getRestingHandle() const -> std::optional<OrderHandle>;
+
+    /**
+     * @brief Record that the rest of the base order was left in the book
+     * 
+     * @param handle Handle of the resting order
+     */
+    void setRestingHandle(OrderHandle handle);
+
+  private:
     /// @brief ID of order that is being executed to start with
     int baseId;
-    int moneyExchanged = 0;
-    int totalSharesExcecuted = 0;
+    Notional moneyExchanged = 0;
+    Qty totalSharesExcecuted = 0;
     std::vector<int> fulfilledOrderIds;
 
     /// @brief Pair of orderId, and number of shares executed
-    std::optional<std::pair<int, int>> partiallyFulfilledOrder;
+    std::optional<std::pair<int, Qty>> partiallyFulfilledOrder;
+    /// @brief Kept apart from the first, so price-time matching never allocates for it
+    std::vector<std::pair<int, Qty>> otherPartialFills;
+
+    /// @brief Self-trade prevention's cancels, of the base order and of resting orders
+    Qty sharesCancelled = 0;
+    std::vector<int> selfTradeCancelledIds;
+    std::optional<std::pair<int, Qty>> selfTradeDecrementedOrder;
+
+    std::optional<OrderHandle> restingHandle;
 };
 
 } // namespace Exchange
@@ -0,0 +1,52 @@
+/**
+ * @file orderHandle.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the generation checked handle to a resting order
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ORDERHANDLE_HPP
+#define ORDERHANDLE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace Exchange {
+
+/// @brief Index of a resting order in an OrderPool
+using OrderSlot = std::uint32_t;
+
+/// @brief Marks the end of a list of slots
+constexpr OrderSlot noSlot = std::numeric_limits<OrderSlot>::max();
+
+/**
+ * @brief Names a resting order by its pool slot and the generation of that slot when the order was stored
+ *
+ * Plain integers rather than pointers, so handles can be persisted, restored and passed to other threads.
+ * Once the order leaves the book the slot's generation moves on, and the handle no longer matches.
+ * Generations wrap after 2^31 reuses of one slot, a handle held that long may alias a newer order.
+ */
+struct OrderHandle {
+    /// @brief Slot the order is stored in
+    OrderSlot slot = noSlot;
+    /// @brief Generation of the slot while it holds the order, always odd for a valid handle
+    std::uint32_t generation = 0;
+
+    /**
+     * @brief Handles are equal if they name the same slot and generation
+     *
+     * @return True if equal
+     */
+    auto operator==(const OrderHandle &) const -> bool = default;
+};
+
+static_assert(std::is_trivially_copyable_v<OrderHandle> && sizeof(OrderHandle) == 8);
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file orderIndex.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Implements OrderIndex member functions
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "orderIndex.hpp"
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+namespace Exchange {
+
+namespace {
+
+constexpr std::size_t initialCapacity = 16;
+
+/// @brief Number of low ID bits kept as they are, so runs of sequential IDs share a cache line of entries
+constexpr unsigned groupBits = 3;
+
+} // namespace
+
+auto OrderIndex::getHome(int orderId) const -> std::size_t {
+    // Fibonacci hashing on the ID's group, taking the top bits of the product to spread groups evenly across the
+    // table. IDs are handed out sequentially, so keeping each group together makes inserts miss cache once per group
+    // instead of on every order, while keeping clusters short (hashing IDs directly lines every resting order up in
+    // one giant cluster).
+    constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    constexpr std::uint32_t groupMask = (1U << groupBits) - 1;
+    const auto bits = static_cast<std::uint32_t>(orderId);
+    const auto group = static_cast<std::uint64_t>(bits >> groupBits);
+    return (static_cast<std::size_t>((group * multiplier) >> homeShift) << groupBits) | (bits & groupMask);
+}
+
+void OrderIndex::insert(int orderId, OrderSlot slot) {
+    // Keep load factor at or under 1/2 so probe sequences stay short
+    if((usedEntries + 1) * 2 > entries.size())
+        grow();
+
+    place(Entry{orderId, slot});
+    ++usedEntries;
+}
+
+auto OrderIndex::find(int orderId) const -> OrderSlot {
+    if(entries.empty())
+        return noSlot;
+
+    const std::size_t entry = findEntry(orderId);
+    return entry == entries.size() ? noSlot : entries[entry].slot;
+}
+
+auto OrderIndex::erase(int orderId) -> OrderSlot {
+    if(entries.empty())
+        return noSlot;
+
+    std::size_t hole = findEntry(orderId);
+    if(hole == entries.size())
+        return noSlot;
+    const OrderSlot erasedSlot = entries[hole].slot;
+
+    // Backward shift deletion: pull the rest of the cluster back by one, up to the first entry already at its home
+    const std::size_t mask = entries.size() - 1;
+    for(std::size_t next = (hole + 1) & mask; entries[next].slot != noSlot && getProbeDistance(next) != 0;
+        next = (next + 1) & mask) {
+        entries[hole] = entries[next];
+        hole = next;
+    }
+
+    entries[hole].slot = noSlot;
+    --usedEntries;
+    return erasedSlot;
+}
+
+auto OrderIndex::size() const -> std::size_t { return usedEntries; }
+
+auto OrderIndex::getProbeDistance(std::size_t entry) const -> std::size_t {
+    return (entry - getHome(entries[entry].orderId)) & (entries.size() - 1);
+}
+
+auto OrderIndex::findEntry(int orderId) const -> std::size_t {
+    const std::size_t mask = entries.size() - 1;
+    std::size_t entry = getHome(orderId);
+
+    // Entries of a cluster are ordered by home, so once they are closer to home than we would be, orderId is absent
+    for(std::size_t distance = 0; entries[entry].slot != noSlot && getProbeDistance(entry) >= distance; ++distance) {
+        if(entries[entry].orderId == orderId)
+            return entry;
+        entry = (entry + 1) & mask;
+    }
+
+    return entries.size();
+}
+
+void OrderIndex::place(Entry entry) {
+    const std::size_t mask = entries.size() - 1;
+    std::size_t position = getHome(entry.orderId);
+
+    // Robin Hood: take the place of any entry closer to its home than we are to ours, then carry on placing it
+    for(std::size_t distance = 0; entries[position].slot != noSlot; ++distance) {
+        const std::size_t existingDistance = getProbeDistance(position);
+        if(existingDistance < distance) {
+            std::swap(entry, entries[position]);
+            distance = existingDistance;
+        }
+        position = (position + 1) & mask;
+    }
+
+    entries[position] = entry;
+}
+
+void OrderIndex::grow() {
+    std::vector<Entry> oldEntries(entries.empty() ? initialCapacity : entries.size() * 2);
+    oldEntries.swap(entries);
+    homeShift = 64 - (static_cast<unsigned>(std::countr_zero(entries.size())) - groupBits);
+
+    for(const auto& entry : oldEntries)
+        if(entry.slot != noSlot)
+            place(entry);
+}
+
+} // namespace Exchange
@@ -0,0 +1,115 @@
+/**
+ * @file orderIndex.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the compact map from order ID to the slot the order rests in
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ORDERINDEX_HPP
+#define ORDERINDEX_HPP
+
+#include "orderHandle.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace Exchange {
+
+/**
+ * @brief Flat open addressing hash map from order ID to OrderSlot
+ *
+ * Each resting order costs 8 bytes per entry, at most 16 bytes at the maximum load factor, instead of a heap node
+ * per order. Uses Robin Hood linear probing, so lookups for missing IDs stop early, and erasing shifts the rest of
+ * the cluster back instead of leaving tombstones.
+ */
+struct OrderIndex {
+    /**
+     * @brief Map an order ID to its slot
+     *
+     * @param orderId   ID of the order, must not already be in the index
+     * @param slot      Slot the order rests in
+     */
+    void insert(int orderId, OrderSlot slot);
+
+    /**
+     * @brief Find the slot of an order
+     *
+     * @param orderId ID of the order
+     * @return Slot of the order, or noSlot if the ID isn't in the index
+     */
+    [[nodiscard]] auto find(int orderId) const -> OrderSlot;
+
+    /**
+     * @brief Remove an order from the index
+     *
+     * @param orderId ID of the order
+     * @return Slot the order was mapped to, or noSlot if the ID wasn't in the index
+     */
+    auto erase(int orderId) -> OrderSlot;
+
+    /**
+     * @brief Get the number of orders in the index
+     *
+     * @return Number of orders
+     */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+  private:
+    /// @brief An entry in the table, a slot of noSlot marks it as empty
+    struct Entry {
+        int orderId = 0;
+        OrderSlot slot = noSlot;
+    };
+
+    /**
+     * @brief Find the entry holding orderId
+     *
+     * @param orderId ID to look for
+     * @return Index into entries, or entries.size() if orderId isn't in the index
+     * @warning entries must not be empty
+     */
+    [[nodiscard]] auto findEntry(int orderId) const -> std::size_t;
+
+    /**
+     * @brief Get the entry an ID hashes to
+     *
+     * @param orderId ID to hash
+     * @return Index into entries
+     * @warning entries must not be empty
+     */
+    [[nodiscard]] auto getHome(int orderId) const -> std::size_t;
+
+    /**
+     * @brief Get how far an occupied entry is from the entry its ID hashes to
+     *
+     * @param entry Index of an occupied entry
+     * @return Number of entries past its home
+     */
+    [[nodiscard]] auto getProbeDistance(std::size_t entry) const -> std::size_t;
+
+    /**
+     * @brief Put an entry into the table, without checking the load factor or counting it
+     *
+     * @param entry Entry to place, its ID must not already be in the table
+     */
+    void place(Entry entry);
+
+    /**
+     * @brief Double the capacity of the table and rehash all entries
+     *
+     */
+    void grow();
+
+    std::vector<Entry> entries;
+    std::size_t usedEntries = 0;
+
+    /// @brief Shift taking the top bits of a hash product, so groups land in one of entries.size() / 8 places
+    unsigned homeShift = 0;
+};
+
+} // namespace Exchange
+
+#endif
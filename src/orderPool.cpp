@@ -0,0 +1,53 @@
+/**
+ * @file orderPool.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Implements OrderPool member functions
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "orderPool.hpp"
+
+namespace Exchange {
+
+auto OrderPool::allocate(const HotOrder &hot, const ColdOrder &cold) -> OrderSlot {
+    ++usedSlots;
+
+    OrderSlot slot = freeHead;
+    if(slot == noSlot) {
+        slot = static_cast<OrderSlot>(hotOrders.size());
+        hotOrders.push_back(hot);
+        hotOrders.back().generation = 1;
+        coldOrders.push_back(cold);
+    } else {
+        freeHead = hotOrders[slot].position;
+        const std::uint32_t generation = hotOrders[slot].generation + 1;
+        hotOrders[slot] = hot;
+        hotOrders[slot].generation = generation;
+        coldOrders[slot] = cold;
+    }
+
+    if(hot.accountId != noAccount)
+        accounts.link(slot, hot.accountId);
+    return slot;
+}
+
+void OrderPool::release(OrderSlot slot) {
+    --usedSlots;
+    if(hotOrders[slot].accountId != noAccount)
+        accounts.unlink(slot, hotOrders[slot].accountId);
+    ++hotOrders[slot].generation;
+    hotOrders[slot].position = freeHead;
+    freeHead = slot;
+}
+
+auto OrderPool::size() const -> std::size_t { return usedSlots; }
+
+auto OrderPool::getAllocatedBytes() const -> std::size_t {
+    return hotOrders.capacity() * sizeof(HotOrder) + coldOrders.capacity() * sizeof(ColdOrder);
+}
+
+} // namespace Exchange
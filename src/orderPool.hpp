@@ -0,0 +1,179 @@
+/**
+ * @file orderPool.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the pool storing resting orders split into hot and cold records
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ORDERPOOL_HPP
+#define ORDERPOOL_HPP
+
+#include "accountIndex.hpp"
+#include "chunkPool.hpp"
+#include "fixedPoint.hpp"
+#include "order.hpp"
+#include "orderHandle.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Exchange {
+
+/// @brief Index of a price level, owned by the OrderBook
+using LevelIndex = std::uint32_t;
+
+/**
+ * @brief The part of a resting order that matching reads and writes
+ *
+ * A level's queue only holds slots, a fill reads and writes these records and nothing else.
+ */
+struct HotOrder {
+    /// @brief Shares still resting
+    Qty shares = 0;
+    /// @brief Id reported when the order trades
+    int orderId = 0;
+    /// @brief Index of the order in its level's queue. Links free slots while the slot is unused.
+    std::uint32_t position = 0;
+    /// @brief Level the order rests in
+    LevelIndex level = 0;
+    /// @brief Bumped on every allocate and release of the slot, so it is odd exactly while the slot holds an order.
+    /// Maintained by the pool, the value passed to allocate is ignored.
+    std::uint32_t generation = 0;
+    /// @brief Account that sent the order, copied from the request so self-trade prevention never reads cold records.
+    /// Orders of any account but noAccount are linked into the pool's AccountIndex.
+    std::uint32_t accountId = noAccount;
+    /// @brief OrderFlags bits of the request, so matching never reads cold records for them
+    std::uint8_t flags = 0;
+};
+
+/// @brief The part of a resting order only read on acceptance and for reporting
+using ColdOrder = OrderRequest;
+
+// Two hot records per cache line, the fill loop should never pay for cold fields
+static_assert(sizeof(HotOrder) <= 32, "HotOrder must fit in half a cache line");
+static_assert(sizeof(ColdOrder) <= 64, "ColdOrder must fit in one cache line");
+
+/**
+ * @brief Stores resting orders as parallel arrays of hot and cold records, indexed by OrderSlot
+ *
+ * Slots are reused through a free list, so a steady state book never allocates. Every order is linked into its
+ * account's list on allocate and unlinked on release, whether it was filled or cancelled. Slots stay valid until released,
+ * but references into the pool are invalidated by allocate. An OrderHandle names a slot together with its
+ * generation, so a handle kept past its order's release is detected instead of reaching whatever reused the slot.
+ * The pool also owns the chunks the levels' queues of slots are built from.
+ */
+struct OrderPool {
+    /**
+     * @brief Store a new order
+     *
+     * @param hot   Matching state of the order
+     * @param cold  Request the order was accepted from
+     * @return Slot the order was stored in
+     */
+    auto allocate(const HotOrder &hot, const ColdOrder &cold) -> OrderSlot;
+
+    /**
+     * @brief Free a slot so it can be reused
+     *
+     * @param slot Slot to free
+     * @warning Slot must be allocated, and not linked into a level anymore
+     */
+    void release(OrderSlot slot);
+
+    /**
+     * @brief Get a handle to an allocated slot
+     *
+     * @param slot Allocated slot
+     * @return Handle that stays valid until the slot is released
+     */
+    [[nodiscard]] auto getHandle(OrderSlot slot) const -> OrderHandle {
+        return OrderHandle{slot, hotOrders[slot].generation};
+    }
+
+    /**
+     * @brief Check if a handle still refers to the order it was created for
+     *
+     * @param handle Handle to check, may be stale or default constructed
+     * @return True if the order is still in the pool
+     */
+    [[nodiscard]] auto isLive(OrderHandle handle) const -> bool {
+        // A slot's generation is only odd while allocated, so a matching odd generation means the same order
+        return handle.slot < hotOrders.size() && hotOrders[handle.slot].generation == handle.generation &&
+               (handle.generation & 1U) != 0;
+    }
+
+    /**
+     * @brief Get the hot record of an order
+     *
+     * @param slot Slot of the order
+     * @return Reference to the hot record
+     */
+    [[nodiscard]] auto getHot(OrderSlot slot) -> HotOrder & { return hotOrders[slot]; }
+
+    /**
+     * @brief Get the hot record of an order
+     *
+     * @param slot Slot of the order
+     * @return Reference to the hot record
+     */
+    [[nodiscard]] auto getHot(OrderSlot slot) const -> const HotOrder & { return hotOrders[slot]; }
+
+    /**
+     * @brief Get the cold record of an order
+     *
+     * @param slot Slot of the order
+     * @return Reference to the cold record
+     */
+    [[nodiscard]] auto getCold(OrderSlot slot) const -> const ColdOrder & { return coldOrders[slot]; }
+
+    /**
+     * @brief Get the chunks shared by every level queue holding this pool's orders
+     *
+     * @return Reference to the chunk pool
+     */
+    [[nodiscard]] auto getQueueChunks() -> ChunkPool & { return queueChunks; }
+
+    /**
+     * @brief Get the chunks shared by every level queue holding this pool's orders
+     *
+     * @return Reference to the chunk pool
+     */
+    [[nodiscard]] auto getQueueChunks() const -> const ChunkPool & { return queueChunks; }
+
+    /**
+     * @brief Get the lists of every account's orders, which the pool links and unlinks orders in as they come and go
+     *
+     * @return Reference to the account index
+     */
+    [[nodiscard]] auto getAccounts() const -> const AccountIndex & { return accounts; }
+
+    /**
+     * @brief Get the number of orders currently stored
+     *
+     * @return Number of allocated slots
+     */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    /**
+     * @brief Get the number of bytes the pool has reserved for orders, used or not
+     *
+     * @return Bytes of hot and cold records allocated
+     */
+    [[nodiscard]] auto getAllocatedBytes() const -> std::size_t;
+
+  private:
+    std::vector<HotOrder> hotOrders;
+    std::vector<ColdOrder> coldOrders;
+    OrderSlot freeHead = noSlot;
+    std::size_t usedSlots = 0;
+    ChunkPool queueChunks;
+    AccountIndex accounts;
+};
+
+} // namespace Exchange
+
+#endif
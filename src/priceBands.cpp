@@ -0,0 +1,61 @@
+/**
+ * @file priceBands.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Implements PriceBands member functions
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "priceBands.hpp"
+#include <algorithm>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+namespace Exchange {
+
+namespace {
+
+/// @brief Basis points in a whole
+constexpr std::int64_t basisPointsPerWhole = 10'000;
+
+/**
+ * @brief Get the edges of a band around a price
+ *
+ * @param centre        Price the band is centred on
+ * @param basisPoints   Width either side of centre, 0 for no band
+ * @return Lowest and highest price inside the band
+ */
+auto getEdges(Price centre, std::uint32_t basisPoints) -> std::pair<Price, Price> {
+    if(basisPoints == 0)
+        return {std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max()};
+
+    // Worked out in 128 bits and saturated to the prices an int64 holds, so a band of any width around any price
+    // can't overflow
+    const Int128 middle = centre.value();
+    const Int128 width = (middle < 0 ? -middle : middle) * basisPoints / basisPointsPerWhole;
+    const auto saturate = [](Int128 edge) {
+        return static_cast<std::int64_t>(std::clamp<Int128>(edge, std::numeric_limits<std::int64_t>::min(),
+                                                             std::numeric_limits<std::int64_t>::max()));
+    };
+    return {saturate(middle - width), saturate(middle + width)};
+}
+
+} // namespace
+
+void PriceBands::setRules(const PriceBandRules &bandRules, Price referencePrice) {
+    rules = bandRules;
+    std::tie(collarLow, collarHigh) = getEdges(referencePrice, rules.staticBasisPoints);
+    std::tie(dynamicLow, dynamicHigh) = getEdges(hasTraded ? lastTradePrice : referencePrice, rules.dynamicBasisPoints);
+}
+
+void PriceBands::recordTrade(Price tradePrice) {
+    lastTradePrice = tradePrice;
+    hasTraded = true;
+    std::tie(dynamicLow, dynamicHigh) = getEdges(tradePrice, rules.dynamicBasisPoints);
+}
+
+} // namespace Exchange
@@ -0,0 +1,117 @@
+/**
+ * @file priceBands.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the price bands limiting where a book's orders may be priced and trade
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef PRICEBANDS_HPP
+#define PRICEBANDS_HPP
+
+#include "fixedPoint.hpp"
+#include "order.hpp"
+#include "sideTraits.hpp"
+#include <cstdint>
+#include <limits>
+
+namespace Exchange {
+
+/// @brief Width of a book's price bands, in basis points either side of their centre, 0 for no band
+struct PriceBandRules {
+    /// @brief Collar around the reference price, orders priced outside it are rejected
+    std::uint32_t staticBasisPoints = 0;
+    /// @brief Band around the last trade, sweeps stop at its edge and cancel what they have left
+    std::uint32_t dynamicBasisPoints = 0;
+};
+
+/**
+ * @brief Static and dynamic price bands of one book, kept as precomputed edges
+ *
+ * Edges are only recomputed when the reference price is set or the book trades, once per order rather than once per
+ * level, so checking a price against a band is an integer compare. Until the book first trades, the dynamic band is
+ * centred on the reference price.
+ */
+struct PriceBands {
+    /**
+     * @brief Set the bands' widths and the reference price the static band is centred on
+     *
+     * @param rules             Widths of both bands
+     * @param referencePrice    Centre of the static band, usually the previous close
+     */
+    void setRules(const PriceBandRules &rules, Price referencePrice);
+
+    /**
+     * @brief Move the dynamic band to centre on a trade
+     *
+     * @param tradePrice Price the book last traded at
+     */
+    void recordTrade(Price tradePrice);
+
+    /**
+     * @brief Check if an order may be priced at a price
+     *
+     * @param price Limit price of the order
+     * @return True if price is inside the static band
+     */
+    [[nodiscard]] auto isInsideCollar(Price price) const -> bool { return price >= collarLow && price <= collarHigh; }
+
+    /**
+     * @brief Get the worst price an order on one side may trade at, the furthest edge of the dynamic band it can reach
+     *
+     * @tparam side Side of the order
+     * @param limitPrice Limit price of the order
+     * @return The order's limit price, or the band's edge if the limit price is beyond it
+     */
+    template <OrderType side> [[nodiscard]] auto getSweepLimit(Price limitPrice) const -> Price {
+        const Price edge = side == OrderType::buy ? dynamicHigh : dynamicLow;
+        return SideTraits<side>::crosses(limitPrice, edge) ? edge : limitPrice;
+    }
+
+    /**
+     * @brief Get the lowest price of the static band
+     *
+     * @return Lowest price an order may have
+     */
+    [[nodiscard]] auto getCollarLow() const -> Price { return collarLow; }
+
+    /**
+     * @brief Get the highest price of the static band
+     *
+     * @return Highest price an order may have
+     */
+    [[nodiscard]] auto getCollarHigh() const -> Price { return collarHigh; }
+
+    /**
+     * @brief Get the lowest price of the dynamic band
+     *
+     * @return Lowest price a sell may trade at
+     */
+    [[nodiscard]] auto getDynamicLow() const -> Price { return dynamicLow; }
+
+    /**
+     * @brief Get the highest price of the dynamic band
+     *
+     * @return Highest price a buy may trade at
+     */
+    [[nodiscard]] auto getDynamicHigh() const -> Price { return dynamicHigh; }
+
+  private:
+    PriceBandRules rules;
+
+    /// @brief Centre of the dynamic band once the book has traded
+    Price lastTradePrice = 0;
+    bool hasTraded = false;
+
+    Price collarLow = std::numeric_limits<std::int64_t>::min();
+    Price collarHigh = std::numeric_limits<std::int64_t>::max();
+    Price dynamicLow = std::numeric_limits<std::int64_t>::min();
+    Price dynamicHigh = std::numeric_limits<std::int64_t>::max();
+};
+
+} // namespace Exchange
+
+#endif
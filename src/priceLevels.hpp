@@ -0,0 +1,507 @@
+/**
+ * @file priceLevels.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the sorted prices of one side of a book, stored inline, in a tree or in a ladder
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef PRICELEVELS_HPP
+#define PRICELEVELS_HPP
+
+#include "fixedPoint.hpp"
+#include "levelStoragePolicy.hpp"
+#include "orderPool.hpp"
+#include "sideTraits.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace Exchange {
+
+/// @brief Number of levels a side holds inline before moving them to a tree or ladder
+inline constexpr std::size_t smallLevelCapacity = 8;
+
+/**
+ * @brief Prices of the live levels of one side, each mapped to the index of its level
+ *
+ * Most books only have a handful of levels, so those are kept inline in sorted arrays, prices in one cache line,
+ * and searched with a branch free scan. A side that outgrows the arrays moves into its large storage, and moves back
+ * once it has shrunk to half the inline capacity, so an idle book holds no heap memory for its levels.
+ *
+ * Large storage is either a tree, for levels spread sparsely over a wide range of prices, or a ladder indexed by
+ * price with a bitmap of live prices, for levels packed closely together. The book picks one from its activity,
+ * see chooseLevelStorage.
+ *
+ * @tparam side Side of the book, decides which price is best
+ */
+template <OrderType side> struct PriceLevels {
+    /**
+     * @brief Check if the side has no levels
+     *
+     * @return True if empty
+     */
+    [[nodiscard]] auto empty() const -> bool { return size() == 0; }
+
+    /**
+     * @brief Get the number of levels
+     *
+     * @return Number of prices held
+     */
+    [[nodiscard]] auto size() const -> std::size_t {
+        switch(storage) {
+        case LevelStorage::inlineArrays:
+            return smallSize;
+        case LevelStorage::tree:
+            return tree.size();
+        case LevelStorage::ladder:
+            return ladderSize;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Get where the levels are currently stored
+     *
+     * @return Current storage
+     */
+    [[nodiscard]] auto getStorage() const -> LevelStorage { return storage; }
+
+    /**
+     * @brief Get the storage used once the side outgrows the inline arrays
+     *
+     * @return LevelStorage::tree or LevelStorage::ladder
+     */
+    [[nodiscard]] auto getLargeStorage() const -> LevelStorage { return largeStorage; }
+
+    /**
+     * @brief Get the best price, the highest bid or the lowest ask
+     *
+     * @return Best price
+     * @warning Side must not be empty
+     */
+    [[nodiscard]] auto getBestPrice() const -> Price {
+        switch(storage) {
+        case LevelStorage::inlineArrays:
+            return smallPrices[smallSize - 1];
+        case LevelStorage::tree:
+            return tree.begin()->first;
+        case LevelStorage::ladder:
+            return ladderPrice(ladderBest);
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Get the worst price, the lowest bid or the highest ask
+     *
+     * @return Worst price
+     * @warning Side must not be empty. Scans the ladder's bitmap, so not meant for the matching path.
+     */
+    [[nodiscard]] auto getWorstPrice() const -> Price {
+        switch(storage) {
+        case LevelStorage::inlineArrays:
+            return smallPrices[0];
+        case LevelStorage::tree:
+            return tree.rbegin()->first;
+        case LevelStorage::ladder:
+            return ladderPrice(findWorstRung());
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Get the level at the best price
+     *
+     * @return Index of the best level
+     * @warning Side must not be empty
+     */
+    [[nodiscard]] auto getBestLevel() const -> LevelIndex {
+        switch(storage) {
+        case LevelStorage::inlineArrays:
+            return smallLevels[smallSize - 1];
+        case LevelStorage::tree:
+            return tree.begin()->second;
+        case LevelStorage::ladder:
+            return ladder[ladderBest];
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Find the level at a price, or make room for one
+     *
+     * @param price Price to look up
+     * @return Reference to the level index stored for price, and true if it was just inserted,
+     *         in which case the caller must set it. The reference is invalidated by the next insert or erase.
+     */
+    auto findOrInsert(Price price) -> std::pair<LevelIndex &, bool> {
+        if(storage == LevelStorage::tree) {
+            auto [position, isNew] = tree.try_emplace(price, 0);
+            return {position->second, isNew};
+        }
+        if(storage == LevelStorage::ladder)
+            return findOrInsertInLadder(price);
+
+        const std::size_t position = countWorseThan(price);
+        if(position < smallSize && smallPrices[position] == price)
+            return {smallLevels[position], false};
+
+        if(smallSize == smallLevelCapacity) {
+            moveTo(largeStorage);
+            return findOrInsert(price);
+        }
+
+        std::copy_backward(smallPrices.begin() + position, smallPrices.begin() + smallSize,
+                           smallPrices.begin() + smallSize + 1);
+        std::copy_backward(smallLevels.begin() + position, smallLevels.begin() + smallSize,
+                           smallLevels.begin() + smallSize + 1);
+        smallPrices[position] = price;
+        ++smallSize;
+        return {smallLevels[position], true};
+    }
+
+    /**
+     * @brief Remove the level at a price
+     *
+     * @param price Price of the level
+     * @warning A level must exist at price
+     */
+    void erase(Price price) {
+        switch(storage) {
+        case LevelStorage::inlineArrays: {
+            // Levels mostly empty from the best end, which is the end of the arrays
+            const std::size_t position = countWorseThan(price);
+            std::copy(smallPrices.begin() + position + 1, smallPrices.begin() + smallSize, smallPrices.begin() + position);
+            std::copy(smallLevels.begin() + position + 1, smallLevels.begin() + smallSize, smallLevels.begin() + position);
+            --smallSize;
+            return;
+        }
+        case LevelStorage::tree:
+            if(tree.begin()->first == price)
+                tree.erase(tree.begin());
+            else
+                tree.erase(price);
+            break;
+        case LevelStorage::ladder:
+            eraseFromLadder(price);
+            break;
+        }
+
+        if(size() <= smallLevelCapacity / 2)
+            moveTo(LevelStorage::inlineArrays);
+    }
+
+    /**
+     * @brief Choose the storage used once the side outgrows the inline arrays, moving to it now if already large
+     *
+     * @param target LevelStorage::tree or LevelStorage::ladder
+     * @return Number of levels moved, 0 if nothing had to move
+     */
+    auto setLargeStorage(LevelStorage target) -> std::size_t {
+        largeStorage = target;
+        if(storage == LevelStorage::inlineArrays || storage == target)
+            return 0;
+
+        const std::size_t moved = size();
+        moveTo(target);
+        return moved;
+    }
+
+    /**
+     * @brief Visit levels from the best price outwards
+     *
+     * @param maxLevels Most levels to visit
+     * @param visit     Called with the price and level index of each level visited
+     */
+    template <typename Visitor> void visitBestFirst(std::size_t maxLevels, Visitor &&visit) const {
+        visitBestFirstWhile([&](Price price, LevelIndex level) {
+            if(maxLevels == 0)
+                return false;
+            --maxLevels;
+            visit(price, level);
+            return true;
+        });
+    }
+
+    /**
+     * @brief Visit levels from the best price outwards until told to stop
+     *
+     * @param visit Called with the price and level index of each level visited, returns false to stop
+     */
+    template <typename Visitor> void visitBestFirstWhile(Visitor &&visit) const {
+        switch(storage) {
+        case LevelStorage::inlineArrays:
+            for(std::size_t i = smallSize; i > 0; --i)
+                if(!visit(smallPrices[i - 1], smallLevels[i - 1]))
+                    return;
+            return;
+        case LevelStorage::tree:
+            for(const auto &[price, level] : tree)
+                if(!visit(price, level))
+                    return;
+            return;
+        case LevelStorage::ladder:
+            if(ladderSize == 0)
+                return;
+            for(std::size_t i = ladderBest; i != noRung; i = nextWorse(i))
+                if(!visit(ladderPrice(i), ladder[i]))
+                    return;
+            return;
+        }
+    }
+
+  private:
+    /// @brief Orders the tree best price first
+    struct BestFirst {
+        auto operator()(Price lhs, Price rhs) const -> bool { return SideTraits<side>::isBetter(lhs, rhs); }
+    };
+
+    /// @brief Marks the end of a scan through the ladder
+    static constexpr std::size_t noRung = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief Count the inline prices worse than price, which is where price is or would go
+     *
+     * @param price Price to place
+     * @return Position of price in the arrays
+     */
+    [[nodiscard]] auto countWorseThan(Price price) const -> std::size_t {
+        // Scans the full arrays with no early exit, so the compiler can vectorise it
+        std::size_t count = 0;
+        for(std::size_t i = 0; i < smallLevelCapacity; ++i)
+            count += static_cast<std::size_t>(i < smallSize && SideTraits<side>::isBetter(price, smallPrices[i]));
+        return count;
+    }
+
+    /**
+     * @brief Move every level into another storage, freeing what the old one held
+     *
+     * @param target Storage to move to. A ladder falls back to the tree if the levels span maxLadderTicks or more.
+     */
+    void moveTo(LevelStorage target) {
+        const std::size_t count = size();
+        if(target == LevelStorage::ladder && count > 0) {
+            const Price low = std::min(getBestPrice(), getWorstPrice());
+            const Price high = std::max(getBestPrice(), getWorstPrice());
+            if(high.value() - low.value() >= maxLadderTicks)
+                target = LevelStorage::tree;
+            else if(target != storage)
+                resizeLadder(low, high);
+        }
+        if(target == storage)
+            return;
+
+        // Source and target are separate members, so levels can be copied across while visiting
+        std::size_t position = count;
+        visitBestFirst(count, [&](Price price, LevelIndex level) {
+            switch(target) {
+            case LevelStorage::inlineArrays:
+                // Arrays are best last
+                --position;
+                smallPrices[position] = price;
+                smallLevels[position] = level;
+                break;
+            case LevelStorage::tree:
+                // Visited best first, which is the tree's order
+                tree.emplace_hint(tree.end(), price, level);
+                break;
+            case LevelStorage::ladder:
+                setRung(static_cast<std::size_t>(price.value() - ladderBase.value()), level);
+                break;
+            }
+        });
+
+        switch(storage) {
+        case LevelStorage::inlineArrays:
+            smallSize = 0;
+            break;
+        case LevelStorage::tree:
+            tree.clear();
+            break;
+        case LevelStorage::ladder:
+            ladder = std::vector<LevelIndex>{};
+            ladderOccupied = std::vector<std::uint64_t>{};
+            ladderSize = 0;
+            break;
+        }
+
+        if(target == LevelStorage::inlineArrays)
+            smallSize = static_cast<std::uint32_t>(count);
+        storage = target;
+    }
+
+    /**
+     * @brief Get the price of a ladder rung
+     *
+     * @param rung Index into the ladder
+     * @return Price the rung stands for
+     */
+    [[nodiscard]] auto ladderPrice(std::size_t rung) const -> Price {
+        return ladderBase.value() + static_cast<std::int64_t>(rung);
+    }
+
+    /**
+     * @brief Store a level on an empty rung of the ladder
+     *
+     * @param rung  Index into the ladder, must be in range
+     * @param level Level to store
+     */
+    void setRung(std::size_t rung, LevelIndex level) {
+        ladder[rung] = level;
+        ladderOccupied[rung / 64] |= std::uint64_t{1} << (rung % 64);
+        if(ladderSize == 0 || SideTraits<side>::isBetter(ladderPrice(rung), ladderPrice(ladderBest)))
+            ladderBest = rung;
+        ++ladderSize;
+    }
+
+    /**
+     * @brief Find the worst live rung of the ladder
+     *
+     * @return Lowest live rung for bids, highest for asks
+     * @warning Ladder must not be empty
+     */
+    [[nodiscard]] auto findWorstRung() const -> std::size_t {
+        if constexpr(side == OrderType::buy) {
+            std::size_t word = 0;
+            while(ladderOccupied[word] == 0)
+                ++word;
+            return word * 64 + static_cast<std::size_t>(std::countr_zero(ladderOccupied[word]));
+        } else {
+            std::size_t word = ladderOccupied.size() - 1;
+            while(ladderOccupied[word] == 0)
+                --word;
+            return word * 64 + 63 - static_cast<std::size_t>(std::countl_zero(ladderOccupied[word]));
+        }
+    }
+
+    /**
+     * @brief Find the nearest live rung worse than a rung
+     *
+     * @param rung Live rung to start from, exclusive
+     * @return Live rung, or noRung if there is none
+     */
+    [[nodiscard]] auto nextWorse(std::size_t rung) const -> std::size_t {
+        if constexpr(side == OrderType::buy) {
+            // Bids get worse going down
+            if(rung == 0)
+                return noRung;
+            std::size_t word = (rung - 1) / 64;
+            std::uint64_t bits = ladderOccupied[word] & (~std::uint64_t{0} >> (63 - (rung - 1) % 64));
+            while(bits == 0) {
+                if(word == 0)
+                    return noRung;
+                bits = ladderOccupied[--word];
+            }
+            return word * 64 + 63 - static_cast<std::size_t>(std::countl_zero(bits));
+        } else {
+            // Asks get worse going up
+            const std::size_t start = rung + 1;
+            if(start >= ladder.size())
+                return noRung;
+            std::size_t word = start / 64;
+            std::uint64_t bits = ladderOccupied[word] & (~std::uint64_t{0} << (start % 64));
+            while(bits == 0) {
+                if(++word == ladderOccupied.size())
+                    return noRung;
+                bits = ladderOccupied[word];
+            }
+            return word * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+        }
+    }
+
+    /**
+     * @brief Rebuild the ladder to cover a range of prices with room to spare, keeping its live rungs
+     *
+     * @param low   Lowest price to cover
+     * @param high  Highest price to cover
+     */
+    void resizeLadder(Price low, Price high) {
+        const std::int64_t span = high.value() - low.value() + 1;
+        const std::int64_t slack = std::max<std::int64_t>(32, span / 4);
+        const std::size_t words = static_cast<std::size_t>(span + 2 * slack + 63) / 64;
+
+        std::vector<LevelIndex> oldLadder(words * 64);
+        std::vector<std::uint64_t> oldOccupied(words);
+        oldLadder.swap(ladder);
+        oldOccupied.swap(ladderOccupied);
+        const Price oldBase = ladderBase;
+        ladderBase = low.value() - slack;
+        ladderSize = 0;
+
+        for(std::size_t word = 0; word < oldOccupied.size(); ++word)
+            for(std::uint64_t bits = oldOccupied[word]; bits != 0; bits &= bits - 1) {
+                const std::size_t oldRung = word * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+                const std::int64_t price = oldBase.value() + static_cast<std::int64_t>(oldRung);
+                setRung(static_cast<std::size_t>(price - ladderBase.value()), oldLadder[oldRung]);
+            }
+    }
+
+    /**
+     * @brief findOrInsert for the ladder, growing it or giving up on it for the tree when the price is out of range
+     *
+     * @param price Price to look up
+     * @return Same as findOrInsert
+     */
+    auto findOrInsertInLadder(Price price) -> std::pair<LevelIndex &, bool> {
+        if(price < ladderPrice(0) || price >= ladderPrice(ladder.size())) {
+            const Price low = ladderSize == 0 ? price : std::min(price, std::min(getBestPrice(), getWorstPrice()));
+            const Price high = ladderSize == 0 ? price : std::max(price, std::max(getBestPrice(), getWorstPrice()));
+            if(high.value() - low.value() >= maxLadderTicks) {
+                moveTo(LevelStorage::tree);
+                return findOrInsert(price);
+            }
+            resizeLadder(low, high);
+        }
+
+        const auto rung = static_cast<std::size_t>(price.value() - ladderBase.value());
+        if((ladderOccupied[rung / 64] >> (rung % 64) & 1U) != 0)
+            return {ladder[rung], false};
+
+        setRung(rung, 0);
+        return {ladder[rung], true};
+    }
+
+    /**
+     * @brief erase for the ladder
+     *
+     * @param price Price of a live rung
+     */
+    void eraseFromLadder(Price price) {
+        const auto rung = static_cast<std::size_t>(price.value() - ladderBase.value());
+        ladderOccupied[rung / 64] &= ~(std::uint64_t{1} << (rung % 64));
+        --ladderSize;
+        if(rung == ladderBest && ladderSize > 0)
+            ladderBest = nextWorse(rung);
+    }
+
+    /// @brief Inline prices sorted worst first, so the busy best end is cheap to insert at and erase from
+    std::array<Price, smallLevelCapacity> smallPrices{};
+    /// @brief Level of each price in smallPrices
+    std::array<LevelIndex, smallLevelCapacity> smallLevels{};
+    std::uint32_t smallSize = 0;
+    LevelStorage storage = LevelStorage::inlineArrays;
+    LevelStorage largeStorage = LevelStorage::tree;
+
+    std::map<Price, LevelIndex, BestFirst> tree;
+
+    /// @brief Level of every rung, a rung's price is ladderBase plus its index. Only meaningful for occupied rungs.
+    std::vector<LevelIndex> ladder;
+    /// @brief One bit per rung, set if a level lives there
+    std::vector<std::uint64_t> ladderOccupied;
+    Price ladderBase = 0;
+    std::size_t ladderSize = 0;
+    std::size_t ladderBest = 0;
+};
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,249 @@
+/**
+ * @file result.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the Expected/Result types returned instead of throwing exceptions
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef RESULT_HPP
+#define RESULT_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <utility>
+
+namespace Exchange {
+
+/**
+ * @brief Why an operation was rejected
+ *
+ */
+enum class RejectReason : std::uint8_t {
+    invalidQuantity,      ///< Number of shares was zero or negative
+    unknownOrderId,       ///< No resting order has the given ID, e.g. it already filled or was cancelled
+    priceMismatch,        ///< Order added to a LimitPrice with a different price
+    insufficientDepth,    ///< Tried executing more shares than rest in a LimitPrice
+    mismatchedBaseId,     ///< Merged OrderExecutions belong to different base orders
+    multiplePartialFills, ///< Merged OrderExecutions both partially filled an order
+    sessionClosed,        ///< The book's session is closed to new orders
+    haltQueueFull,        ///< The book is halted and its queue of commands to replay is full
+    invalidTransition,    ///< The book can't move from its session state to the one requested
+    bookCrossed,          ///< Continuous trading can't start while the book is crossed, it must uncross first
+    unknownAccount,       ///< The order's account isn't in the book's risk ledger, or it was sent without one
+    orderTooLarge,        ///< The order's shares or notional exceed its account's limit for a single order
+    creditExceeded,       ///< The order would take its account's open orders past its credit limit
+    positionExceeded,     ///< The order could take its account's position past its limit if it filled
+    outsidePriceBand,     ///< The order's limit price is outside the book's static price band
+    postOnlyWouldCross,   ///< A post-only order would have taken liquidity on arrival
+    selfTradeUnsupported, ///< The order asks for self-trade prevention where it can't be applied
+};
+
+/**
+ * @brief Wraps an error so it can be implicitly converted into any Expected with that error type
+ *
+ * @tparam E Error type
+ */
+template <typename E> struct Unexpected {
+    /**
+     * @brief Construct a new Unexpected object
+     *
+     * @param error Error being returned
+     */
+    constexpr explicit Unexpected(E error) : error{error} {}
+
+    /// @brief Error being returned
+    E error;
+};
+
+/**
+ * @brief Either a value or the reason there isn't one
+ *
+ * Mirrors the subset of C++23's std::expected used by this project, which the C++20 toolchains we
+ * build with don't provide. Never throws, so the library can be built with -fno-exceptions.
+ *
+ * @tparam T Value type
+ * @tparam E Error type
+ */
+template <typename T, typename E> struct Expected {
+    /**
+     * @brief Construct holding a value
+     *
+     * @param value Value to hold
+     */
+    constexpr Expected(T value) : storedValue{std::move(value)} {}
+
+    /**
+     * @brief Construct holding an error
+     *
+     * @param unexpected Error to hold
+     */
+    constexpr Expected(Unexpected<E> unexpected)
+        : storedError{unexpected.error} {}
+
+    /**
+     * @brief Check if a value is held
+     *
+     * @return True if holding a value, false if holding an error
+     */
+    [[nodiscard]] constexpr auto has_value() const -> bool {
+        return storedValue.has_value();
+    }
+
+    /**
+     * @brief Check if a value is held
+     *
+     * @return True if holding a value, false if holding an error
+     */
+    constexpr explicit operator bool() const { return has_value(); }
+
+    /**
+     * @brief Get the held value
+     *
+     * @return Reference to the value
+     * @warning Aborts if holding an error, check has_value() first
+     */
+    constexpr auto value() & -> T & {
+        checkHasValue();
+        return *storedValue;
+    }
+
+    /**
+     * @brief Get the held value
+     *
+     * @return Reference to the value
+     * @warning Aborts if holding an error, check has_value() first
+     */
+    [[nodiscard]] constexpr auto value() const & -> const T & {
+        checkHasValue();
+        return *storedValue;
+    }
+
+    /**
+     * @brief Move out the held value
+     *
+     * @return The value
+     * @warning Aborts if holding an error, check has_value() first
+     */
+    constexpr auto value() && -> T {
+        checkHasValue();
+        return std::move(*storedValue);
+    }
+
+    /**
+     * @brief Get the held error
+     *
+     * @return The error, unspecified if holding a value
+     */
+    [[nodiscard]] constexpr auto error() const -> E { return storedError; }
+
+    /**
+     * @brief Access members of the held value
+     *
+     * @return Pointer to the value
+     * @warning Must be holding a value
+     */
+    constexpr auto operator->() -> T * { return &*storedValue; }
+
+    /**
+     * @brief Access members of the held value
+     *
+     * @return Pointer to the value
+     * @warning Must be holding a value
+     */
+    constexpr auto operator->() const -> const T * { return &*storedValue; }
+
+    /**
+     * @brief Get the held value
+     *
+     * @return Reference to the value
+     * @warning Must be holding a value
+     */
+    constexpr auto operator*() & -> T & { return *storedValue; }
+
+    /**
+     * @brief Get the held value
+     *
+     * @return Reference to the value
+     * @warning Must be holding a value
+     */
+    constexpr auto operator*() const & -> const T & { return *storedValue; }
+
+  private:
+    constexpr void checkHasValue() const {
+        if (!storedValue.has_value())
+            std::abort();
+    }
+
+    std::optional<T> storedValue;
+    E storedError{};
+};
+
+/**
+ * @brief Either success or the reason for failure
+ *
+ * @tparam E Error type
+ */
+template <typename E> struct Expected<void, E> {
+    /**
+     * @brief Construct holding success
+     *
+     */
+    constexpr Expected() = default;
+
+    /**
+     * @brief Construct holding an error
+     *
+     * @param unexpected Error to hold
+     */
+    constexpr Expected(Unexpected<E> unexpected)
+        : succeeded{false}, storedError{unexpected.error} {}
+
+    /**
+     * @brief Check if the operation succeeded
+     *
+     * @return True if successful, false if holding an error
+     */
+    [[nodiscard]] constexpr auto has_value() const -> bool {
+        return succeeded;
+    }
+
+    /**
+     * @brief Check if the operation succeeded
+     *
+     * @return True if successful, false if holding an error
+     */
+    constexpr explicit operator bool() const { return succeeded; }
+
+    /**
+     * @brief Get the held error
+     *
+     * @return The error, unspecified if successful
+     */
+    [[nodiscard]] constexpr auto error() const -> E { return storedError; }
+
+  private:
+    bool succeeded = true;
+    E storedError{};
+};
+
+/// @brief Result of a library operation, either a value or the RejectReason
+template <typename T> using Result = Expected<T, RejectReason>;
+
+/**
+ * @brief Shorthand for returning a rejection
+ *
+ * @param reason Why the operation was rejected
+ * @return Unexpected holding reason
+ */
+constexpr auto reject(RejectReason reason) -> Unexpected<RejectReason> {
+    return Unexpected<RejectReason>{reason};
+}
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @file riskLedger.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Implements RiskLedger member functions
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "riskLedger.hpp"
+#include <algorithm>
+
+namespace Exchange {
+
+namespace {
+
+/// @brief Largest value a 64-bit counter holds
+constexpr std::int64_t maxRaw = std::numeric_limits<std::int64_t>::max();
+
+/**
+ * @brief Get a limit notional in the raw units the counters use
+ *
+ * @param notional Limit to convert
+ * @return Its raw value, clamped to 64 bits
+ */
+auto clampToRaw(Notional notional) -> std::int64_t {
+    return static_cast<std::int64_t>(std::min<Int128>(notional.value(), maxRaw));
+}
+
+/**
+ * @brief Get what shares are worth at a price, in the raw units the counters use
+ *
+ * @param shares        Shares
+ * @param limitPrice    Price
+ * @return Raw notional, only meaningful if it was reserved, and so fits in 64 bits
+ */
+auto getRawNotional(Qty shares, Price limitPrice) -> std::int64_t {
+    return static_cast<std::int64_t>((limitPrice * shares).value());
+}
+
+} // namespace
+
+RiskLedger::RiskLedger(std::size_t accountCount) : accounts(accountCount) {}
+
+void RiskLedger::setLimits(std::uint32_t accountId, const RiskLimits &limits) {
+    AccountRisk &account = accounts[accountId];
+    account.maxOrderShares = limits.maxOrderShares.value();
+    account.maxOrderNotional = clampToRaw(limits.maxOrderNotional);
+    account.creditLimit = clampToRaw(limits.creditLimit);
+    account.maxPosition = limits.maxPosition.value();
+}
+
+auto RiskLedger::reserve(std::uint32_t accountId, OrderType side, Qty shares, Price limitPrice) -> Result<void> {
+    if(accountId >= accounts.size())
+        return reject(RejectReason::unknownAccount);
+    AccountRisk &account = accounts[accountId];
+
+    // Checks of the order alone touch no shared counter
+    const Notional orderNotional = limitPrice * shares;
+    if(shares.value() > account.maxOrderShares || orderNotional.value() > account.maxOrderNotional)
+        return reject(RejectReason::orderTooLarge);
+    const auto notional = static_cast<std::int64_t>(orderNotional.value());
+
+    const std::int64_t creditUsed = account.creditUsed.fetch_add(notional, std::memory_order_relaxed) + notional;
+    if(creditUsed > account.creditLimit) {
+        account.creditUsed.fetch_sub(notional, std::memory_order_relaxed);
+        return reject(RejectReason::creditExceeded);
+    }
+
+    // The position the account would reach if every open order on this side filled
+    const bool isBuy = side == OrderType::buy;
+    std::atomic<std::int64_t> &openShares = isBuy ? account.openBuys : account.openSells;
+    const std::int64_t open = openShares.fetch_add(shares.value(), std::memory_order_relaxed) + shares.value();
+    const std::int64_t position = account.position.load(std::memory_order_relaxed);
+    if((isBuy ? position + open : open - position) > account.maxPosition) {
+        openShares.fetch_sub(shares.value(), std::memory_order_relaxed);
+        account.creditUsed.fetch_sub(notional, std::memory_order_relaxed);
+        return reject(RejectReason::positionExceeded);
+    }
+
+    return {};
+}
+
+void RiskLedger::release(std::uint32_t accountId, OrderType side, Qty shares, Price limitPrice) {
+    AccountRisk &account = accounts[accountId];
+    (side == OrderType::buy ? account.openBuys : account.openSells).fetch_sub(shares.value(), std::memory_order_relaxed);
+    account.creditUsed.fetch_sub(getRawNotional(shares, limitPrice), std::memory_order_relaxed);
+}
+
+void RiskLedger::fill(std::uint32_t accountId, OrderType side, Qty shares, Price limitPrice) {
+    AccountRisk &account = accounts[accountId];
+    // Position moves before the open shares drop, so a racing reserve sees the fill's shares twice rather than not at all
+    account.position.fetch_add(side == OrderType::buy ? shares.value() : -shares.value(), std::memory_order_relaxed);
+    release(accountId, side, shares, limitPrice);
+}
+
+auto RiskLedger::getCreditUsed(std::uint32_t accountId) const -> Notional {
+    return accounts[accountId].creditUsed.load(std::memory_order_relaxed);
+}
+
+auto RiskLedger::getOpenShares(std::uint32_t accountId, OrderType side) const -> Qty {
+    const AccountRisk &account = accounts[accountId];
+    return (side == OrderType::buy ? account.openBuys : account.openSells).load(std::memory_order_relaxed);
+}
+
+auto RiskLedger::getPosition(std::uint32_t accountId) const -> Qty {
+    return accounts[accountId].position.load(std::memory_order_relaxed);
+}
+
+auto RiskLedger::size() const -> std::size_t { return accounts.size(); }
+
+} // namespace Exchange
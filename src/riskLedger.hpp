@@ -0,0 +1,150 @@
+/**
+ * @file riskLedger.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the per-account pre-trade risk limits and the counters they're checked against
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef RISKLEDGER_HPP
+#define RISKLEDGER_HPP
+
+#include "fixedPoint.hpp"
+#include "order.hpp"
+#include "result.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Exchange {
+
+/// @brief Limits an account's orders are checked against before they reach a book, unlimited by default
+struct RiskLimits {
+    /// @brief Most shares a single order may be for
+    Qty maxOrderShares = std::numeric_limits<std::int64_t>::max();
+    /// @brief Most a single order may be worth at its limit price
+    Notional maxOrderNotional = std::numeric_limits<std::int64_t>::max();
+    /// @brief Most the account's open orders may be worth together, at their limit prices
+    Notional creditLimit = std::numeric_limits<std::int64_t>::max();
+    /// @brief Largest long or short position the account could reach if all its open orders on one side filled
+    Qty maxPosition = std::numeric_limits<std::int64_t>::max();
+};
+
+/**
+ * @brief Pre-trade risk counters for a fixed set of accounts, shared by every book those accounts trade on
+ *
+ * Each account is one cache line of counters and limits, so books on different threads only contend when they
+ * trade for the same account, never through false sharing. Counters are updated with relaxed fetch-adds rather than
+ * a lock: reserve adds an order first and checks the sums it gets back, undoing the add if a limit is breached.
+ * Two racing reservations both see each other's shares, so a limit can only be undershot (one is rejected that
+ * would have fitted alone), never overshot.
+ *
+ * Notional counters are kept in 64-bit raw units, an order worth more than that is rejected as too large.
+ */
+struct RiskLedger {
+    /**
+     * @brief Construct a ledger with unlimited limits and nothing open for accounts 0 to accountCount - 1
+     *
+     * @param accountCount Number of accounts, account IDs index the ledger directly
+     */
+    explicit RiskLedger(std::size_t accountCount);
+
+    /**
+     * @brief Set an account's limits. Not synchronised with checks, call before its orders are sent.
+     *
+     * @param accountId Account to set
+     * @param limits    Limits to check its orders against
+     */
+    void setLimits(std::uint32_t accountId, const RiskLimits &limits);
+
+    /**
+     * @brief Check an order against its account's limits, and count it as open if it passes, in O(1)
+     *
+     * @param accountId     Account sending the order
+     * @param side          Buy or sell
+     * @param shares        Shares of the order, positive
+     * @param limitPrice    Limit price of the order
+     * @return Nothing if the order is now counted, otherwise RejectReason::unknownAccount, also for noAccount,
+     *         RejectReason::orderTooLarge, RejectReason::creditExceeded or RejectReason::positionExceeded
+     */
+    auto reserve(std::uint32_t accountId, OrderType side, Qty shares, Price limitPrice) -> Result<void>;
+
+    /**
+     * @brief Stop counting shares of an open order that were cancelled rather than traded
+     *
+     * @param accountId     Account of the order
+     * @param side          Buy or sell
+     * @param shares        Shares cancelled
+     * @param limitPrice    Limit price the shares were reserved at
+     */
+    void release(std::uint32_t accountId, OrderType side, Qty shares, Price limitPrice);
+
+    /**
+     * @brief Move shares of an open order that traded into the account's position
+     *
+     * @param accountId     Account of the order
+     * @param side          Buy or sell
+     * @param shares        Shares traded
+     * @param limitPrice    Limit price the shares were reserved at, whatever price they traded at
+     */
+    void fill(std::uint32_t accountId, OrderType side, Qty shares, Price limitPrice);
+
+    /**
+     * @brief Get what an account's open orders are worth at their limit prices
+     *
+     * @param accountId Account to check
+     * @return Credit in use
+     */
+    [[nodiscard]] auto getCreditUsed(std::uint32_t accountId) const -> Notional;
+
+    /**
+     * @brief Get the shares an account's open orders on one side are for
+     *
+     * @param accountId Account to check
+     * @param side      Side to check
+     * @return Open shares
+     */
+    [[nodiscard]] auto getOpenShares(std::uint32_t accountId, OrderType side) const -> Qty;
+
+    /**
+     * @brief Get an account's position from its fills
+     *
+     * @param accountId Account to check
+     * @return Shares bought less shares sold
+     */
+    [[nodiscard]] auto getPosition(std::uint32_t accountId) const -> Qty;
+
+    /**
+     * @brief Get the number of accounts the ledger holds
+     *
+     * @return Number of accounts
+     */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+  private:
+    /// @brief Counters and limits of one account, alone in their cache line
+    struct alignas(64) AccountRisk {
+        std::atomic<std::int64_t> creditUsed{0};
+        std::atomic<std::int64_t> openBuys{0};
+        std::atomic<std::int64_t> openSells{0};
+        std::atomic<std::int64_t> position{0};
+
+        /// @brief RiskLimits in raw units, with notionals clamped to 64 bits
+        std::int64_t maxOrderShares = std::numeric_limits<std::int64_t>::max();
+        std::int64_t maxOrderNotional = std::numeric_limits<std::int64_t>::max();
+        std::int64_t creditLimit = std::numeric_limits<std::int64_t>::max();
+        std::int64_t maxPosition = std::numeric_limits<std::int64_t>::max();
+    };
+    static_assert(sizeof(AccountRisk) == 64, "An account's risk should fill exactly one cache line");
+
+    std::vector<AccountRisk> accounts;
+};
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file seqlock.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for a single writer, many reader sequence lock
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Exchange {
+
+/**
+ * @brief Sequence lock holding one value of type T
+ *
+ * One thread writes, any number of threads read. The writer never blocks or waits on readers,
+ * while readers retry until they get a copy that wasn't torn by a concurrent write.
+ *
+ * The value is stored as an array of atomic words, so a reader racing the writer is well defined
+ * (and clean under ThreadSanitizer), the sequence number is what tells the reader to throw the copy away.
+ * Words are stored with release and loaded with acquire ordering rather than using fences: any word
+ * from an in-progress write is ordered after the odd sequence number, which the reader then sees on
+ * its second sequence load. On x86 these are plain moves.
+ *
+ * @tparam T Trivially copyable type of value being published
+ */
+template <typename T> struct Seqlock {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Seqlock can only hold trivially copyable types");
+
+    /**
+     * @brief Construct a Seqlock holding a default constructed T
+     *
+     */
+    Seqlock() { storeWords(T{}); }
+
+    /**
+     * @brief Publish a new value. Must only ever be called from one thread at a time.
+     *
+     * @param value Value to publish
+     */
+    void write(const T &value) {
+        const std::uint64_t start = sequence.load(std::memory_order_relaxed);
+        sequence.store(start + 1, std::memory_order_relaxed);
+
+        storeWords(value);
+
+        sequence.store(start + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Read a consistent copy of the latest value
+     *
+     * @return Latest published value
+     */
+    [[nodiscard]] auto read() const -> T {
+        std::uint64_t writeCount = 0;
+        return read(writeCount);
+    }
+
+    /**
+     * @brief Read a consistent copy of the latest value, and how many writes produced it
+     *
+     * @param writeCount Set to the number of writes completed before the returned value was read
+     * @return Latest published value
+     */
+    auto read(std::uint64_t &writeCount) const -> T {
+        std::array<std::uint64_t, wordCount> copy{};
+        std::uint64_t before = 0;
+        std::uint64_t after = 0;
+
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < wordCount; ++i)
+                copy[i] = words[i].load(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while (before != after || (before & 1) != 0);
+
+        writeCount = before / 2;
+
+        T value;
+        std::memcpy(static_cast<void *>(&value), copy.data(), sizeof(T));
+        return value;
+    }
+
+    /**
+     * @brief Get how many writes have completed
+     *
+     * @return Number of completed writes
+     */
+    [[nodiscard]] auto getWriteCount() const -> std::uint64_t {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+  private:
+    static constexpr std::size_t wordCount =
+        (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    void storeWords(const T &value) {
+        std::array<std::uint64_t, wordCount> copy{};
+        std::memcpy(copy.data(), &value, sizeof(T));
+        for (std::size_t i = 0; i < wordCount; ++i)
+            words[i].store(copy[i], std::memory_order_release);
+    }
+
+    /// @brief Odd while a write is in progress, incremented by 2 for every completed write
+    alignas(64) std::atomic<std::uint64_t> sequence{0};
+    std::array<std::atomic<std::uint64_t>, wordCount> words;
+};
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file sessionState.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the trading session states a book moves through over a day
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SESSIONSTATE_HPP
+#define SESSIONSTATE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace Exchange {
+
+/// @brief Phase of the trading day a book is in, deciding what happens to the orders sent to it
+enum class SessionState : std::uint8_t {
+    /// @brief Orders are entered and cancelled, and rest without matching ahead of the opening auction
+    preOpen,
+    /// @brief Orders rest without matching until the call auction uncrosses
+    auction,
+    /// @brief Orders match as they arrive
+    continuous,
+    /// @brief Trading is suspended, orders and cancels are queued and replayed once it resumes
+    halted,
+    /// @brief No new orders are accepted, cancels still are
+    closed
+};
+
+/// @brief Number of session states
+inline constexpr std::size_t sessionStateCount = 5;
+
+/// @brief Most orders and cancels a halted book queues, the rest are rejected until it resumes
+inline constexpr std::size_t haltQueueCapacity = 4096;
+
+/**
+ * @brief Check if a book may move from one session state to another
+ *
+ * A book opens through preOpen, may hold auctions from continuous trading, and may be halted from any state but
+ * closed. A closed book only reopens into preOpen. Staying in the same state is always allowed.
+ *
+ * @param from  Current state
+ * @param to    Requested state
+ * @return True if the transition is allowed
+ */
+constexpr auto isValidTransition(SessionState from, SessionState to) -> bool {
+    using enum SessionState;
+    // Bit n of each entry allows the move to state n
+    constexpr auto allow = [](std::initializer_list<SessionState> states) {
+        std::uint8_t mask = 0;
+        for(const SessionState state : states)
+            mask |= static_cast<std::uint8_t>(1U << static_cast<unsigned>(state));
+        return mask;
+    };
+    constexpr std::array<std::uint8_t, sessionStateCount> allowedTransitions{
+        allow({preOpen, auction, continuous, halted, closed}), // preOpen
+        allow({auction, continuous, halted, closed}),          // auction
+        allow({auction, continuous, halted, closed}),          // continuous
+        allow({preOpen, auction, continuous, halted, closed}), // halted
+        allow({preOpen, closed}),                              // closed
+    };
+    return ((allowedTransitions[static_cast<std::size_t>(from)] >> static_cast<unsigned>(to)) & 1U) != 0;
+}
+
+} // namespace Exchange
+
+#endif
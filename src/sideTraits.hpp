@@ -0,0 +1,88 @@
+/**
+ * @file sideTraits.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for compile time descriptions of the buy and sell sides of the book
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SIDETRAITS_HPP
+#define SIDETRAITS_HPP
+
+#include "fixedPoint.hpp"
+#include "order.hpp"
+
+namespace Exchange {
+
+/**
+ * @brief Price comparisons for one side of the book, so matching code can be specialised on the side
+ * at compile time instead of branching on OrderType in every loop iteration
+ *
+ * @tparam side Side the traits describe
+ */
+template <OrderType side> struct SideTraits;
+
+/**
+ * @brief Buyers want low prices, and better bids are higher
+ *
+ */
+template <> struct SideTraits<OrderType::buy> {
+    /// @brief Side that orders on this side trade against
+    static constexpr OrderType opposite = OrderType::sell;
+
+    /**
+     * @brief Check if an order on this side can trade against a resting order of the opposite side
+     *
+     * @param price         Limit price of the order on this side
+     * @param contraPrice   Price of the resting order on the opposite side
+     * @return True if the prices cross
+     */
+    static constexpr auto crosses(Price price, Price contraPrice) -> bool {
+        return price >= contraPrice;
+    }
+
+    /**
+     * @brief Check if one price on this side has priority over another
+     *
+     * @param lhs First price
+     * @param rhs Second price
+     * @return True if lhs is strictly better than rhs
+     */
+    static constexpr auto isBetter(Price lhs, Price rhs) -> bool { return lhs > rhs; }
+};
+
+/**
+ * @brief Sellers want high prices, and better asks are lower
+ *
+ */
+template <> struct SideTraits<OrderType::sell> {
+    /// @brief Side that orders on this side trade against
+    static constexpr OrderType opposite = OrderType::buy;
+
+    /**
+     * @brief Check if an order on this side can trade against a resting order of the opposite side
+     *
+     * @param price         Limit price of the order on this side
+     * @param contraPrice   Price of the resting order on the opposite side
+     * @return True if the prices cross
+     */
+    static constexpr auto crosses(Price price, Price contraPrice) -> bool {
+        return price <= contraPrice;
+    }
+
+    /**
+     * @brief Check if one price on this side has priority over another
+     *
+     * @param lhs First price
+     * @param rhs Second price
+     * @return True if lhs is strictly better than rhs
+     */
+    static constexpr auto isBetter(Price lhs, Price rhs) -> bool { return lhs < rhs; }
+};
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,62 @@
+/**
+ * @file simulatedExecution.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the fills an order would get, worked out without touching the book
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SIMULATEDEXECUTION_HPP
+#define SIMULATEDEXECUTION_HPP
+
+#include "fixedPoint.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace Exchange {
+
+/**
+ * @brief What OrderBook::addOrder would execute for an order right now, as returned by OrderBook::simulateOrder
+ *
+ * Holds no heap memory. Ids of the fully filled orders are written to a buffer the caller passes in,
+ * and only as many as fit are recorded, while filledOrders still counts all of them.
+ */
+struct SimulatedExecution {
+    /// @brief Shares the order would trade
+    Qty sharesExecuted = 0;
+    /// @brief Sum of price * shares over the trades
+    Notional moneyExchanged = 0;
+    /// @brief Number of price levels the order would trade at
+    std::uint32_t levelsTouched = 0;
+    /// @brief Number of resting orders that would be filled completely
+    std::size_t filledOrders = 0;
+    /// @brief Number of their ids written to the caller's buffer, the first filledIdsRecorded in time priority
+    std::size_t filledIdsRecorded = 0;
+    /// @brief Id of the resting order left partially filled and the shares it would trade, if any.
+    /// The first in time priority when pro-rata matching would leave several.
+    std::optional<std::pair<int, Qty>> partiallyFilledOrder;
+    /// @brief Number of resting orders that would be left partially filled, more than one only under pro-rata
+    std::size_t partiallyFilledOrders = 0;
+
+    /**
+     * @brief Get the average price the order would trade at
+     *
+     * @return Average price in whole currency units, or std::nullopt if it wouldn't trade
+     */
+    [[nodiscard]] auto getAveragePrice() const -> std::optional<double> {
+        if(sharesExecuted <= 0)
+            return {};
+        // Notional's raw units are price ticks times quantity lots, so dividing by lots leaves ticks
+        return static_cast<double>(moneyExchanged.value()) / static_cast<double>(sharesExecuted.value()) /
+               static_cast<double>(Price::unitsPerWhole);
+    }
+};
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file topOfBook.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the top-of-book (best bid/offer) snapshot and the conflating slot it is published to
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TOPOFBOOK_HPP
+#define TOPOFBOOK_HPP
+
+#include "fixedPoint.hpp"
+#include "seqlock.hpp"
+#include <cstdint>
+#include <optional>
+
+namespace Exchange {
+
+/**
+ * @brief Best bid and offer of an OrderBook, along with the number of shares resting at each
+ *
+ * A side with no orders has a share count of 0, in which case its price is meaningless.
+ */
+struct TopOfBook {
+    /// @brief Highest price anyone is buying at
+    Price bidPrice = 0;
+    /// @brief Shares resting at bidPrice
+    Qty bidShares = 0;
+    /// @brief Lowest price anyone is selling at
+    Price askPrice = 0;
+    /// @brief Shares resting at askPrice
+    Qty askShares = 0;
+
+    /**
+     * @brief Check if there is a best bid
+     *
+     * @return True if any buy order is resting, false otherwise
+     */
+    [[nodiscard]] auto hasBid() const -> bool { return bidShares > 0; }
+
+    /**
+     * @brief Check if there is a best ask
+     *
+     * @return True if any sell order is resting, false otherwise
+     */
+    [[nodiscard]] auto hasAsk() const -> bool { return askShares > 0; }
+
+    /**
+     * @brief Compare two snapshots field by field
+     *
+     * @param rhs TopOfBook to compare against
+     * @return True if both price and size on both sides are equal
+     */
+    auto operator==(const TopOfBook &rhs) const -> bool = default;
+};
+
+/**
+ * @brief Single value slot where the latest published value always wins
+ *
+ * The writer never waits on readers: publishing simply overwrites the previous value and bumps a sequence number.
+ * Readers keep their own cursor, so a slow reader skips straight to the newest value instead of queueing updates.
+ * Backed by a Seqlock, so readers may live on other threads than the single writer.
+ *
+ * @tparam T Trivially copyable type of value being published
+ */
+template <typename T> struct ConflatingSlot {
+    /**
+     * @brief Overwrite the slot with a new value. Must only be called from the writer thread.
+     *
+     * @param value Value to publish
+     */
+    void publish(const T &value) { slot.write(value); }
+
+    /**
+     * @brief Get the number of values published so far
+     *
+     * @return Sequence number of the latest value, 0 if nothing has been published
+     */
+    [[nodiscard]] auto getSequence() const -> std::uint64_t {
+        return slot.getWriteCount();
+    }
+
+    /**
+     * @brief Read the latest value, ignoring whether it has been seen before
+     *
+     * @return Latest published value, or a default constructed T if nothing has been published
+     */
+    [[nodiscard]] auto read() const -> T { return slot.read(); }
+
+    /**
+     * @brief Read the latest value only if it is newer than what this reader last saw
+     *
+     * @param lastSeenSequence  Reader's cursor, updated to the sequence of the returned value
+     * @return Latest value if one was published since lastSeenSequence, std::nullopt otherwise
+     */
+    [[nodiscard]] auto tryConsume(std::uint64_t &lastSeenSequence) const
+        -> std::optional<T> {
+        std::uint64_t sequence = 0;
+        T latest = slot.read(sequence);
+        if (sequence == lastSeenSequence)
+            return {};
+
+        lastSeenSequence = sequence;
+        return latest;
+    }
+
+  private:
+    Seqlock<T> slot;
+};
+
+} // namespace Exchange
+
+#endif
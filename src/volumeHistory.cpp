@@ -0,0 +1,78 @@
+/**
+ * @file volumeHistory.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Implements VolumeHistory member functions
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "volumeHistory.hpp"
+#include <cstdint>
+
+namespace Exchange {
+
+namespace {
+
+constexpr std::size_t initialCapacity = 16;
+
+/// @brief Fibonacci hashing, spreads nearby prices (the common case) across the table
+auto hashPrice(Price price) -> std::size_t {
+    constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    const auto bits = static_cast<std::uint64_t>(price.value());
+    return static_cast<std::size_t>((bits * multiplier) >> 32U);
+}
+
+} // namespace
+
+void VolumeHistory::addVolume(Price price, Qty shares) {
+    if(shares <= 0)
+        return;
+
+    if(entries.empty())
+        grow();
+
+    std::size_t slot = findSlot(price);
+    if(entries[slot].volume == 0) {
+        // Only a new price adds an entry, keep load factor at or under 1/2 so probe sequences stay short
+        if((usedEntries + 1) * 2 > entries.size()) {
+            grow();
+            slot = findSlot(price);
+        }
+        entries[slot].price = price;
+        ++usedEntries;
+    }
+    entries[slot].volume += shares;
+}
+
+auto VolumeHistory::getVolume(Price price) const -> Qty {
+    if(entries.empty())
+        return 0;
+
+    return entries[findSlot(price)].volume;
+}
+
+auto VolumeHistory::size() const -> std::size_t { return usedEntries; }
+
+auto VolumeHistory::findSlot(Price price) const -> std::size_t {
+    const std::size_t mask = entries.size() - 1;
+    std::size_t slot = hashPrice(price) & mask;
+
+    while(entries[slot].volume != 0 && entries[slot].price != price)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+void VolumeHistory::grow() {
+    std::vector<Entry> oldEntries(entries.empty() ? initialCapacity : entries.size() * 2);
+    oldEntries.swap(entries);
+
+    for(const auto& entry : oldEntries)
+        if(entry.volume != 0)
+            entries[findSlot(entry.price)] = entry;
+}
+
+} // namespace Exchange
@@ -0,0 +1,79 @@
+/**
+ * @file volumeHistory.hpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Header file for the compact per-price traded volume history
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef VOLUMEHISTORY_HPP
+#define VOLUMEHISTORY_HPP
+
+#include "fixedPoint.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace Exchange {
+
+/**
+ * @brief Flat open addressing hash map from price to number of shares traded at that price
+ *
+ * Kept separately from the live LimitPrice objects, so levels can be destroyed as soon as they are empty
+ * and recreated without copying anything back. Each price costs 16 bytes, and a lookup is a single probe sequence.
+ */
+struct VolumeHistory {
+    /**
+     * @brief Add traded shares to the volume at a price
+     *
+     * @param price     Price the shares traded at
+     * @param shares    Number of shares traded, ignored if not positive
+     */
+    void addVolume(Price price, Qty shares);
+
+    /**
+     * @brief Get the number of shares ever traded at a price
+     *
+     * @param price Price to check
+     * @return Number of shares, 0 if nothing ever traded at the price
+     */
+    [[nodiscard]] auto getVolume(Price price) const -> Qty;
+
+    /**
+     * @brief Get the number of distinct prices that have traded
+     *
+     * @return Number of prices with volume
+     */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+  private:
+    /// @brief A slot in the table, volume of 0 marks it as empty since prices only enter with positive volume
+    struct Entry {
+        Price price = 0;
+        Qty volume = 0;
+    };
+
+    /**
+     * @brief Find the slot holding price, or the empty slot it would be inserted into
+     *
+     * @param price Price to look for
+     * @return Index into entries
+     * @warning entries must not be empty
+     */
+    [[nodiscard]] auto findSlot(Price price) const -> std::size_t;
+
+    /**
+     * @brief Double the capacity of the table and rehash all entries
+     *
+     */
+    void grow();
+
+    std::vector<Entry> entries;
+    std::size_t usedEntries = 0;
+};
+
+} // namespace Exchange
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file auction.test.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Unit tests for call auctions and their uncrossing price
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "auction.hpp"
+#include "orderBook.hpp"
+#include "doctest.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace Exchange;
+using enum OrderType;
+
+TEST_SUITE_BEGIN("auction");
+
+TEST_CASE("Uncrossing price tie-breaks") {
+    // Most volume wins outright
+    const std::vector<AuctionLevel> mostVolume{{100, 5, 12}, {101, 10, 0}};
+    CHECK_EQ(findUncrossingPrice(mostVolume, 0), AuctionUncross{100, 12, 3});
+
+    // Same volume, the smaller surplus wins
+    const std::vector<AuctionLevel> smallestSurplus{{100, 3, 10}, {101, 0, 5}, {102, 10, 0}};
+    CHECK_EQ(findUncrossingPrice(smallestSurplus, 1'000), AuctionUncross{100, 10, 3});
+
+    // Same volume and surplus, buyers left over push the price up and sellers push it down
+    const std::vector<AuctionLevel> buyPressure{{100, 0, 10}, {101, 0, 10}, {102, 30, 0}};
+    CHECK_EQ(findUncrossingPrice(buyPressure, 0), AuctionUncross{102, 20, 10});
+    const std::vector<AuctionLevel> sellPressure{{100, 0, 30}, {101, 10, 0}, {102, 10, 0}};
+    CHECK_EQ(findUncrossingPrice(sellPressure, 1'000), AuctionUncross{100, 20, -10});
+
+    // Nothing left over either way, the reference price decides, the lower price when it's halfway
+    const std::vector<AuctionLevel> balanced{{100, 0, 10}, {102, 10, 0}};
+    CHECK_EQ(findUncrossingPrice(balanced, 105)->price, 102);
+    CHECK_EQ(findUncrossingPrice(balanced, 101)->price, 100);
+    CHECK_EQ(findUncrossingPrice(balanced, 0)->price, 100);
+
+    CHECK_FALSE(findUncrossingPrice({}, 100));
+}
+
+TEST_CASE("Orders rest through an auction and trade at one price when it uncrosses") {
+    OrderBook orderBook;
+    CHECK(orderBook.setSessionState(SessionState::auction));
+
+    const int firstBuy = orderBook.addOrder(buy, 10, 105).value().getBaseId();
+    const int secondBuy = orderBook.addOrder(buy, 10, 101).value().getBaseId();
+    const int firstSell = orderBook.addOrder(sell, 15, 99).value().getBaseId();
+    orderBook.addOrder(sell, 10, 103);
+    CHECK_EQ(orderBook.getTotalVolume(), 0);
+    CHECK_EQ(orderBook.getBestBid(), 105);
+    CHECK_EQ(orderBook.getBestAsk(), 99);
+    CHECK_EQ(orderBook.simulateOrder(buy, 5, 200).value().sharesExecuted, 0);
+
+    // 101 trades 15, 103 and 105 only 10
+    const auto indicative = orderBook.getIndicativeUncross(100);
+    CHECK_EQ(indicative, AuctionUncross{101, 15, 5});
+
+    const AuctionResult result = orderBook.uncrossAuction(100).value();
+    CHECK_EQ(orderBook.getSessionState(), SessionState::continuous);
+    CHECK_EQ(result.uncross, indicative);
+    CHECK_EQ(result.buyFills.getFulfilledOrderIds(), std::vector<int>{firstBuy});
+    CHECK_EQ(result.buyFills.getPartiallyFulfilledOrder(), std::pair<int, Qty>{secondBuy, 5});
+    CHECK_EQ(result.sellFills.getFulfilledOrderIds(), std::vector<int>{firstSell});
+    CHECK(result.buyFills.getMoneyExchanged() == Price{101} * Qty{15});
+    CHECK(result.sellFills.getMoneyExchanged() == Price{101} * Qty{15});
+    CHECK_EQ(orderBook.getTotalVolume(), 15);
+    CHECK_EQ(orderBook.getVolumeAtLimit(101), 15);
+
+    // Uncrossed, and back to continuous matching
+    CHECK_EQ(orderBook.getBestBid(), 101);
+    CHECK_EQ(orderBook.getBestAsk(), 103);
+    CHECK_EQ(orderBook.addOrder(buy, 10, 103).value().getTotalSharesExecuted(), 10);
+
+    CHECK_EQ(orderBook.uncrossAuction(100).error(), RejectReason::invalidTransition);
+}
+
+TEST_CASE("Auctions uncross at a price trading the most shares, and leave the book uncrossed") {
+    std::mt19937 generator{17};
+    for(int auction = 0; auction < 200; ++auction) {
+        OrderBook orderBook{auction % 2 == 0 ? MatchingRules{} : MatchingRules{.algorithm = MatchingAlgorithm::proRata}};
+        std::map<Price, Qty> buys;
+        std::map<Price, Qty> sells;
+
+        orderBook.setSessionState(SessionState::auction);
+        for(int i = 0; i < 60; ++i) {
+            const Price price = 90 + static_cast<int>(generator() % 21);
+            const Qty shares = 1 + static_cast<int>(generator() % 20);
+            const OrderType side = generator() % 2 == 0 ? buy : sell;
+            orderBook.addOrder(side, shares, price);
+            (side == buy ? buys : sells)[price] += shares;
+        }
+
+        Qty mostVolume = 0;
+        for(int price = 90; price <= 110; ++price) {
+            Qty buyShares = 0;
+            Qty sellShares = 0;
+            for(const auto& [level, shares] : buys)
+                buyShares += level >= price ? shares : Qty{0};
+            for(const auto& [level, shares] : sells)
+                sellShares += level <= price ? shares : Qty{0};
+            mostVolume = std::max(mostVolume, std::min(buyShares, sellShares));
+        }
+
+        const AuctionResult result = orderBook.uncrossAuction(100).value();
+        CHECK_EQ(orderBook.getSessionState(), SessionState::continuous);
+        CHECK_EQ(result.uncross.has_value(), mostVolume > 0);
+        if(!result.uncross)
+            continue;
+        CHECK_EQ(result.uncross->volume, mostVolume);
+        CHECK_EQ(result.buyFills.getTotalSharesExecuted(), mostVolume);
+        CHECK_EQ(result.sellFills.getTotalSharesExecuted(), mostVolume);
+        CHECK(result.buyFills.getMoneyExchanged() == result.uncross->price * mostVolume);
+        if(orderBook.getBestBid() && orderBook.getBestAsk())
+            CHECK_LT(*orderBook.getBestBid(), *orderBook.getBestAsk());
+    }
+}
+
+TEST_SUITE_END();
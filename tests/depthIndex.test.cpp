@@ -0,0 +1,143 @@
+/**
+ * @file depthIndex.test.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Unit tests for cumulative depth and impact price queries
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "depthIndex.hpp"
+#include "orderBook.hpp"
+#include "doctest.h"
+#include <map>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace Exchange;
+using enum OrderType;
+
+TEST_SUITE_BEGIN("depthIndex");
+
+TEST_CASE("Depth index agrees with summing levels") {
+    DepthIndex index;
+    std::map<Price, Qty> expected;
+    std::mt19937 generator{5};
+    auto rebuild = [&] {
+        std::vector<PriceLevel> levels;
+        for(const auto& [price, shares] : expected)
+            levels.push_back(PriceLevel{price, shares});
+        index.rebuild(levels);
+    };
+
+    for(int step = 0; step < 5'000; ++step) {
+        const Price price = 1'000 + static_cast<int>(generator() % 400);
+        const Qty shares = 1 + static_cast<int>(generator() % 50);
+        if(generator() % 3 != 0 || !expected.contains(price)) {
+            expected[price] += shares;
+            if(!index.add(price, shares))
+                rebuild();
+        } else {
+            const Qty taken = std::min(shares, expected[price]);
+            if(expected[price] -= taken; expected[price] == 0)
+                expected.erase(price);
+            REQUIRE(index.add(price, Qty{0} - taken));
+        }
+
+        if(step % 50 != 0)
+            continue;
+        Qty below = 0;
+        Qty total = 0;
+        for(const auto& [levelPrice, levelShares] : expected)
+            total += levelShares;
+        for(const auto& [levelPrice, levelShares] : expected) {
+            below += levelShares;
+            CHECK_EQ(index.getDepthAtOrBelow(levelPrice), below);
+            CHECK_EQ(index.getDepthAtOrAbove(levelPrice), total - below + levelShares);
+            CHECK_EQ(index.findPriceFromBelow(below), levelPrice);
+            CHECK_EQ(index.findPriceFromAbove(total - below + levelShares), levelPrice);
+            CHECK_EQ(index.findPriceFromBelow(below + 1), expected.upper_bound(levelPrice) == expected.end()
+                                                              ? std::nullopt
+                                                              : std::optional<Price>{expected.upper_bound(levelPrice)->first});
+        }
+        CHECK_FALSE(index.findPriceFromAbove(total + 1));
+    }
+}
+
+TEST_CASE("Depth index is disabled past its widest range") {
+    DepthIndex index;
+    const std::vector<PriceLevel> levels{{1, 10}, {Price{1} + Price{maxDepthIndexTicks}, 10}};
+    index.rebuild(levels);
+    CHECK_FALSE(index.isEnabled());
+    CHECK(index.add(5, 10));
+
+    index.rebuild(std::vector<PriceLevel>{{1, 10}, {Price{maxDepthIndexTicks}, 10}});
+    CHECK(index.isEnabled());
+    CHECK_EQ(index.getDepthAtOrAbove(2), 10);
+
+    // Cleared, it holds nothing and asks to be rebuilt on the next change
+    index.clear();
+    CHECK_FALSE(index.isBuilt());
+    CHECK_FALSE(index.add(5, 10));
+}
+
+TEST_CASE("OrderBook answers cumulative depth and impact price") {
+    OrderBook orderBook;
+    for(int price = 101; price <= 110; ++price)
+        orderBook.addOrder(sell, price - 100, price);
+    for(int price = 90; price <= 99; ++price)
+        orderBook.addOrder(buy, 10, price);
+
+    CHECK_EQ(orderBook.getAvailableShares(buy, 100), 0);
+    CHECK_EQ(orderBook.getAvailableShares(buy, 103), 6);
+    CHECK_EQ(orderBook.getAvailableShares(sell, 95), 50);
+    CHECK_EQ(orderBook.getImpactPrice(buy, 7), 104);
+    CHECK_EQ(orderBook.getImpactPrice(sell, 11), 98);
+    CHECK_FALSE(orderBook.getImpactPrice(buy, 56));
+
+    // Fills and cancels are reflected straight away
+    orderBook.addOrder(buy, 4, 103);
+    orderBook.cancelOrder(orderBook.addOrder(sell, 5, 102)->getBaseId());
+    CHECK_EQ(orderBook.getAvailableShares(buy, 103), 2);
+    CHECK_EQ(orderBook.getImpactPrice(buy, 3), 104);
+
+    // A level far away disables the index, answers come from walking the levels instead
+    orderBook.addOrder(sell, 1'000, Price{110} + Price{maxDepthIndexTicks});
+    CHECK_EQ(orderBook.getAvailableShares(buy, 103), 2);
+    CHECK_EQ(orderBook.getImpactPrice(buy, 3), 104);
+    CHECK_EQ(orderBook.getImpactPrice(buy, 1'000), Price{110} + Price{maxDepthIndexTicks});
+    CHECK_EQ(orderBook.getAvailableShares(buy, Price{110} + Price{maxDepthIndexTicks}), 1'000 + 51);
+}
+
+TEST_CASE("OrderBook depth answers hold as a side grows out of and shrinks back into its inline arrays") {
+    OrderBook orderBook;
+    std::vector<int> orderIds;
+    auto expectDepth = [&](Qty expected, Price worstAsk) {
+        CHECK_EQ(orderBook.getAvailableShares(buy, 1'000), expected);
+        CHECK_EQ(orderBook.getImpactPrice(buy, expected), worstAsk);
+    };
+
+    for(int price = 101; price <= 120; ++price) {
+        orderIds.push_back(orderBook.addOrder(sell, 10, price)->getBaseId());
+        expectDepth(10 * (price - 100), price);
+    }
+    CHECK_EQ(orderBook.getLevelStorage(sell), LevelStorage::tree);
+    CHECK_EQ(orderBook.getAvailableShares(buy, 105), 50);
+
+    // Back down to a handful of levels, then out again past the index's old window
+    while(orderIds.size() > 2) {
+        CHECK(orderBook.cancelOrder(orderIds.back()));
+        orderIds.pop_back();
+        expectDepth(10 * static_cast<int>(orderIds.size()), 100 + static_cast<int>(orderIds.size()));
+    }
+    CHECK_EQ(orderBook.getLevelStorage(sell), LevelStorage::inlineArrays);
+    for(int price = 500; price < 520; ++price)
+        orderBook.addOrder(sell, 10, price);
+    expectDepth(220, 519);
+    CHECK_EQ(orderBook.getImpactPrice(buy, 21), 500);
+}
+
+TEST_SUITE_END();
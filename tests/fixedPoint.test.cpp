@@ -0,0 +1,71 @@
+/**
+ * @file fixedPoint.test.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Unit tests for the fixed-point Price, Qty and Notional types
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "fixedPoint.hpp"
+#include "orderBook.hpp"
+#include "doctest.h"
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+using namespace Exchange;
+using enum OrderType;
+
+TEST_SUITE_BEGIN("fixedPoint");
+
+TEST_CASE("Fixed-point types don't mix") {
+    static_assert(!std::is_convertible_v<Price, Qty>);
+    static_assert(!std::is_convertible_v<Qty, Price>);
+    static_assert(!std::is_convertible_v<Price, std::int64_t>);
+    static_assert(!std::is_constructible_v<Price, double>);
+    static_assert(sizeof(Price) == 8 && sizeof(Qty) == 8 && sizeof(Notional) == 16);
+
+    CHECK_EQ((Price{5} * Qty{3}).value(), 15);
+    CHECK_EQ(Qty{7} - Qty{2}, 5);
+}
+
+TEST_CASE("Decimal conversion uses configured scale") {
+    const auto price = Price::fromDouble(12.34);
+    CHECK_EQ(price.value(), static_cast<std::int64_t>(12.34 * Price::unitsPerWhole + 0.5));
+    CHECK_EQ(Price::fromDouble(-1.0).value(), -Price::unitsPerWhole);
+    CHECK(price.toDouble() == doctest::Approx(12.34).epsilon(1.0 / Price::unitsPerWhole));
+}
+
+TEST_CASE("Notional past 64 bits doesn't overflow") {
+    OrderBook orderBook;
+    constexpr std::int64_t maxInt64 = std::numeric_limits<std::int64_t>::max();
+    const Price price = maxInt64 / 4;
+    const Qty shares = 1'000;
+
+    orderBook.addOrder(sell, shares, price);
+    orderBook.addOrder(sell, shares, price);
+    auto buyOrder = orderBook.addOrder(buy, shares + shares, price).value();
+
+    const Int128 expected = static_cast<Int128>(price.value()) * 2'000;
+    CHECK(buyOrder.getMoneyExchanged().value() == expected);
+    CHECK(buyOrder.getMoneyExchanged().value() > maxInt64);
+    CHECK_EQ(orderBook.getVolumeAtLimit(price), 2'000);
+}
+
+TEST_CASE("Quantities past 32 bits") {
+    OrderBook orderBook;
+    const Qty hugeOrder = 10'000'000'000;
+
+    orderBook.addOrder(buy, hugeOrder, 100);
+    orderBook.addOrder(buy, hugeOrder, 100);
+    auto sellOrder = orderBook.addOrder(sell, hugeOrder + hugeOrder, 100).value();
+
+    CHECK_EQ(sellOrder.getTotalSharesExecuted(), 20'000'000'000);
+    CHECK_EQ(orderBook.getTotalVolume(), 20'000'000'000);
+    CHECK(sellOrder.getMoneyExchanged() == Notional{static_cast<Int128>(2'000'000'000'000)});
+}
+
+TEST_SUITE_END();
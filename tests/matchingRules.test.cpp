@@ -0,0 +1,198 @@
+/**
+ * @file matchingRules.test.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Unit tests for pro-rata matching and its variants
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "orderBook.hpp"
+#include "doctest.h"
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace Exchange;
+using enum OrderType;
+
+namespace {
+
+/// @brief A resting order of the test's model, by id and shares left
+using RestingOrder = std::pair<int, Qty>;
+
+/**
+ * @brief Allocate a fill between resting orders by MatchingRules, one stage after another
+ *
+ * @param resting   Orders in time priority
+ * @param shares    Shares to fill, positive
+ * @param rules     Rules to allocate by
+ * @return Shares each order trades, in the same order as resting
+ */
+auto allocateByStages(const std::vector<RestingOrder>& resting, Qty shares, const MatchingRules& rules) -> std::vector<Qty> {
+    std::vector<Qty> allocations(resting.size());
+    Qty depth = 0;
+    for(const auto& order : resting)
+        depth += order.second;
+    if(shares >= depth) {
+        std::transform(resting.begin(), resting.end(), allocations.begin(), [](const RestingOrder& order) { return order.second; });
+        return allocations;
+    }
+
+    const Qty top = rules.topOrderPriority ? std::min(resting.front().second, shares) : 0;
+    Qty fifoLeft = top.value() + (shares - top).value() * rules.fifoPercent / 100;
+    const Qty proRataShares = shares - fifoLeft;
+    for(std::size_t i = 0; i < resting.size(); ++i) {
+        allocations[i] = std::min(resting[i].second, fifoLeft);
+        fifoLeft -= allocations[i];
+    }
+
+    const Qty restingShares = depth - (shares - proRataShares);
+    Qty leftover = proRataShares;
+    std::vector<Qty> proRata(resting.size());
+    for(std::size_t i = 0; i < resting.size(); ++i) {
+        proRata[i] = (resting[i].second - allocations[i]).value() * proRataShares.value() / restingShares.value();
+        if(proRata[i] < rules.minAllocation)
+            proRata[i] = 0;
+        leftover -= proRata[i];
+    }
+    for(std::size_t i = 0; i < resting.size(); ++i) {
+        const Qty extra = std::min(resting[i].second - allocations[i] - proRata[i], leftover);
+        leftover -= extra;
+        allocations[i] += proRata[i] + extra;
+    }
+    return allocations;
+}
+
+/**
+ * @brief Get the shares an execution traded with each resting order
+ *
+ * @param execution Execution of an aggressive order
+ * @param resting   Orders it traded against, in time priority
+ * @return Shares each order traded, in the same order as resting
+ */
+auto getAllocations(const OrderExecution& execution, const std::vector<RestingOrder>& resting) -> std::vector<Qty> {
+    std::vector<Qty> allocations(resting.size());
+    auto allocate = [&](int orderId, Qty shares) {
+        const auto order = std::find_if(resting.begin(), resting.end(), [&](const RestingOrder& entry) { return entry.first == orderId; });
+        REQUIRE(order != resting.end());
+        allocations[static_cast<std::size_t>(order - resting.begin())] += shares;
+    };
+
+    for(const int orderId : execution.getFulfilledOrderIds())
+        allocate(orderId, std::find_if(resting.begin(), resting.end(), [&](const RestingOrder& entry) { return entry.first == orderId; })->second);
+    if(execution.getPartiallyFulfilledOrder())
+        allocate(execution.getPartiallyFulfilledOrder()->first, execution.getPartiallyFulfilledOrder()->second);
+    for(const auto& [orderId, shares] : execution.getOtherPartialFills())
+        allocate(orderId, shares);
+    return allocations;
+}
+
+/**
+ * @brief Rest sell orders at one price, then fill a buy against them
+ *
+ * @param rules     Rules of the book
+ * @param sizes     Shares of each resting order, oldest first
+ * @param shares    Shares of the buy
+ * @return Shares each resting order traded
+ */
+auto fillLevel(const MatchingRules& rules, const std::vector<int>& sizes, Qty shares) -> std::vector<Qty> {
+    OrderBook orderBook{rules};
+    std::vector<RestingOrder> resting;
+    for(const int size : sizes)
+        resting.emplace_back(orderBook.addOrder(sell, size, 100).value().getBaseId(), size);
+    return getAllocations(orderBook.addOrder(buy, shares, 100).value(), resting);
+}
+
+} // namespace
+
+TEST_SUITE_BEGIN("matchingRules");
+
+TEST_CASE("Pro-rata shares a fill in proportion to resting shares") {
+    const MatchingRules proRata{.algorithm = MatchingAlgorithm::proRata};
+    CHECK_EQ(fillLevel(proRata, {10, 20, 30, 40}, 50), std::vector<Qty>{5, 10, 15, 20});
+
+    // A third each rounds down to 1, and the share rounding left over goes to the oldest order
+    CHECK_EQ(fillLevel(proRata, {3, 3, 3}, 4), std::vector<Qty>{2, 1, 1});
+
+    // Taking the whole level fills everyone
+    CHECK_EQ(fillLevel(proRata, {3, 3, 3}, 9), std::vector<Qty>{3, 3, 3});
+
+    // Plain FIFO is still the default
+    CHECK_EQ(fillLevel(MatchingRules{}, {10, 20, 30, 40}, 50), std::vector<Qty>{10, 20, 20, 0});
+}
+
+TEST_CASE("Pro-rata variants allocate in stages") {
+    // Allocations under the minimum are held back and handed out in time priority
+    CHECK_EQ(fillLevel({.algorithm = MatchingAlgorithm::proRata, .minAllocation = 2}, {100, 5, 5}, 22),
+             std::vector<Qty>{22, 0, 0});
+
+    // The top order is filled first, the rest shared out over the others
+    CHECK_EQ(fillLevel({.algorithm = MatchingAlgorithm::proRata, .topOrderPriority = true}, {10, 50, 40}, 30),
+             std::vector<Qty>{10, 12, 8});
+
+    // 40% in time priority, then pro rata over what each order has left
+    CHECK_EQ(fillLevel({.algorithm = MatchingAlgorithm::proRata, .fifoPercent = 40}, {10, 20, 30, 40}, 50),
+             std::vector<Qty>{10, 14, 11, 15});
+}
+
+TEST_CASE("Pro-rata books match the staged allocation through adds, cancels and fills") {
+    const std::vector<MatchingRules> variants{
+        {.algorithm = MatchingAlgorithm::proRata},
+        {.algorithm = MatchingAlgorithm::proRata, .minAllocation = 3},
+        {.algorithm = MatchingAlgorithm::proRata, .topOrderPriority = true, .fifoPercent = 25, .minAllocation = 2},
+    };
+
+    for(const MatchingRules& rules : variants) {
+        OrderBook orderBook{rules};
+        std::vector<RestingOrder> resting;
+        std::mt19937 generator{13};
+
+        // Long enough queues to span many chunks, with cancels leaving tombstones for the allocation to skip
+        for(int round = 0; round < 1'500; ++round) {
+            const auto action = generator() % 10;
+            if(action < 6 || resting.size() < 8) {
+                const Qty shares = static_cast<int>(generator() % 60) + 1;
+                resting.emplace_back(orderBook.addOrder(sell, shares, 100).value().getBaseId(), shares);
+                continue;
+            }
+            if(action < 8) {
+                const auto cancelled = resting.begin() + static_cast<long>(generator() % resting.size());
+                CHECK(orderBook.cancelOrder(cancelled->first));
+                resting.erase(cancelled);
+                continue;
+            }
+
+            Qty depth = 0;
+            for(const auto& order : resting)
+                depth += order.second;
+            const Qty shares = static_cast<int>(generator() % static_cast<unsigned>(depth.value())) + 1;
+            const std::vector<Qty> expected = allocateByStages(resting, shares, rules);
+
+            const auto simulated = orderBook.simulateOrder(buy, shares, 100).value();
+            const auto execution = orderBook.addOrder(buy, shares, 100).value();
+            REQUIRE_EQ(getAllocations(execution, resting), expected);
+            CHECK_EQ(execution.getTotalSharesExecuted(), shares);
+
+            std::vector<RestingOrder> stillResting;
+            std::size_t partials = 0;
+            for(std::size_t i = 0; i < resting.size(); ++i) {
+                partials += expected[i] > 0 && expected[i] < resting[i].second ? 1 : 0;
+                if(expected[i] < resting[i].second)
+                    stillResting.emplace_back(resting[i].first, resting[i].second - expected[i]);
+            }
+            CHECK_EQ(simulated.filledOrders, resting.size() - stillResting.size());
+            CHECK_EQ(simulated.partiallyFilledOrders, partials);
+            resting = std::move(stillResting);
+
+            // Queue positions still count what's ahead once orders were filled out of time priority
+            if(!resting.empty())
+                CHECK_EQ(orderBook.getQueuePosition(resting.back().first).value(), depth - shares - resting.back().second);
+        }
+    }
+}
+
+TEST_SUITE_END();
@@ -11,8 +11,13 @@
 
 #include "orderBook.hpp"
 #include "doctest.h"
-#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
 #include <utility>
+#include <vector>
 
 using namespace Exchange;
 using enum OrderType;
@@ -22,8 +27,8 @@ TEST_SUITE_BEGIN("orderBook");
 TEST_CASE("Simplest Execution") {
     OrderBook orderBook;
 
-    auto buyOrder = orderBook.addOrder(buy, 5, 2);
-    auto sellOrder = orderBook.addOrder(sell, 5, 2);
+    auto buyOrder = orderBook.addOrder(buy, 5, 2).value();
+    auto sellOrder = orderBook.addOrder(sell, 5, 2).value();
     CHECK(buyOrder.getBaseId() + 1 == sellOrder.getBaseId());
 
     CHECK(orderBook.getTotalVolume() == 5);
@@ -34,9 +39,9 @@ TEST_CASE("Simplest Execution") {
 
 TEST_CASE("Double Execution with no partial execution") {
     OrderBook orderBook;
-    auto buyOrder = orderBook.addOrder(buy, 10, 4);
-    auto sellOrder1 = orderBook.addOrder(sell, 5, 4);
-    auto sellOrder2 = orderBook.addOrder(sell, 5, 4);
+    auto buyOrder = orderBook.addOrder(buy, 10, 4).value();
+    auto sellOrder1 = orderBook.addOrder(sell, 5, 4).value();
+    auto sellOrder2 = orderBook.addOrder(sell, 5, 4).value();
 
     CHECK(buyOrder.getFulfilledOrderIds().empty());
 
@@ -68,15 +73,15 @@ TEST_CASE("Test empty best bid/asks") {
 TEST_CASE("Test order cancellation basic") {
     OrderBook orderBook;
 
-    auto buyOrder = orderBook.addOrder(buy, 100, 400);
+    auto buyOrder = orderBook.addOrder(buy, 100, 400).value();
     int orderId = buyOrder.getBaseId();
 
     CHECK(orderBook.getBestBid().value() == 400);
     orderBook.cancelOrder(orderId);
     CHECK(!orderBook.getBestBid().has_value());
 
-    auto sellOrder = orderBook.addOrder(sell, 100, 405);
-    buyOrder = orderBook.addOrder(buy, 20, 410);
+    auto sellOrder = orderBook.addOrder(sell, 100, 405).value();
+    buyOrder = orderBook.addOrder(buy, 20, 410).value();
 
     CHECK(orderBook.getTotalVolume() == 20);
     CHECK(orderBook.getVolumeAtLimit(405) == 20);
@@ -85,7 +90,7 @@ TEST_CASE("Test order cancellation basic") {
 
     CHECK(orderBook.getBestAsk().value() == 405);
     orderBook.cancelOrder(sellOrder.getBaseId());
-    buyOrder = orderBook.addOrder(buy, 20, 410);
+    buyOrder = orderBook.addOrder(buy, 20, 410).value();
     CHECK(!orderBook.getBestAsk().has_value());
 
     CHECK(buyOrder.getTotalSharesExecuted() == 0);
@@ -100,7 +105,7 @@ TEST_CASE("Orders executing past one another, check volume after limit disappear
     // 50 shares selling at 10
 
     CHECK(orderBook.getBestAsk().value() == 10);
-    auto buyOrder = orderBook.addOrder(buy, 60, 11);
+    auto buyOrder = orderBook.addOrder(buy, 60, 11).value();
     CHECK(!orderBook.getBestAsk().has_value());
     // 10 shares buying at 11
 
@@ -110,7 +115,7 @@ TEST_CASE("Orders executing past one another, check volume after limit disappear
     CHECK(buyOrder.getTotalSharesExecuted() == 50);
     CHECK(orderBook.getBestBid().value() == 11);
 
-    auto sellOrder3 = orderBook.addOrder(sell, 10, 11);
+    auto sellOrder3 = orderBook.addOrder(sell, 10, 11).value();
     // Should have no shares left
 
     CHECK(orderBook.getTotalVolume() == 60);
@@ -134,26 +139,31 @@ TEST_CASE("Orders executing past one another, check volume after limit disappear
     CHECK(!orderBook.getBestAsk().has_value());
 }
 
-TEST_CASE("LimitPrice exceptions") {
+TEST_CASE("LimitPrice rejects executing more than its depth") {
+    OrderPool pool;
     LimitPrice limitPrice{10};
-    limitPrice.addOrder(Order{0, buy, 10, 10});
+    const OrderSlot slot = pool.allocate(HotOrder{.shares = 10}, ColdOrder{.shares = 10, .limitPrice = 10});
+    CHECK(limitPrice.addOrder(pool, slot));
 
-    CHECK_THROWS_AS(limitPrice.executeNumberOfShares(1, 20), std::invalid_argument);
+    const auto result = limitPrice.executeNumberOfShares(pool, 1, 20);
+    REQUIRE_FALSE(result.has_value());
+    CHECK_EQ(result.error(), RejectReason::insufficientDepth);
+    CHECK_EQ(limitPrice.getDepth(), 10);
 }
 
 TEST_CASE("Check executed order info correct") {
     OrderBook orderBook;
-    auto sellOrder1 = orderBook.addOrder(sell, 20, 10);
+    auto sellOrder1 = orderBook.addOrder(sell, 20, 10).value();
     orderBook.addOrder(sell, 30, 10);
 
     const int baseId = sellOrder1.getBaseId();
 
-    auto buyOrder = orderBook.addOrder(buy, 45, 11);
+    auto buyOrder = orderBook.addOrder(buy, 45, 11).value();
 
     CHECK(buyOrder.getFulfilledOrderIds().size() == 1);
     CHECK(buyOrder.hasPartialExecution());
 
-    CHECK(buyOrder.getPartiallyFulfilledOrder().value() == std::make_pair(baseId + 1, 25));
+    CHECK(buyOrder.getPartiallyFulfilledOrder().value() == std::make_pair(baseId + 1, Qty{25}));
     CHECK(buyOrder.getTotalSharesExecuted() == 45);
     CHECK(buyOrder.getMoneyExchanged() == 450);
 }
@@ -163,17 +173,17 @@ TEST_CASE("Check for time in force") {
     CHECK(order.getTimeInForce() == 30);
 }
 
-TEST_CASE("OrderExecution throwing for invalid addition") {
+TEST_CASE("OrderExecution rejecting invalid merges") {
     OrderBook orderBook;
     orderBook.addOrder(sell, 20, 10);
     orderBook.addOrder(sell, 30, 10);
 
-    auto buyOrder1 = orderBook.addOrder(buy, 20, 10);
-    auto buyOrder2 = orderBook.addOrder(buy, 20, 10);
+    auto buyOrder1 = orderBook.addOrder(buy, 20, 10).value();
+    auto buyOrder2 = orderBook.addOrder(buy, 20, 10).value();
 
-    CHECK_THROWS_AS(buyOrder1 += buyOrder2, std::invalid_argument);
+    CHECK_EQ(buyOrder1.merge(buyOrder2).error(), RejectReason::mismatchedBaseId);
 
-    // Other throw condition requires really trying to do something bad
+    // Other reject condition requires really trying to do something bad
     // Practically impossible unless I code something wrong in the logic
     OrderExecution exec1{5};
     OrderExecution exec2{5};
@@ -182,7 +192,7 @@ TEST_CASE("OrderExecution throwing for invalid addition") {
     exec1.executeOrder(order1, 5);
     exec2.executeOrder(order1, 5);
     // Now both executions have a partial execution
-    CHECK_THROWS_AS(exec1 += exec2, std::invalid_argument);
+    CHECK_EQ(exec1.merge(exec2).error(), RejectReason::multiplePartialFills);
 }
 
 TEST_CASE("Fail isExecutable due to price being larger than the best asking value") {
@@ -197,14 +207,14 @@ TEST_CASE("Fail isExecutable due to price being larger than the best asking valu
 TEST_CASE("Cancel order more complexly") {
     OrderBook orderBook;
     orderBook.addOrder(sell, 5, 100);
-    auto buyOrder = orderBook.addOrder(buy, 6, 101);
+    auto buyOrder = orderBook.addOrder(buy, 6, 101).value();
     orderBook.addOrder(buy, 9, 101);
     // Here, are 10 for 101, 5 traded
     orderBook.cancelOrder(buyOrder.getBaseId());
     // Now are 9 for 101
     orderBook.addOrder(buy, 11, 100);
     orderBook.addOrder(buy, 1, 99);
-    auto sellOrder2 = orderBook.addOrder(sell, 21, 99);
+    auto sellOrder2 = orderBook.addOrder(sell, 21, 99).value();
 
     CHECK(!orderBook.getBestBid().has_value());
     CHECK_EQ(orderBook.getTotalVolume(), 26);
@@ -223,8 +233,8 @@ TEST_CASE("Final weird case for orderExecution addition") {
     exec1.executeOrder(order1, 5);
     exec2.executeOrder(order1, 7);
     
-    // Doesn't throw because only one of them is a partial order execution
-    CHECK_NOTHROW(exec1 += exec2);
+    // Succeeds because only one of them is a partial order execution
+    CHECK(exec1.merge(exec2));
 }
 
 TEST_CASE("Large test") {
@@ -235,7 +245,7 @@ TEST_CASE("Large test") {
         }
     }
 
-    auto buyTheWholeMarket = orderBook.addOrder(buy, 1'000'000'000, 300);
+    auto buyTheWholeMarket = orderBook.addOrder(buy, 1'000'000'000, 300).value();
 
     CHECK_EQ(buyTheWholeMarket.getMoneyExchanged(), 1'769'974'500);
 
@@ -249,21 +259,21 @@ TEST_CASE("Large test") {
 TEST_CASE("ID order test") {
     // Make sure first entere orders are first to be executed
     OrderBook orderBook;
-    auto buyOrder1 = orderBook.addOrder(buy, 5, 5);
-    auto buyOrder2 = orderBook.addOrder(buy, 5, 5);
-    auto buyOrder3 = orderBook.addOrder(buy, 5, 4);
-    auto buyOrder4 = orderBook.addOrder(buy, 5, 3);
-    auto buyOrder5 = orderBook.addOrder(buy, 5, 5);
-    auto buyOrder6 = orderBook.addOrder(buy, 5, 4);
-    auto buyOrder7 = orderBook.addOrder(buy, 5, 3);
-
-    auto sellOrder1 = orderBook.addOrder(sell, 5, 3);
-    auto sellOrder2 = orderBook.addOrder(sell, 5, 3);
-    auto sellOrder3 = orderBook.addOrder(sell, 5, 3);
-    auto sellOrder4 = orderBook.addOrder(sell, 5, 3);
-    auto sellOrder5 = orderBook.addOrder(sell, 5, 3);
-    auto sellOrder6 = orderBook.addOrder(sell, 5, 3);
-    auto sellOrder7 = orderBook.addOrder(sell, 5, 3);
+    auto buyOrder1 = orderBook.addOrder(buy, 5, 5).value();
+    auto buyOrder2 = orderBook.addOrder(buy, 5, 5).value();
+    auto buyOrder3 = orderBook.addOrder(buy, 5, 4).value();
+    auto buyOrder4 = orderBook.addOrder(buy, 5, 3).value();
+    auto buyOrder5 = orderBook.addOrder(buy, 5, 5).value();
+    auto buyOrder6 = orderBook.addOrder(buy, 5, 4).value();
+    auto buyOrder7 = orderBook.addOrder(buy, 5, 3).value();
+
+    auto sellOrder1 = orderBook.addOrder(sell, 5, 3).value();
+    auto sellOrder2 = orderBook.addOrder(sell, 5, 3).value();
+    auto sellOrder3 = orderBook.addOrder(sell, 5, 3).value();
+    auto sellOrder4 = orderBook.addOrder(sell, 5, 3).value();
+    auto sellOrder5 = orderBook.addOrder(sell, 5, 3).value();
+    auto sellOrder6 = orderBook.addOrder(sell, 5, 3).value();
+    auto sellOrder7 = orderBook.addOrder(sell, 5, 3).value();
 
     CHECK_EQ(buyOrder1.getBaseId(), sellOrder1.getFulfilledOrderIds().front());
     CHECK_EQ(buyOrder2.getBaseId(), sellOrder2.getFulfilledOrderIds().front());
@@ -274,10 +284,750 @@ TEST_CASE("ID order test") {
     CHECK_EQ(buyOrder7.getBaseId(), sellOrder7.getFulfilledOrderIds().front());
 }
 
-TEST_CASE("LimitPrice addOrder exception") {
+TEST_CASE("LimitPrice addOrder rejects mismatched price") {
+    OrderPool pool;
     LimitPrice limitPrice{100};
-    Order order1{1, buy, 5, 101};
-    CHECK_THROWS_AS(limitPrice.addOrder(order1), std::invalid_argument);
+    const OrderSlot slot = pool.allocate(HotOrder{.shares = 5, .orderId = 1}, ColdOrder{.shares = 5, .limitPrice = 101});
+    CHECK_EQ(limitPrice.addOrder(pool, slot).error(), RejectReason::priceMismatch);
+    CHECK_EQ(limitPrice.getDepth(), 0);
+}
+
+TEST_CASE("Resting orders keep their details and reuse pool slots") {
+    OrderBook orderBook;
+    const OrderRequest request{.orderType = sell, .shares = 30, .limitPrice = 12, .timeInForce = 5,
+                               .accountId = 7, .clientOrderId = 123456789, .timestamp = 42};
+    const int restingId = orderBook.addOrder(request)->getBaseId();
+
+    // Partially fill it, the details still show the original request
+    orderBook.addOrder(buy, 10, 12);
+    const auto details = orderBook.getOrderDetails(restingId);
+    REQUIRE(details.has_value());
+    CHECK_EQ(details->accountId, 7);
+    CHECK_EQ(details->clientOrderId, 123456789);
+    CHECK_EQ(details->timestamp, 42);
+    CHECK_EQ(details->timeInForce, 5);
+    CHECK_EQ(details->shares, 30);
+    CHECK_EQ(orderBook.getTopOfBook().askShares, 20);
+
+    orderBook.addOrder(buy, 20, 12);
+    CHECK_EQ(orderBook.getOrderDetails(restingId).error(), RejectReason::unknownOrderId);
+
+    // Cancelling from the middle of a level keeps time priority of the rest
+    const int first = orderBook.addOrder(sell, 1, 12)->getBaseId();
+    const int middle = orderBook.addOrder(sell, 2, 12)->getBaseId();
+    const int last = orderBook.addOrder(sell, 4, 12)->getBaseId();
+    CHECK(orderBook.cancelOrder(middle));
+    CHECK_EQ(orderBook.getTopOfBook().askShares, 5);
+
+    auto buyOrder = orderBook.addOrder(buy, 5, 12).value();
+    CHECK_EQ(buyOrder.getFulfilledOrderIds(), std::vector<int>{first, last});
+    CHECK(!orderBook.getBestAsk().has_value());
+}
+
+TEST_CASE("OrderBook rejects bad requests without throwing") {
+    OrderBook orderBook;
+    CHECK_EQ(orderBook.addOrder(buy, 0, 10).error(), RejectReason::invalidQuantity);
+    CHECK_EQ(orderBook.addOrder(sell, -5, 10).error(), RejectReason::invalidQuantity);
+    CHECK_FALSE(orderBook.getBestBid().has_value());
+    CHECK_FALSE(orderBook.getBestAsk().has_value());
+
+    CHECK_EQ(orderBook.cancelOrder(1234).error(), RejectReason::unknownOrderId);
+
+    const int restingId = orderBook.addOrder(sell, 10, 10)->getBaseId();
+    orderBook.addOrder(buy, 10, 10);
+    // Already filled, so no longer cancellable
+    CHECK_EQ(orderBook.cancelOrder(restingId).error(), RejectReason::unknownOrderId);
+
+    const int cancelledId = orderBook.addOrder(sell, 10, 10)->getBaseId();
+    CHECK(orderBook.cancelOrder(cancelledId));
+    CHECK_EQ(orderBook.cancelOrder(cancelledId).error(), RejectReason::unknownOrderId);
+}
+
+TEST_CASE("Volume history across many distinct prices") {
+    OrderBook orderBook;
+    // Touch enough prices to force the history to grow several times, including negative ones
+    for(int price = -500; price < 500; ++price) {
+        orderBook.addOrder(sell, 2, price);
+        orderBook.addOrder(buy, 2, price);
+    }
+
+    CHECK_EQ(orderBook.getTotalVolume(), 2000);
+    CHECK_EQ(orderBook.getVolumeAtLimit(-500), 2);
+    CHECK_EQ(orderBook.getVolumeAtLimit(0), 2);
+    CHECK_EQ(orderBook.getVolumeAtLimit(499), 2);
+    CHECK_EQ(orderBook.getVolumeAtLimit(500), 0);
+
+    // Re-instating a price adds onto its old volume, without the old level being kept around
+    orderBook.addOrder(buy, 1, 0);
+    orderBook.addOrder(sell, 1, 0);
+    CHECK_EQ(orderBook.getVolumeAtLimit(-500), 2);
+    CHECK_EQ(orderBook.getVolumeAtLimit(0), 3);
+    CHECK_EQ(orderBook.getTotalVolume(), 2001);
+}
+
+TEST_CASE("Stale handles are rejected") {
+    OrderBook orderBook;
+    const auto resting = orderBook.addOrder(sell, 10, 12).value();
+    REQUIRE(resting.getRestingHandle().has_value());
+    const OrderHandle handle = *resting.getRestingHandle();
+
+    CHECK_EQ(orderBook.cancelOrder(OrderHandle{}).error(), RejectReason::unknownOrderId);
+    CHECK(orderBook.cancelOrder(handle));
+    CHECK(!orderBook.getBestAsk().has_value());
+    CHECK_EQ(orderBook.cancelOrder(handle).error(), RejectReason::unknownOrderId);
+    CHECK_EQ(orderBook.cancelOrder(resting.getBaseId()).error(), RejectReason::unknownOrderId);
+
+    // The slot is reused by the next order, the old handle must not reach it
+    const auto reused = orderBook.addOrder(sell, 5, 12).value();
+    REQUIRE(reused.getRestingHandle().has_value());
+    CHECK_EQ(reused.getRestingHandle()->slot, handle.slot);
+    CHECK_EQ(orderBook.cancelOrder(handle).error(), RejectReason::unknownOrderId);
+    CHECK_EQ(orderBook.getTopOfBook().askShares, 5);
+
+    // Filled orders' handles go stale too, and fully filled aggressors never rest
+    const auto aggressor = orderBook.addOrder(buy, 5, 12).value();
+    CHECK(!aggressor.getRestingHandle().has_value());
+    CHECK_EQ(orderBook.cancelOrder(*reused.getRestingHandle()).error(), RejectReason::unknownOrderId);
+
+    // Partially filled aggressors rest their remainder, cancellable by ID after a handle cancel elsewhere
+    orderBook.addOrder(sell, 5, 12);
+    const auto partial = orderBook.addOrder(buy, 8, 12).value();
+    REQUIRE(partial.getRestingHandle().has_value());
+    CHECK_EQ(orderBook.getTopOfBook().bidShares, 3);
+    CHECK(orderBook.cancelOrder(*partial.getRestingHandle()));
+    CHECK_EQ(orderBook.cancelOrder(partial.getBaseId()).error(), RejectReason::unknownOrderId);
+    CHECK(!orderBook.getBestBid().has_value());
+}
+
+TEST_CASE("Cancelling by ID in any order") {
+    // Enough orders to grow the ID index several times, then cancel every third one so erasing has to
+    // shift entries back within probe sequences
+    OrderBook orderBook;
+    constexpr int numOrders = 5000;
+    std::vector<int> ids;
+    for(int i = 0; i < numOrders; ++i)
+        ids.push_back(orderBook.addOrder(buy, 1, 1 + i % 37)->getBaseId());
+
+    for(int i = 0; i < numOrders; i += 3)
+        CHECK(orderBook.cancelOrder(ids[i]));
+    for(int i = 0; i < numOrders; i += 3)
+        CHECK_EQ(orderBook.cancelOrder(ids[i]).error(), RejectReason::unknownOrderId);
+
+    for(int i = 0; i < numOrders; ++i)
+        if(i % 3 != 0)
+            CHECK_EQ(orderBook.getOrderDetails(ids[i])->limitPrice, 1 + i % 37);
+
+    for(int i = numOrders - 1; i >= 0; --i)
+        if(i % 3 != 0)
+            CHECK(orderBook.cancelOrder(ids[i]));
+    CHECK(!orderBook.getBestBid().has_value());
+}
+
+TEST_CASE("Cancelled orders are skipped and compacted away") {
+    OrderPool pool;
+    LimitPrice limitPrice{50};
+    std::vector<OrderSlot> slots;
+    for(int i = 0; i < 100; ++i) {
+        slots.push_back(pool.allocate(HotOrder{.shares = 1, .orderId = i}, ColdOrder{.shares = 1, .limitPrice = 50}));
+        CHECK(limitPrice.addOrder(pool, slots.back()));
+    }
+
+    // Cancel the even orders, the queue keeps its tombstones until half of it is dead
+    for(int i = 0; i < 100; i += 2) {
+        limitPrice.removeOrder(pool, slots[i]);
+        pool.release(slots[i]);
+        if(i < 98)
+            CHECK_EQ(limitPrice.getQueueLength(), 100);
+    }
+    CHECK_EQ(limitPrice.getQueueLength(), 50);
+    CHECK_EQ(limitPrice.getDepth(), 50);
+
+    // Fills skip tombstones and keep time priority after compaction
+    limitPrice.removeOrder(pool, slots[3]);
+    const auto execution = limitPrice.executeNumberOfShares(pool, 1000, 3).value();
+    CHECK_EQ(execution.getFulfilledOrderIds(), std::vector<int>{1, 5, 7});
+    CHECK_EQ(limitPrice.getDepth(), 46);
+
+    const auto rest = limitPrice.executeNumberOfShares(pool, 1001, 46).value();
+    CHECK_EQ(rest.getFulfilledOrderIds().front(), 9);
+    CHECK_EQ(rest.getFulfilledOrderIds().back(), 99);
+    CHECK(limitPrice.isEmpty());
+    CHECK_EQ(limitPrice.getQueueLength(), 0);
+    CHECK_EQ(pool.getQueueChunks().size(), 0);
+}
+
+TEST_CASE("Level queues grow and shrink a chunk at a time") {
+    OrderPool pool;
+    LimitPrice limitPrice{50};
+    for(int i = 0; i < 40; ++i) {
+        const OrderSlot slot = pool.allocate(HotOrder{.shares = 2, .orderId = i}, ColdOrder{.shares = 2, .limitPrice = 50});
+        CHECK(limitPrice.addOrder(pool, slot));
+    }
+    CHECK_EQ(pool.getQueueChunks().size(), 3);
+
+    // Fills crossing chunk boundaries keep time priority and hand back every chunk they empty
+    const auto execution = limitPrice.executeNumberOfShares(pool, 1000, 33).value();
+    CHECK_EQ(execution.getFulfilledOrderIds().size(), 16);
+    CHECK_EQ(execution.getFulfilledOrderIds().back(), 15);
+    CHECK_EQ(execution.getPartiallyFulfilledOrder().value().first, 16);
+    CHECK_EQ(pool.getQueueChunks().size(), 2);
+
+    CHECK(limitPrice.executeNumberOfShares(pool, 1001, 47));
+    CHECK(limitPrice.isEmpty());
+    CHECK_EQ(pool.getQueueChunks().size(), 0);
+}
+
+TEST_CASE("Fills consume exactly the orders their shares cover") {
+    // Orders of 1 to 5 shares with every third one cancelled, filled by every possible amount
+    constexpr int numQueued = 40;
+    Qty liveDepth = 0;
+    for(int i = 0; i < numQueued; ++i)
+        if(i % 3 != 0)
+            liveDepth += i % 5 + 1;
+
+    for(Qty numShares = 1; numShares <= liveDepth; numShares += 1) {
+        OrderPool pool;
+        LimitPrice limitPrice{50};
+        std::vector<OrderSlot> slots;
+        for(int i = 0; i < numQueued; ++i) {
+            const Qty shares = i % 5 + 1;
+            slots.push_back(pool.allocate(HotOrder{.shares = shares, .orderId = i}, ColdOrder{.shares = shares, .limitPrice = 50}));
+            CHECK(limitPrice.addOrder(pool, slots.back()));
+        }
+        for(int i = 0; i < numQueued; i += 3) {
+            limitPrice.removeOrder(pool, slots[i]);
+            pool.release(slots[i]);
+        }
+
+        std::vector<int> expectedIds;
+        std::optional<std::pair<int, Qty>> expectedPartial;
+        Qty left = numShares;
+        for(int i = 0; i < numQueued && left > 0; ++i) {
+            if(i % 3 == 0)
+                continue;
+            const Qty shares = i % 5 + 1;
+            if(shares > left) {
+                expectedPartial = {i, left};
+                break;
+            }
+            expectedIds.push_back(i);
+            left -= shares;
+        }
+
+        const auto execution = limitPrice.executeNumberOfShares(pool, 1000, numShares).value();
+        CHECK_EQ(execution.getFulfilledOrderIds(), expectedIds);
+        CHECK_EQ(execution.getPartiallyFulfilledOrder(), expectedPartial);
+        CHECK_EQ(execution.getTotalSharesExecuted(), numShares);
+        CHECK_EQ(limitPrice.getDepth(), liveDepth - numShares);
+    }
+}
+
+TEST_CASE("Simulating an order matches adding it, and leaves the book alone") {
+    auto fillBook = [](OrderBook& orderBook) {
+        for(int price = 101; price <= 105; ++price)
+            for(int i = 0; i < 4; ++i)
+                orderBook.addOrder(sell, 5, price);
+        orderBook.cancelOrder(2);
+    };
+    OrderBook orderBook;
+    fillBook(orderBook);
+
+    std::array<int, 32> filledIds{};
+    const auto simulated = orderBook.simulateOrder(buy, 42, 103, filledIds).value();
+    CHECK_EQ(orderBook.getSnapshot().asks[0], PriceLevel{101, 15});
+    CHECK_EQ(orderBook.getTotalVolume(), 0);
+
+    const auto executed = orderBook.addOrder(buy, 42, 103).value();
+    CHECK_EQ(simulated.sharesExecuted, executed.getTotalSharesExecuted());
+    CHECK(simulated.moneyExchanged == executed.getMoneyExchanged());
+    CHECK_EQ(simulated.levelsTouched, 3);
+    CHECK_EQ(simulated.filledOrders, executed.getFulfilledOrderIds().size());
+    CHECK_EQ(std::vector<int>(filledIds.begin(), filledIds.begin() + static_cast<long>(simulated.filledIdsRecorded)),
+             executed.getFulfilledOrderIds());
+    CHECK_EQ(simulated.partiallyFilledOrder, executed.getPartiallyFulfilledOrder());
+    CHECK(simulated.getAveragePrice().value() == doctest::Approx(executed.getMoneyExchanged().value() / 42.0 / Price::unitsPerWhole));
+
+    // A buffer too small for every id still counts them all
+    OrderBook other;
+    fillBook(other);
+    std::array<int, 2> fewIds{};
+    const auto counted = other.simulateOrder(buy, 42, 103, fewIds).value();
+    CHECK_EQ(counted.filledOrders, executed.getFulfilledOrderIds().size());
+    CHECK_EQ(counted.filledIdsRecorded, 2);
+    CHECK_EQ(fewIds[1], executed.getFulfilledOrderIds()[1]);
+    CHECK_EQ(counted.partiallyFilledOrder, executed.getPartiallyFulfilledOrder());
+
+    CHECK_FALSE(other.simulateOrder(sell, 10, 50).value().getAveragePrice());
+    CHECK_EQ(other.simulateOrder(buy, 0, 103).error(), RejectReason::invalidQuantity);
+}
+
+TEST_CASE("Queue positions count the shares ahead through adds, cancels and fills") {
+    OrderBook orderBook;
+    std::vector<std::pair<int, Qty>> queue;
+    std::mt19937 generator{7};
+
+    // Grows past the point the chunk index is built, then slowly drains through every kind of change
+    for(int round = 0; round < 2500; ++round) {
+        const auto action = generator() % 8;
+        if(round < 600 || action < 5 || queue.size() < 4) {
+            const Qty shares = static_cast<int>(generator() % 9) + 1;
+            queue.emplace_back(orderBook.addOrder(sell, shares, 100).value().getBaseId(), shares);
+        } else if(action < 7) {
+            const auto cancelled = queue.begin() + static_cast<long>(generator() % queue.size());
+            CHECK(orderBook.cancelOrder(cancelled->first));
+            queue.erase(cancelled);
+        } else {
+            Qty left = static_cast<int>(generator() % 40) + 1;
+            CHECK(orderBook.addOrder(buy, left, 100));
+            while(left > 0) {
+                const Qty taken = std::min(left, queue.front().second);
+                queue.front().second -= taken;
+                left -= taken;
+                if(queue.front().second == 0)
+                    queue.erase(queue.begin());
+            }
+        }
+
+        Qty ahead = 0;
+        for(std::size_t i = 0; i < queue.size(); ++i) {
+            if(i % 7 == static_cast<std::size_t>(round % 7))
+                CHECK_EQ(orderBook.getQueuePosition(queue[i].first).value(), ahead);
+            ahead += queue[i].second;
+        }
+    }
+
+    CHECK_EQ(orderBook.getQueuePosition(-1).error(), RejectReason::unknownOrderId);
+    const auto resting = orderBook.addOrder(sell, 3, 100).value();
+    CHECK_EQ(orderBook.getQueuePosition(*resting.getRestingHandle()).value(), orderBook.getAvailableShares(buy, 100) - 3);
+    CHECK(orderBook.cancelOrder(resting.getBaseId()));
+    CHECK_EQ(orderBook.getQueuePosition(*resting.getRestingHandle()).error(), RejectReason::unknownOrderId);
+}
+
+TEST_CASE("Self-trade prevention cancels instead of trading with the same account") {
+    using enum SelfTradePrevention;
+    struct Outcome {
+        Qty executed;
+        Qty cancelled;
+        std::vector<int> cancelledIds;
+        Qty sellsLeft;
+    };
+    auto run = [](SelfTradePrevention mode, Qty shares) {
+        OrderBook orderBook;
+        orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 5, .limitPrice = 100, .accountId = 1});
+        orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 10, .limitPrice = 100, .accountId = 2});
+        orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 5, .limitPrice = 100, .accountId = 1});
+        orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 5, .limitPrice = 101, .accountId = 1});
+
+        const auto execution = orderBook.addOrder(OrderRequest{
+            .orderType = buy, .selfTradePrevention = mode, .shares = shares, .limitPrice = 101, .accountId = 2}).value();
+        // What self-trade prevention cancelled never rests
+        CHECK_EQ(execution.getRestingHandle().has_value(), execution.getTotalSharesExecuted() + execution.getSharesCancelled() < shares);
+        for(const int cancelledId : execution.getSelfTradeCancelledIds())
+            CHECK_EQ(orderBook.cancelOrder(cancelledId).error(), RejectReason::unknownOrderId);
+        return Outcome{execution.getTotalSharesExecuted(), execution.getSharesCancelled(), execution.getSelfTradeCancelledIds(),
+                       orderBook.getAvailableShares(buy, 101)};
+    };
+
+    const Outcome trades = run(none, 15);
+    CHECK_EQ(trades.executed, 15);
+    CHECK_EQ(trades.sellsLeft, 10);
+
+    // Order 1 is the account's own resting sell
+    const Outcome newest = run(cancelNewest, 15);
+    CHECK_EQ(newest.executed, 5);
+    CHECK_EQ(newest.cancelled, 10);
+    CHECK_EQ(newest.sellsLeft, 20);
+
+    const Outcome oldest = run(cancelOldest, 15);
+    CHECK_EQ(oldest.executed, 15);
+    CHECK_EQ(oldest.cancelledIds, std::vector<int>{1});
+    CHECK_EQ(oldest.sellsLeft, 0);
+
+    const Outcome both = run(cancelBoth, 15);
+    CHECK_EQ(both.executed, 5);
+    CHECK_EQ(both.cancelled, 10);
+    CHECK_EQ(both.cancelledIds, std::vector<int>{1});
+    CHECK_EQ(both.sellsLeft, 10);
+
+    const Outcome decrementedAway = run(decrement, 15);
+    CHECK_EQ(decrementedAway.executed, 5);
+    CHECK_EQ(decrementedAway.cancelled, 10);
+    CHECK_EQ(decrementedAway.cancelledIds, std::vector<int>{1});
+    CHECK_EQ(decrementedAway.sellsLeft, 10);
+
+    // A smaller aggressive order only decrements the resting one, which keeps its place
+    OrderBook orderBook;
+    orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 10, .limitPrice = 100, .accountId = 2});
+    const int behind = orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 5, .limitPrice = 100, .accountId = 1}).value().getBaseId();
+    const auto execution = orderBook.addOrder(OrderRequest{
+        .orderType = buy, .selfTradePrevention = decrement, .shares = 7, .limitPrice = 100, .accountId = 2}).value();
+    CHECK_EQ(execution.getTotalSharesExecuted(), 0);
+    CHECK_EQ(execution.getSelfTradeDecrementedOrder(), std::pair<int, Qty>{0, 7});
+    CHECK_EQ(orderBook.getQueuePosition(behind).value(), 3);
+    CHECK_EQ(orderBook.getAvailableShares(buy, 100), 8);
+
+    // Orders sent without an account never meet their own
+    OrderBook untagged;
+    untagged.addOrder(sell, 10, 100);
+    CHECK_EQ(untagged.addOrder(OrderRequest{.orderType = buy, .selfTradePrevention = decrement, .shares = 10, .limitPrice = 100})
+                 .value().getTotalSharesExecuted(), 10);
+}
+
+TEST_CASE("Self-trade prevention is rejected where it can't be applied") {
+    OrderBook proRataBook{MatchingRules{.algorithm = MatchingAlgorithm::proRata}};
+    proRataBook.addOrder(OrderRequest{.orderType = sell, .shares = 10, .limitPrice = 100, .accountId = 7});
+    proRataBook.addOrder(OrderRequest{.orderType = sell, .shares = 10, .limitPrice = 100, .accountId = 8});
+    const OrderRequest selfTrading{
+        .orderType = buy, .selfTradePrevention = SelfTradePrevention::cancelNewest, .shares = 10, .limitPrice = 100, .accountId = 7};
+
+    // Pro-rata would share the fill with account 7's own order, so the order never reaches the book
+    CHECK_EQ(proRataBook.addOrder(selfTrading).error(), RejectReason::selfTradeUnsupported);
+    CHECK_EQ(proRataBook.getAvailableShares(buy, 100), 20);
+    CHECK_EQ(proRataBook.simulateOrder(selfTrading).error(), RejectReason::selfTradeUnsupported);
+
+    // Price-time books apply it, but the simulation still can't
+    OrderBook orderBook;
+    orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 10, .limitPrice = 100, .accountId = 7});
+    CHECK_EQ(orderBook.simulateOrder(selfTrading).error(), RejectReason::selfTradeUnsupported);
+    const OrderExecution execution = orderBook.addOrder(selfTrading).value();
+    CHECK_EQ(execution.getTotalSharesExecuted(), 0);
+    CHECK_EQ(execution.getSharesCancelled(), 10);
+}
+
+TEST_CASE("Self-trade prevention keeps deep queues consistent") {
+    using enum SelfTradePrevention;
+    struct Resting {
+        int orderId;
+        std::uint32_t accountId;
+        Qty shares;
+    };
+    std::vector<Resting> queue;
+    OrderBook orderBook;
+    std::mt19937 generator{29};
+
+    for(int round = 0; round < 3'000; ++round) {
+        const auto accountId = static_cast<std::uint32_t>(generator() % 6);
+        if(round < 400 || generator() % 3 != 0) {
+            const Qty shares = static_cast<int>(generator() % 9) + 1;
+            const int orderId = orderBook.addOrder(OrderRequest{.orderType = sell, .shares = shares, .limitPrice = 100, .accountId = accountId}).value().getBaseId();
+            queue.push_back({orderId, accountId, shares});
+            continue;
+        }
+
+        // Walk the model as the fill loop should
+        const auto mode = static_cast<SelfTradePrevention>(generator() % 5);
+        Qty left = static_cast<int>(generator() % 16) + 1;
+        const Qty shares = left;
+        Qty executed = 0;
+        Qty cancelled = 0;
+        std::vector<Resting> stillResting;
+        std::size_t next = 0;
+        for(; next < queue.size() && left > 0; ++next) {
+            Resting order = queue[next];
+            if(mode == none || order.accountId != accountId) {
+                const Qty taken = std::min(left, order.shares);
+                executed += taken;
+                left -= taken;
+                order.shares -= taken;
+            } else {
+                const Qty baseCancelled = mode == cancelOldest ? Qty{0} : mode == decrement ? std::min(left, order.shares) : left;
+                const Qty restingCancelled = mode == cancelNewest ? Qty{0} : mode == decrement ? baseCancelled : order.shares;
+                cancelled += baseCancelled;
+                left -= baseCancelled;
+                order.shares -= restingCancelled;
+            }
+            if(order.shares > 0)
+                stillResting.push_back(order);
+        }
+        stillResting.insert(stillResting.end(), queue.begin() + static_cast<long>(next), queue.end());
+
+        const auto execution = orderBook.addOrder(OrderRequest{.orderType = buy, .selfTradePrevention = mode, .shares = shares,
+                                                               .limitPrice = 100, .accountId = accountId}).value();
+        REQUIRE_EQ(execution.getTotalSharesExecuted(), executed);
+        REQUIRE_EQ(execution.getSharesCancelled(), cancelled);
+        queue = std::move(stillResting);
+
+        // Whatever is left of the buy rests on the other side, take it straight back out
+        if(execution.getRestingHandle())
+            CHECK(orderBook.cancelOrder(*execution.getRestingHandle()));
+
+        Qty ahead = 0;
+        for(std::size_t i = 0; i < queue.size(); ++i) {
+            if(i % 11 == static_cast<std::size_t>(round % 11))
+                REQUIRE_EQ(orderBook.getQueuePosition(queue[i].orderId).value(), ahead);
+            ahead += queue[i].shares;
+        }
+        REQUIRE_EQ(orderBook.getAvailableShares(buy, 100), ahead);
+    }
+}
+
+TEST_CASE("Mass cancels take out an account's orders, by side and price range") {
+    OrderBook orderBook;
+    auto add = [&](OrderType side, Price price, std::uint32_t accountId) {
+        return orderBook.addOrder(OrderRequest{.orderType = side, .shares = 10, .limitPrice = price, .accountId = accountId}).value().getBaseId();
+    };
+    add(buy, 95, 1);
+    const int otherAccount = add(buy, 96, 2);
+    add(buy, 97, 1);
+    const int keptSell = add(sell, 110, 1);
+    add(sell, 105, 1);
+    add(sell, 106, 1);
+    add(buy, 90, noAccount);
+    add(buy, 80, 0);
+
+    CHECK_EQ(orderBook.cancelAccountOrders(1, sell, 104, 107), 2);
+    CHECK_EQ(orderBook.getBestAsk(), 110);
+    CHECK_EQ(orderBook.cancelAccountOrders(1, buy), 2);
+    CHECK_EQ(orderBook.getBestBid(), 96);
+
+    // Cancelled orders are gone from the ID index, the rest of the book is untouched
+    CHECK(orderBook.cancelOrder(keptSell));
+    CHECK_EQ(orderBook.cancelAccountOrders(1), 0);
+    CHECK_EQ(orderBook.cancelAccountOrders(noAccount), 0);
+    CHECK_EQ(orderBook.cancelAccountOrders(2), 1);
+    CHECK_EQ(orderBook.cancelAccountOrders(0), 1);
+    CHECK_EQ(orderBook.cancelOrder(otherAccount).error(), RejectReason::unknownOrderId);
+    CHECK_EQ(orderBook.getBestBid(), 90);
+
+    // Queued while halted, and dropped before it can rest
+    CHECK(orderBook.setSessionState(SessionState::halted));
+    add(buy, 99, 3);
+    CHECK_EQ(orderBook.cancelAccountOrders(3), 1);
+    CHECK(orderBook.setSessionState(SessionState::continuous));
+    CHECK(orderBook.getReplayedExecutions().empty());
+    CHECK_EQ(orderBook.getBestBid(), 90);
+}
+
+TEST_CASE("Mass cancels only find orders still resting after fills and cancels") {
+    OrderBook orderBook;
+    std::vector<std::pair<int, std::uint32_t>> resting;
+    std::mt19937 generator{31};
+
+    for(int round = 0; round < 4'000; ++round) {
+        const auto accountId = static_cast<std::uint32_t>(generator() % 8) + 1;
+        const auto action = generator() % 10;
+        if(action < 6) {
+            const Price price = 100 + static_cast<int>(generator() % 10);
+            resting.emplace_back(
+                orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 5, .limitPrice = price, .accountId = accountId}).value().getBaseId(),
+                accountId);
+        } else if(action < 8 && !resting.empty()) {
+            // Fill from the best price, noting which orders are gone
+            const auto execution = orderBook.addOrder(buy, static_cast<int>(generator() % 30) + 1, 109).value();
+            if(execution.getRestingHandle())
+                CHECK(orderBook.cancelOrder(*execution.getRestingHandle()));
+            for(const int filledId : execution.getFulfilledOrderIds())
+                std::erase_if(resting, [&](const auto& order) { return order.first == filledId; });
+        } else if(action < 9 && !resting.empty()) {
+            const auto cancelled = resting.begin() + static_cast<long>(generator() % resting.size());
+            CHECK(orderBook.cancelOrder(cancelled->first));
+            resting.erase(cancelled);
+        } else {
+            const auto expected = static_cast<std::size_t>(
+                std::count_if(resting.begin(), resting.end(), [&](const auto& order) { return order.second == accountId; }));
+            REQUIRE_EQ(orderBook.cancelAccountOrders(accountId), expected);
+            std::erase_if(resting, [&](const auto& order) { return order.second == accountId; });
+        }
+    }
+
+    for(const auto& [orderId, accountId] : resting)
+        CHECK(orderBook.cancelOrder(orderId));
+    CHECK_FALSE(orderBook.getBestAsk());
+}
+
+TEST_CASE("Post-only orders never take liquidity") {
+    OrderBook orderBook;
+    orderBook.addOrder(sell, 10, 100);
+    orderBook.addOrder(buy, 10, 98);
+
+    const auto postOnly = [](OrderType side, Price price, std::uint8_t flags) {
+        return OrderRequest{.orderType = side, .flags = static_cast<std::uint8_t>(OrderFlags::postOnly | flags), .shares = 5, .limitPrice = price};
+    };
+    const int lastId = orderBook.addOrder(buy, 1, 1).value().getBaseId();
+    CHECK_EQ(orderBook.addOrder(postOnly(buy, 100, 0)).error(), RejectReason::postOnlyWouldCross);
+    CHECK_EQ(orderBook.addOrder(postOnly(sell, 97, 0)).error(), RejectReason::postOnlyWouldCross);
+
+    // Not crossing, so it simply rests, and rejections took no ID
+    const auto resting = orderBook.addOrder(postOnly(buy, 99, 0)).value();
+    CHECK_EQ(resting.getBaseId(), lastId + 1);
+    CHECK(resting.getRestingHandle());
+
+    // Repriced one tick behind the best contra price instead
+    const auto repriced = orderBook.addOrder(postOnly(buy, 105, OrderFlags::repricePostOnly)).value();
+    CHECK_EQ(repriced.getTotalSharesExecuted(), 0);
+    CHECK_EQ(orderBook.getOrderDetails(repriced.getBaseId()).value().limitPrice, 99);
+    CHECK(orderBook.addOrder(postOnly(sell, 90, OrderFlags::repricePostOnly)));
+    CHECK_EQ(orderBook.getBestAsk(), 100);
+    CHECK_EQ(orderBook.getTopOfBook().askShares, 15);
+    CHECK_EQ(orderBook.getTotalVolume(), 0);
+
+    // Queued while halted, ones that cross once replayed are rejected or repriced as they would have been on arrival
+    CHECK(orderBook.setSessionState(SessionState::halted));
+    orderBook.addOrder(postOnly(buy, 100, 0));
+    const int queuedRepriced = orderBook.addOrder(postOnly(buy, 100, OrderFlags::repricePostOnly)).value().getBaseId();
+    CHECK(orderBook.setSessionState(SessionState::continuous));
+    CHECK_EQ(orderBook.getReplayedExecutions()[0].getSharesCancelled(), 5);
+    CHECK_FALSE(orderBook.getReplayedExecutions()[0].getRestingHandle());
+    CHECK(orderBook.getReplayedExecutions()[1].getRestingHandle());
+    CHECK_EQ(orderBook.getOrderDetails(queuedRepriced).value().limitPrice, 99);
+    CHECK_EQ(orderBook.getTotalVolume(), 0);
+}
+
+TEST_CASE("Post-only orders are repriced against published depth only") {
+    OrderBook orderBook;
+    orderBook.addOrder(OrderRequest{.orderType = sell, .flags = OrderFlags::hidden, .shares = 100, .limitPrice = 100});
+    orderBook.addOrder(sell, 10, 105);
+    const auto repricedBuy = [](Price price) {
+        return OrderRequest{.orderType = buy, .flags = OrderFlags::postOnly | OrderFlags::repricePostOnly, .shares = 5, .limitPrice = price};
+    };
+
+    // One tick behind the published ask would still cross the hidden one, and behind the hidden one would show it
+    CHECK_EQ(orderBook.getBestAsk(), 105);
+    CHECK_EQ(orderBook.addOrder(repricedBuy(200)).error(), RejectReason::postOnlyWouldCross);
+    CHECK_EQ(orderBook.addOrder(repricedBuy(101)).error(), RejectReason::postOnlyWouldCross);
+    const auto resting = orderBook.addOrder(repricedBuy(99)).value();
+    CHECK(resting.getRestingHandle());
+
+    // With only hidden orders on the other side, there's nothing to reprice behind
+    OrderBook hiddenOnly;
+    hiddenOnly.addOrder(OrderRequest{.orderType = sell, .flags = OrderFlags::hidden, .shares = 100, .limitPrice = 100});
+    CHECK_FALSE(hiddenOnly.getBestAsk());
+    CHECK_EQ(hiddenOnly.addOrder(repricedBuy(100)).error(), RejectReason::postOnlyWouldCross);
+    CHECK_EQ(hiddenOnly.getTotalVolume(), 0);
+
+    // Once the hidden order is behind the published ask, repricing is safe again
+    CHECK(orderBook.cancelOrder(*resting.getRestingHandle()));
+    orderBook.addOrder(sell, 10, 98);
+    const auto repriced = orderBook.addOrder(repricedBuy(200)).value();
+    CHECK_EQ(orderBook.getOrderDetails(repriced.getBaseId()).value().limitPrice, 97);
+    CHECK_EQ(orderBook.getTotalVolume(), 0);
+}
+
+TEST_CASE("Hidden orders trade but stay out of published depth") {
+    OrderBook orderBook;
+    const auto hidden = [](OrderType side, Qty shares, Price price) {
+        return OrderRequest{.orderType = side, .flags = OrderFlags::hidden, .shares = shares, .limitPrice = price};
+    };
+    orderBook.addOrder(hidden(sell, 10, 100));
+    orderBook.addOrder(sell, 5, 101);
+    orderBook.addOrder(hidden(sell, 7, 101));
+    orderBook.addOrder(buy, 5, 99);
+
+    // The best ask is hidden, so the first level showing anything is published as the top
+    CHECK_EQ(orderBook.getBestAsk(), 101);
+    CHECK_EQ(orderBook.getTopOfBook(), TopOfBook{99, 5, 101, 5});
+    const BookSnapshot snapshot = orderBook.getSnapshot();
+    REQUIRE_EQ(snapshot.askLevels, 1);
+    CHECK_EQ(snapshot.asks[0], PriceLevel{101, 5});
+    CHECK_EQ(orderBook.getPublishedSnapshot(), snapshot);
+
+    // Matching doesn't care, and the hidden part of a level shrinks with fills
+    CHECK_EQ(orderBook.addOrder(buy, 17, 101).value().getTotalSharesExecuted(), 17);
+    CHECK_EQ(orderBook.getTopOfBook(), TopOfBook{99, 5, 0, 0});
+    CHECK_EQ(orderBook.getAvailableShares(buy, 101), 5);
+    CHECK_FALSE(orderBook.getTopOfBook().hasAsk());
+}
+
+TEST_CASE("Hidden shares stay accounted for through every kind of fill and cancel") {
+    std::mt19937 generator{50};
+    for(int round = 0; round < 20; ++round) {
+        OrderBook orderBook{round % 2 == 0 ? MatchingRules{} : MatchingRules{.algorithm = MatchingAlgorithm::proRata}};
+        std::vector<int> hiddenIds;
+        std::vector<int> orderIds;
+        for(int i = 0; i < 400; ++i) {
+            const auto accountId = static_cast<std::uint32_t>(generator() % 3);
+            if(generator() % 4 != 0) {
+                const bool isHidden = generator() % 2 == 0;
+                const int orderId = orderBook.addOrder(OrderRequest{.orderType = sell,
+                                                                    .flags = isHidden ? OrderFlags::hidden : std::uint8_t{0},
+                                                                    .shares = static_cast<int>(generator() % 20) + 1,
+                                                                    .limitPrice = 100 + static_cast<int>(generator() % snapshotDepth),
+                                                                    .accountId = accountId}).value().getBaseId();
+                (isHidden ? hiddenIds : orderIds).push_back(orderId);
+            } else if(generator() % 3 == 0 && !orderIds.empty()) {
+                orderBook.cancelOrder(orderIds[generator() % orderIds.size()]);
+            } else {
+                // Pro-rata books reject self-trade prevention, so only price-time rounds use it
+                const auto mode = static_cast<SelfTradePrevention>(generator() % 5);
+                const auto execution = orderBook.addOrder(OrderRequest{.orderType = buy,
+                                                                       .selfTradePrevention = round % 2 == 0 ? mode : SelfTradePrevention::none,
+                                                                       .shares = static_cast<int>(generator() % 40) + 1,
+                                                                       .limitPrice = 104,
+                                                                       .accountId = accountId}).value();
+                if(execution.getRestingHandle())
+                    CHECK(orderBook.cancelOrder(*execution.getRestingHandle()));
+            }
+
+            const BookSnapshot snapshot = orderBook.getSnapshot();
+            for(std::size_t level = 0; level < snapshot.askLevels; ++level) {
+                const Price price = snapshot.asks[level].price;
+                REQUIRE_LE(snapshot.asks[level].shares, orderBook.getAvailableShares(buy, price) - orderBook.getAvailableShares(buy, price - Price{1}));
+            }
+        }
+
+        // With every hidden order gone, the whole book is published again
+        for(const int orderId : hiddenIds)
+            orderBook.cancelOrder(orderId);
+        const BookSnapshot snapshot = orderBook.getSnapshot();
+        Qty published = 0;
+        for(std::size_t level = 0; level < snapshot.askLevels; ++level) {
+            const Price price = snapshot.asks[level].price;
+            CHECK_EQ(snapshot.asks[level].shares, orderBook.getAvailableShares(buy, price) - orderBook.getAvailableShares(buy, price - Price{1}));
+            published += snapshot.asks[level].shares;
+        }
+        CHECK_EQ(published, orderBook.getAvailableShares(buy, 104));
+    }
+}
+
+TEST_CASE("Minimum quantity orders only trade if enough is in reach") {
+    OrderBook orderBook;
+    orderBook.addOrder(sell, 10, 100);
+    orderBook.addOrder(sell, 10, 101);
+    const auto minimum = [](Qty shares, Price price, Qty minQuantity) {
+        return OrderRequest{.orderType = buy, .flags = OrderFlags::minimumQuantity, .shares = shares, .limitPrice = price, .minQuantity = minQuantity};
+    };
+
+    // Only 10 in reach at 100, so it's cancelled rather than trading or resting crossed
+    CHECK_EQ(orderBook.simulateOrder(minimum(15, 100, 15)).value().sharesExecuted, 0);
+    const auto cancelled = orderBook.addOrder(minimum(15, 100, 15)).value();
+    CHECK_EQ(cancelled.getTotalSharesExecuted(), 0);
+    CHECK_EQ(cancelled.getSharesCancelled(), 15);
+    CHECK_EQ(orderBook.getTopOfBook().askShares, 10);
+
+    // 20 in reach at 101, so it sweeps both levels and rests what's left as an ordinary order
+    const auto traded = orderBook.addOrder(minimum(25, 101, 15)).value();
+    CHECK_EQ(traded.getTotalSharesExecuted(), 20);
+    CHECK_EQ(orderBook.getBestBid(), 101);
+    CHECK_EQ(orderBook.getTopOfBook().bidShares, 5);
+
+    // Not crossing, so it rests straight away
+    CHECK(orderBook.addOrder(minimum(5, 90, 100)).value().getRestingHandle());
+}
+
+TEST_CASE("Minimum quantity doesn't count shares self-trade prevention takes away") {
+    using enum SelfTradePrevention;
+    for(const SelfTradePrevention mode : {cancelNewest, cancelOldest, cancelBoth, decrement}) {
+        CAPTURE(mode);
+        OrderBook orderBook;
+        orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 10, .limitPrice = 100, .accountId = 1});
+        orderBook.addOrder(OrderRequest{.orderType = sell, .shares = 10, .limitPrice = 100, .accountId = 2});
+        const auto minimum = [&](Qty minQuantity) {
+            return OrderRequest{.orderType = buy, .selfTradePrevention = mode, .flags = OrderFlags::minimumQuantity, .shares = 20,
+                                .limitPrice = 100, .minQuantity = minQuantity, .accountId = 1};
+        };
+
+        // Only account 2's 10 could trade, and under cancelNewest or cancelBoth not even those
+        const auto cancelled = orderBook.addOrder(minimum(20)).value();
+        CHECK_EQ(cancelled.getTotalSharesExecuted(), 0);
+        CHECK_EQ(cancelled.getSharesCancelled(), 20);
+        CHECK_EQ(orderBook.getAvailableShares(buy, 100), 20);
+
+        const Qty reachable = mode == cancelOldest || mode == decrement ? 10 : 0;
+        const auto traded = orderBook.addOrder(minimum(10)).value();
+        CHECK_EQ(traded.getTotalSharesExecuted(), reachable);
+        if(reachable == 0)
+            CHECK_EQ(traded.getSharesCancelled(), 20);
+    }
 }
 
 TEST_SUITE_END();
\ No newline at end of file
@@ -0,0 +1,139 @@
+/**
+ * @file priceBands.test.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Unit tests for static price collars and the dynamic bands sweeps stop at
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "orderBook.hpp"
+#include "priceBands.hpp"
+#include "riskLedger.hpp"
+#include "doctest.h"
+#include <cstdint>
+#include <limits>
+
+using namespace Exchange;
+using enum OrderType;
+
+TEST_SUITE_BEGIN("priceBands");
+
+TEST_CASE("Band edges are worked out from their centre") {
+    PriceBands bands;
+    CHECK(bands.isInsideCollar(std::numeric_limits<std::int64_t>::max()));
+    CHECK_EQ(bands.getSweepLimit<buy>(5'000), 5'000);
+
+    // 5% of 1'050 is 52.5, rounded in towards the centre
+    bands.setRules(PriceBandRules{.staticBasisPoints = 1'000, .dynamicBasisPoints = 500}, 1'050);
+    CHECK_EQ(bands.getCollarLow(), 945);
+    CHECK_EQ(bands.getCollarHigh(), 1'155);
+    CHECK_EQ(bands.getDynamicLow(), 998);
+    CHECK_EQ(bands.getDynamicHigh(), 1'102);
+    CHECK_EQ(bands.getSweepLimit<buy>(1'200), 1'102);
+    CHECK_EQ(bands.getSweepLimit<buy>(1'000), 1'000);
+    CHECK_EQ(bands.getSweepLimit<sell>(900), 998);
+
+    // Trades only move the dynamic band, and it stays put if the rules are set again
+    bands.recordTrade(2'000);
+    CHECK_EQ(bands.getCollarHigh(), 1'155);
+    CHECK_EQ(bands.getDynamicLow(), 1'900);
+    CHECK_EQ(bands.getDynamicHigh(), 2'100);
+    bands.setRules(PriceBandRules{.staticBasisPoints = 0, .dynamicBasisPoints = 1'000}, 1'050);
+    CHECK(bands.isInsideCollar(1));
+    CHECK_EQ(bands.getDynamicLow(), 1'800);
+
+    // Edges past the prices an int64 holds saturate rather than wrap
+    constexpr std::int64_t highest = std::numeric_limits<std::int64_t>::max();
+    constexpr std::int64_t lowest = std::numeric_limits<std::int64_t>::min();
+    bands.setRules(PriceBandRules{.staticBasisPoints = 5'000}, highest - 10);
+    CHECK_EQ(bands.getCollarHigh(), highest);
+    CHECK_EQ(bands.getCollarLow(), highest - 10 - (highest - 10) / 2);
+    bands.setRules(PriceBandRules{.staticBasisPoints = 5'000}, lowest);
+    CHECK_EQ(bands.getCollarLow(), lowest);
+    CHECK(bands.isInsideCollar(lowest / 2));
+    CHECK_FALSE(bands.isInsideCollar(lowest / 2 + 1));
+}
+
+TEST_CASE("Orders priced outside the static band are rejected") {
+    OrderBook orderBook;
+    orderBook.setPriceBands(PriceBandRules{.staticBasisPoints = 1'000}, 1'000);
+
+    CHECK_EQ(orderBook.addOrder(buy, 10, 1'101).error(), RejectReason::outsidePriceBand);
+    CHECK_EQ(orderBook.addOrder(sell, 10, 899).error(), RejectReason::outsidePriceBand);
+    CHECK_EQ(orderBook.simulateOrder(buy, 10, 1'101).error(), RejectReason::outsidePriceBand);
+    CHECK(orderBook.addOrder(buy, 10, 1'100));
+    CHECK_EQ(orderBook.addOrder(sell, 10, 900).value().getTotalSharesExecuted(), 10);
+}
+
+TEST_CASE("Sweeps stop at the dynamic band and cancel what they have left") {
+    RiskLedger ledger{2};
+    OrderBook orderBook;
+    orderBook.setRiskLedger(&ledger);
+    orderBook.setPriceBands(PriceBandRules{.dynamicBasisPoints = 500}, 1'000);
+    auto add = [&](OrderType side, Qty shares, Price price, std::uint32_t accountId) {
+        return orderBook.addOrder(OrderRequest{.orderType = side, .shares = shares, .limitPrice = price, .accountId = accountId}).value();
+    };
+    for(const int price : {1'000, 1'040, 1'050, 1'060})
+        add(sell, 10, price, 0);
+
+    // Far from the band, but not crossing, so it rests as usual
+    CHECK(add(buy, 10, 500, 0).getRestingHandle());
+
+    CHECK_EQ(orderBook.simulateOrder(buy, 50, 2'000).value().sharesExecuted, 30);
+    const OrderExecution runaway = add(buy, 50, 2'000, 1);
+    CHECK_EQ(runaway.getTotalSharesExecuted(), 30);
+    CHECK_EQ(runaway.getSharesCancelled(), 20);
+    CHECK_FALSE(runaway.getRestingHandle());
+    CHECK_EQ(orderBook.getBestAsk(), 1'060);
+    CHECK_EQ(orderBook.getBestBid(), 500);
+    CHECK_EQ(ledger.getCreditUsed(1), Notional{0});
+    CHECK_EQ(ledger.getPosition(1), 30);
+
+    // The band moved to the last trade, 1'050, so the next sweep reaches 1'060
+    CHECK_EQ(orderBook.getPriceBands().getDynamicHigh(), 1'102);
+    CHECK_EQ(add(buy, 10, 2'000, 0).getTotalSharesExecuted(), 10);
+
+    // A crossing order whose best contra level is already past the band trades nothing
+    add(sell, 10, 1'200, 0);
+    const OrderExecution blocked = add(buy, 10, 1'200, 0);
+    CHECK_EQ(blocked.getTotalSharesExecuted(), 0);
+    CHECK_EQ(blocked.getSharesCancelled(), 10);
+    CHECK_EQ(orderBook.getBestBid(), 500);
+}
+
+TEST_CASE("Levels self-trade prevention only cancelled at don't move the dynamic band") {
+    OrderBook orderBook;
+    orderBook.setPriceBands(PriceBandRules{.dynamicBasisPoints = 500}, 1'000);
+    auto add = [&](OrderType side, Qty shares, Price price, std::uint32_t accountId) {
+        return orderBook.addOrder(OrderRequest{.orderType = side, .selfTradePrevention = SelfTradePrevention::cancelOldest,
+                                               .shares = shares, .limitPrice = price, .accountId = accountId}).value();
+    };
+    add(sell, 10, 1'000, 1);
+    add(sell, 10, 1'040, 2);
+
+    // Trades at 1'000, then only cancels its own order at 1'040 and rests there
+    const OrderExecution execution = add(buy, 20, 1'040, 2);
+    CHECK_EQ(execution.getTotalSharesExecuted(), 10);
+    CHECK_EQ(execution.getSelfTradeCancelledIds().size(), 1);
+    CHECK(execution.getRestingHandle());
+    CHECK_EQ(orderBook.getPriceBands().getDynamicLow(), 950);
+    CHECK_EQ(orderBook.getPriceBands().getDynamicHigh(), 1'050);
+}
+
+TEST_CASE("Auction uncrosses move the dynamic band") {
+    OrderBook orderBook;
+    orderBook.setPriceBands(PriceBandRules{.dynamicBasisPoints = 1'000}, 1'000);
+    CHECK(orderBook.setSessionState(SessionState::auction));
+
+    // Orders rest during the auction wherever the dynamic band is, only the static band applies to them
+    orderBook.addOrder(buy, 10, 2'000);
+    orderBook.addOrder(sell, 10, 2'000);
+    CHECK_EQ(orderBook.uncrossAuction(1'000).value().uncross->price, 2'000);
+    CHECK_EQ(orderBook.getPriceBands().getDynamicLow(), 1'800);
+    CHECK_EQ(orderBook.getPriceBands().getDynamicHigh(), 2'200);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,214 @@
+/**
+ * @file priceLevels.test.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Unit tests for the inline, tree and ladder storage of a side's price levels, and the choice between them
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "orderBook.hpp"
+#include "priceLevels.hpp"
+#include "doctest.h"
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace Exchange;
+using enum OrderType;
+
+namespace {
+
+/**
+ * @brief Run random inserts and erases against a side and a std::map, checking they always agree
+ *
+ * @tparam side         Side under test
+ * @param largeStorage  Storage the side moves to past the inline capacity
+ * @param priceRange    Prices are drawn from [1, priceRange]
+ */
+template <OrderType side> void checkAgainstMap(LevelStorage largeStorage, int priceRange) {
+    PriceLevels<side> levels;
+    levels.setLargeStorage(largeStorage);
+    using Compare = std::conditional_t<side == buy, std::greater<>, std::less<>>;
+    std::map<Price, LevelIndex, Compare> expected;
+    std::mt19937 generator{11};
+    bool sawLargeStorage = false;
+
+    for(LevelIndex step = 0; step < 20'000; ++step) {
+        const Price price = 1 + static_cast<int>(generator() % static_cast<unsigned>(priceRange));
+        // Drift towards growing for the first half, then shrink back down
+        const bool grow = generator() % 8 < (step < 10'000 ? 5U : 3U);
+        if(grow) {
+            auto [level, isNew] = levels.findOrInsert(price);
+            REQUIRE_EQ(isNew, !expected.contains(price));
+            if(isNew)
+                level = expected[price] = step;
+            else
+                REQUIRE_EQ(level, expected[price]);
+        } else if(!expected.empty()) {
+            const auto victim = std::next(expected.begin(), static_cast<long>(generator() % expected.size()));
+            levels.erase(victim->first);
+            expected.erase(victim);
+        }
+
+        sawLargeStorage |= levels.getStorage() == largeStorage;
+        REQUIRE_EQ(levels.size(), expected.size());
+        if(expected.empty())
+            continue;
+        REQUIRE_EQ(levels.getBestPrice(), expected.begin()->first);
+        REQUIRE_EQ(levels.getBestLevel(), expected.begin()->second);
+        REQUIRE_EQ(levels.getWorstPrice(), expected.rbegin()->first);
+    }
+
+    CHECK(sawLargeStorage);
+    auto expectedIt = expected.begin();
+    levels.visitBestFirst(expected.size(), [&](Price price, LevelIndex level) {
+        CHECK_EQ(price, expectedIt->first);
+        CHECK_EQ(level, expectedIt->second);
+        ++expectedIt;
+    });
+    CHECK(expectedIt == expected.end());
+}
+
+} // namespace
+
+TEST_SUITE_BEGIN("priceLevels");
+
+TEST_CASE("Price levels move between inline arrays and a tree") {
+    PriceLevels<buy> bids;
+    const std::vector<Price> prices{50, 20, 70, 10, 60, 30, 80, 40, 90, 55, 25};
+    for(std::size_t i = 0; i < prices.size(); ++i) {
+        auto [level, isNew] = bids.findOrInsert(prices[i]);
+        CHECK(isNew);
+        level = static_cast<LevelIndex>(i);
+        CHECK_EQ(bids.getStorage(), i >= smallLevelCapacity ? LevelStorage::tree : LevelStorage::inlineArrays);
+    }
+    CHECK_FALSE(bids.findOrInsert(70).second);
+    CHECK_EQ(bids.getBestPrice(), 90);
+
+    auto visitedPrices = [&] {
+        std::vector<Price> visited;
+        bids.visitBestFirst(prices.size(), [&](Price price, LevelIndex) { visited.push_back(price); });
+        return visited;
+    };
+    CHECK_EQ(visitedPrices(), std::vector<Price>{90, 80, 70, 60, 55, 50, 40, 30, 25, 20, 10});
+
+    // Shrinking to half the inline capacity moves back out of the tree, keeping each price's level
+    for(const Price price : {90, 10, 55, 30, 25, 70, 40})
+        bids.erase(price);
+    CHECK_EQ(bids.getStorage(), LevelStorage::inlineArrays);
+    CHECK_EQ(visitedPrices(), std::vector<Price>{80, 60, 50, 20});
+    CHECK_EQ(bids.getBestLevel(), 6);
+    CHECK_EQ(bids.findOrInsert(20).first, 1);
+}
+
+TEST_CASE("Every storage agrees with a sorted map") {
+    checkAgainstMap<buy>(LevelStorage::tree, 200);
+    checkAgainstMap<sell>(LevelStorage::tree, 200);
+    checkAgainstMap<buy>(LevelStorage::ladder, 200);
+    checkAgainstMap<sell>(LevelStorage::ladder, 200);
+    // Ranges past a word of the ladder's bitmap and growth at both ends
+    checkAgainstMap<buy>(LevelStorage::ladder, 5'000);
+    checkAgainstMap<sell>(LevelStorage::ladder, 5'000);
+}
+
+TEST_CASE("A ladder that would get too wide becomes a tree") {
+    PriceLevels<sell> asks;
+    asks.setLargeStorage(LevelStorage::ladder);
+    for(int price = 1; price <= 10; ++price)
+        asks.findOrInsert(price).first = static_cast<LevelIndex>(price);
+    CHECK_EQ(asks.getStorage(), LevelStorage::ladder);
+
+    asks.findOrInsert(Price{1} + Price{maxLadderTicks}).first = 99;
+    CHECK_EQ(asks.getStorage(), LevelStorage::tree);
+    CHECK_EQ(asks.getBestLevel(), 1);
+    CHECK_EQ(asks.getWorstPrice(), Price{1} + Price{maxLadderTicks});
+
+    // Moving an already large side reports the levels it copied
+    CHECK_EQ(asks.setLargeStorage(LevelStorage::tree), 0);
+    CHECK_EQ(asks.size(), 11);
+}
+
+TEST_CASE("Widely spread inline levels outgrow the arrays into a tree, not a ladder") {
+    PriceLevels<sell> asks;
+    asks.setLargeStorage(LevelStorage::ladder);
+    const Price farAway = Price{1} + Price{maxLadderTicks * 1'000};
+    for(int i = 0; i < static_cast<int>(smallLevelCapacity) - 1; ++i)
+        asks.findOrInsert(i + 1).first = static_cast<LevelIndex>(i + 1);
+    asks.findOrInsert(farAway).first = 99;
+    CHECK_EQ(asks.getStorage(), LevelStorage::inlineArrays);
+
+    // The ninth level would need a ladder wider than maxLadderTicks
+    asks.findOrInsert(50).first = 50;
+    CHECK_EQ(asks.getStorage(), LevelStorage::tree);
+    CHECK_EQ(asks.getLargeStorage(), LevelStorage::ladder);
+    CHECK_EQ(asks.size(), smallLevelCapacity + 1);
+    CHECK_EQ(asks.getBestLevel(), 1);
+    CHECK_EQ(asks.getWorstPrice(), farAway);
+
+    // Once narrow again the ladder is used
+    asks.erase(farAway);
+    for(int price = 100; price < 110; ++price)
+        asks.findOrInsert(price).first = static_cast<LevelIndex>(price);
+    while(asks.size() > smallLevelCapacity / 2)
+        asks.erase(asks.getWorstPrice());
+    for(int price = 200; price < 210; ++price)
+        asks.findOrInsert(price).first = static_cast<LevelIndex>(price);
+    CHECK_EQ(asks.getStorage(), LevelStorage::ladder);
+}
+
+TEST_CASE("Dense or churning levels get a ladder, sparse ones a tree") {
+    LevelActivity quiet{.adds = 1000};
+    LevelActivity churning{.adds = 600, .cancels = 424, .levelChanges = 400};
+
+    CHECK_EQ(chooseLevelStorage(quiet, 100, 500, LevelStorage::tree), LevelStorage::ladder);
+    CHECK_EQ(chooseLevelStorage(quiet, 100, 5'000, LevelStorage::tree), LevelStorage::tree);
+    CHECK_EQ(chooseLevelStorage(churning, 100, 5'000, LevelStorage::tree), LevelStorage::ladder);
+    CHECK_EQ(chooseLevelStorage(churning, 100, 50'000, LevelStorage::tree), LevelStorage::tree);
+    CHECK_EQ(chooseLevelStorage(churning, 10'000, maxLadderTicks + 1, LevelStorage::ladder), LevelStorage::tree);
+
+    // A ladder is kept until the levels are clearly sparse
+    CHECK_EQ(chooseLevelStorage(quiet, 100, 20'000, LevelStorage::ladder), LevelStorage::ladder);
+    CHECK_EQ(chooseLevelStorage(quiet, 100, 30'000, LevelStorage::ladder), LevelStorage::tree);
+}
+
+TEST_CASE("A busy dense book moves itself to ladders and back") {
+    OrderBook orderBook;
+    for(int price = 1; price <= 100; ++price) {
+        orderBook.addOrder(buy, 10, price);
+        orderBook.addOrder(sell, 10, 100 + price);
+    }
+    CHECK_EQ(orderBook.getLevelStorage(buy), LevelStorage::tree);
+
+    // Trade the touch back and forth for a few activity windows
+    for(unsigned i = 0; i < 2 * levelActivityWindow; ++i) {
+        orderBook.addOrder(buy, 10, 101);
+        orderBook.addOrder(sell, 10, 101);
+    }
+    CHECK_EQ(orderBook.getLevelStorage(buy), LevelStorage::ladder);
+    CHECK_EQ(orderBook.getLevelStorage(sell), LevelStorage::ladder);
+    CHECK_EQ(orderBook.getLevelMigrationStats().migrations, 2);
+    CHECK_EQ(orderBook.getLevelMigrationStats().levelsMoved, 200);
+    CHECK_EQ(orderBook.getBestBid(), 100);
+    CHECK_EQ(orderBook.getBestAsk(), 101);
+
+    const auto snapshot = orderBook.getSnapshot();
+    CHECK_EQ(snapshot.bids[0], PriceLevel{100, 10});
+    CHECK_EQ(snapshot.bids[4], PriceLevel{96, 10});
+    CHECK_EQ(snapshot.asks[4], PriceLevel{105, 10});
+
+    // Spread the bids thinly over a wide range, and they go back to a tree
+    for(int i = 1; i <= 300; ++i)
+        orderBook.addOrder(buy, 10, -1000 * i);
+    for(unsigned i = 0; i < levelActivityWindow; ++i)
+        orderBook.cancelOrder(orderBook.addOrder(buy, 10, 50)->getBaseId());
+    CHECK_EQ(orderBook.getLevelStorage(buy), LevelStorage::tree);
+    CHECK_EQ(orderBook.getLevelStorage(sell), LevelStorage::ladder);
+    CHECK_EQ(orderBook.getBestBid(), 100);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,207 @@
+/**
+ * @file riskLedger.test.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Unit tests for pre-trade risk checks, and the ledger's counters following fills and cancels
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "orderBook.hpp"
+#include "riskLedger.hpp"
+#include "doctest.h"
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Exchange;
+using enum OrderType;
+
+namespace {
+
+/**
+ * @brief Build an order for an account
+ *
+ * @param side          Buy or sell
+ * @param shares        Number of shares
+ * @param limitPrice    Price of order
+ * @param accountId     Account sending it
+ * @param stp           Self-trade prevention mode
+ * @return The request
+ */
+auto makeRequest(OrderType side, Qty shares, Price limitPrice, std::uint32_t accountId,
+                 SelfTradePrevention stp = SelfTradePrevention::none) -> OrderRequest {
+    return OrderRequest{.orderType = side, .selfTradePrevention = stp, .shares = shares, .limitPrice = limitPrice,
+                        .accountId = accountId};
+}
+
+} // namespace
+
+TEST_SUITE_BEGIN("riskLedger");
+
+TEST_CASE("Orders breaching their account's limits are rejected before reaching the book") {
+    RiskLedger ledger{3};
+    ledger.setLimits(1, RiskLimits{.maxOrderShares = 100, .maxOrderNotional = 5'000, .creditLimit = 8'000, .maxPosition = 150});
+    OrderBook orderBook;
+    orderBook.setRiskLedger(&ledger);
+
+    CHECK_EQ(orderBook.addOrder(makeRequest(buy, 101, 10, 1)).error(), RejectReason::orderTooLarge);
+    CHECK_EQ(orderBook.addOrder(makeRequest(buy, 60, 100, 1)).error(), RejectReason::orderTooLarge);
+    CHECK_EQ(orderBook.addOrder(makeRequest(buy, 10, 10, 3)).error(), RejectReason::unknownAccount);
+
+    // 4'000 then 3'000 of credit fit, another 2'000 doesn't
+    const int firstBuy = orderBook.addOrder(makeRequest(buy, 40, 100, 1)).value().getBaseId();
+    CHECK(orderBook.addOrder(makeRequest(sell, 30, 110, 1)));
+    CHECK_EQ(orderBook.addOrder(makeRequest(buy, 20, 100, 1)).error(), RejectReason::creditExceeded);
+    CHECK_EQ(ledger.getCreditUsed(1), Notional{7'300});
+    CHECK_EQ(ledger.getOpenShares(1, buy), 40);
+    CHECK_EQ(ledger.getOpenShares(1, sell), 30);
+
+    // Rejected orders take no ID and leave the book alone, and orders without an account are rejected too
+    CHECK_EQ(orderBook.addOrder(buy, 1, 1).error(), RejectReason::unknownAccount);
+    CHECK_EQ(orderBook.addOrder(makeRequest(buy, 1, 1, 0)).value().getBaseId(), firstBuy + 2);
+    CHECK_EQ(orderBook.getTopOfBook().bidShares, 40);
+
+    // Account 2 sells into the bid, moving account 1 to long 40 and freeing its credit
+    CHECK_EQ(orderBook.addOrder(makeRequest(sell, 40, 100, 2)).value().getTotalSharesExecuted(), 40);
+    CHECK_EQ(ledger.getPosition(1), 40);
+    CHECK_EQ(ledger.getPosition(2), -40);
+    CHECK_EQ(ledger.getCreditUsed(1), Notional{3'300});
+    CHECK_EQ(ledger.getCreditUsed(2), Notional{0});
+
+    // Long 40, so buying 100 more could reach 140, but another 20 on top could reach 160
+    CHECK_EQ(orderBook.addOrder(makeRequest(buy, 100, 10, 1)).value().getTotalSharesExecuted(), 0);
+    CHECK_EQ(orderBook.addOrder(makeRequest(buy, 20, 10, 1)).error(), RejectReason::positionExceeded);
+
+    // Cancelling gives it all back
+    CHECK_EQ(orderBook.cancelAccountOrders(1), 2);
+    CHECK_EQ(ledger.getCreditUsed(1), Notional{0});
+    CHECK_EQ(ledger.getOpenShares(1, buy), 0);
+    CHECK_EQ(ledger.getOpenShares(1, sell), 0);
+    CHECK_EQ(ledger.getPosition(1), 40);
+}
+
+TEST_CASE("Orders queued while halted are counted, and given back if they're dropped") {
+    RiskLedger ledger{2};
+    ledger.setLimits(1, RiskLimits{.creditLimit = 1'000});
+    OrderBook orderBook;
+    orderBook.setRiskLedger(&ledger);
+
+    CHECK(orderBook.setSessionState(SessionState::halted));
+    CHECK(orderBook.addOrder(makeRequest(buy, 6, 100, 1)));
+    CHECK_EQ(orderBook.addOrder(makeRequest(buy, 6, 100, 1)).error(), RejectReason::creditExceeded);
+    CHECK_EQ(ledger.getCreditUsed(1), Notional{600});
+
+    CHECK(orderBook.setSessionState(SessionState::closed));
+    CHECK_EQ(ledger.getCreditUsed(1), Notional{0});
+    CHECK_EQ(orderBook.addOrder(makeRequest(buy, 1, 100, 1)).error(), RejectReason::sessionClosed);
+    CHECK_EQ(ledger.getCreditUsed(1), Notional{0});
+}
+
+TEST_CASE("Orders queued while halted that the collar moved away from are cancelled on replay") {
+    RiskLedger ledger{2};
+    ledger.setLimits(1, RiskLimits{.creditLimit = 10'000});
+    OrderBook orderBook;
+    orderBook.setRiskLedger(&ledger);
+    orderBook.setPriceBands(PriceBandRules{.staticBasisPoints = 1'000}, 100);
+
+    CHECK(orderBook.setSessionState(SessionState::halted));
+    const int outside = orderBook.addOrder(makeRequest(buy, 10, 95, 1)).value().getBaseId();
+    const int inside = orderBook.addOrder(makeRequest(buy, 10, 105, 1)).value().getBaseId();
+    CHECK_EQ(ledger.getCreditUsed(1), Notional{2'000});
+
+    // Re-centred on 110, the collar is now 99 to 121
+    orderBook.setPriceBands(PriceBandRules{.staticBasisPoints = 1'000}, 110);
+    CHECK(orderBook.setSessionState(SessionState::continuous));
+    const auto replayed = orderBook.getReplayedExecutions();
+    REQUIRE_EQ(replayed.size(), 2);
+    CHECK_EQ(replayed[0].getBaseId(), outside);
+    CHECK_EQ(replayed[0].getSharesCancelled(), 10);
+    CHECK_FALSE(replayed[0].getRestingHandle());
+    CHECK_EQ(replayed[1].getBaseId(), inside);
+    CHECK(replayed[1].getRestingHandle());
+
+    CHECK_EQ(orderBook.getBestBid(), 105);
+    CHECK_EQ(orderBook.cancelOrder(outside).error(), RejectReason::unknownOrderId);
+    CHECK_EQ(ledger.getCreditUsed(1), Notional{1'050});
+}
+
+TEST_CASE("The ledger follows every fill and cancel on both sides of the book") {
+    std::mt19937 generator{48};
+    const std::vector<SelfTradePrevention> modes{SelfTradePrevention::none, SelfTradePrevention::cancelNewest,
+                                                 SelfTradePrevention::cancelOldest, SelfTradePrevention::cancelBoth,
+                                                 SelfTradePrevention::decrement};
+    constexpr std::uint32_t accountCount = 5;
+
+    for(int round = 0; round < 40; ++round) {
+        RiskLedger ledger{accountCount};
+        OrderBook orderBook{round % 2 == 0 ? MatchingRules{} : MatchingRules{.algorithm = MatchingAlgorithm::proRata}};
+        orderBook.setRiskLedger(&ledger);
+        std::vector<int> orderIds;
+
+        for(int i = 0; i < 300; ++i) {
+            const auto accountId = static_cast<std::uint32_t>(generator() % accountCount);
+            if(generator() % 5 == 0 && !orderIds.empty()) {
+                orderBook.cancelOrder(orderIds[generator() % orderIds.size()]);
+                continue;
+            }
+            const OrderType side = generator() % 2 == 0 ? buy : sell;
+            const Price price = 95 + static_cast<int>(generator() % 11);
+            const Qty shares = 1 + static_cast<int>(generator() % 30);
+            // Pro-rata books reject self-trade prevention, so only price-time rounds use it
+            const SelfTradePrevention mode = modes[generator() % modes.size()];
+            const auto request = makeRequest(side, shares, price, accountId, round % 2 == 0 ? mode : SelfTradePrevention::none);
+            orderIds.push_back(orderBook.addOrder(request).value().getBaseId());
+        }
+
+        // Whatever rests is still counted, once it's all cancelled only positions are left, and they net out
+        for(std::uint32_t accountId = 0; accountId < accountCount; ++accountId)
+            orderBook.cancelAccountOrders(accountId);
+        for(const int orderId : orderIds)
+            orderBook.cancelOrder(orderId);
+
+        Qty netPosition = 0;
+        for(std::uint32_t accountId = 0; accountId < accountCount; ++accountId) {
+            CHECK_EQ(ledger.getCreditUsed(accountId), Notional{0});
+            CHECK_EQ(ledger.getOpenShares(accountId, buy), 0);
+            CHECK_EQ(ledger.getOpenShares(accountId, sell), 0);
+            netPosition += ledger.getPosition(accountId);
+        }
+        CHECK_EQ(netPosition, 0);
+    }
+}
+
+TEST_CASE("Racing reservations never admit more than an account's credit") {
+    constexpr std::int64_t orderNotional = 100;
+    constexpr std::int64_t maxOpenOrders = 10;
+    RiskLedger ledger{2};
+    ledger.setLimits(1, RiskLimits{.creditLimit = orderNotional * maxOpenOrders});
+
+    std::atomic<std::int64_t> admitted{0};
+    std::atomic<bool> overAdmitted{false};
+    std::vector<std::thread> threads;
+    for(int thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&] {
+            for(int i = 0; i < 20'000; ++i) {
+                if(!ledger.reserve(1, buy, 1, orderNotional))
+                    continue;
+                if(admitted.fetch_add(1) + 1 > maxOpenOrders)
+                    overAdmitted = true;
+                admitted.fetch_sub(1);
+                ledger.release(1, buy, 1, orderNotional);
+            }
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+
+    CHECK_FALSE(overAdmitted.load());
+    CHECK_EQ(ledger.getCreditUsed(1), Notional{0});
+    CHECK_EQ(ledger.getOpenShares(1, buy), 0);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,147 @@
+/**
+ * @file seqlock.test.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Concurrency stress tests for the Seqlock and the snapshots OrderBook publishes through it
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "orderBook.hpp"
+#include "seqlock.hpp"
+#include "doctest.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace Exchange;
+using enum OrderType;
+
+namespace {
+
+/// @brief Every field is written with the same value, so a torn read shows up as differing fields
+struct Stamp {
+    std::array<std::uint64_t, 8> fields{};
+};
+
+constexpr int readerThreads = 3;
+
+} // namespace
+
+TEST_SUITE_BEGIN("seqlock");
+
+TEST_CASE("Seqlock starts out default constructed") {
+    Seqlock<Stamp> seqlock;
+    std::uint64_t writeCount = 1;
+
+    CHECK_EQ(seqlock.read(writeCount).fields[0], 0);
+    CHECK_EQ(writeCount, 0);
+    CHECK_EQ(seqlock.getWriteCount(), 0);
+}
+
+TEST_CASE("Seqlock readers never see torn writes") {
+    constexpr std::uint64_t writes = 200'000;
+    Seqlock<Stamp> seqlock;
+    std::atomic<bool> done{false};
+    std::atomic<int> tornReads{0};
+
+    std::vector<std::thread> readers;
+    for(int i = 0; i < readerThreads; ++i) {
+        readers.emplace_back([&] {
+            std::uint64_t lastValue = 0;
+            while(!done.load(std::memory_order_acquire)) {
+                const Stamp stamp = seqlock.read();
+                for(const auto field : stamp.fields)
+                    if(field != stamp.fields[0])
+                        tornReads.fetch_add(1);
+                // Values only ever go up
+                if(stamp.fields[0] < lastValue)
+                    tornReads.fetch_add(1);
+                lastValue = stamp.fields[0];
+            }
+        });
+    }
+
+    for(std::uint64_t i = 1; i <= writes; ++i) {
+        Stamp stamp;
+        stamp.fields.fill(i);
+        seqlock.write(stamp);
+    }
+    done.store(true, std::memory_order_release);
+
+    for(auto& reader : readers)
+        reader.join();
+
+    CHECK_EQ(tornReads.load(), 0);
+    CHECK_EQ(seqlock.getWriteCount(), writes);
+    CHECK_EQ(seqlock.read().fields[7], writes);
+}
+
+TEST_CASE("OrderBook snapshots stay consistent under concurrent readers") {
+    OrderBook orderBook;
+    std::atomic<bool> done{false};
+    std::atomic<int> badSnapshots{0};
+
+    std::vector<std::thread> readers;
+    for(int i = 0; i < readerThreads; ++i) {
+        readers.emplace_back([&] {
+            std::uint64_t cursor = 0;
+            while(!done.load(std::memory_order_acquire)) {
+                const BookSnapshot snapshot = orderBook.getPublishedSnapshot();
+                bool consistent = snapshot.bidLevels <= snapshotDepth && snapshot.askLevels <= snapshotDepth;
+
+                for(std::size_t level = 0; consistent && level < snapshot.bidLevels; ++level)
+                    consistent = snapshot.bids[level].shares > 0 &&
+                                 (level == 0 || snapshot.bids[level].price < snapshot.bids[level - 1].price);
+                for(std::size_t level = 0; consistent && level < snapshot.askLevels; ++level)
+                    consistent = snapshot.asks[level].shares > 0 &&
+                                 (level == 0 || snapshot.asks[level].price > snapshot.asks[level - 1].price);
+
+                // A completed operation never leaves the book crossed
+                if(consistent && snapshot.bidLevels > 0 && snapshot.askLevels > 0)
+                    consistent = snapshot.bids[0].price < snapshot.asks[0].price;
+
+                const auto topOfBook = orderBook.getTopOfBookUpdates().tryConsume(cursor);
+                if(topOfBook && topOfBook->hasBid() && topOfBook->hasAsk())
+                    consistent = consistent && topOfBook->bidPrice < topOfBook->askPrice;
+
+                if(!consistent)
+                    badSnapshots.fetch_add(1);
+            }
+        });
+    }
+
+    std::unordered_set<int> restingIds;
+    for(int i = 0; i < 50'000; ++i) {
+        const int offset = (i * 7919) % 20;
+        if(i % 3 == 0 && !restingIds.empty()) {
+            CHECK(orderBook.cancelOrder(*restingIds.begin()));
+            restingIds.erase(restingIds.begin());
+            continue;
+        }
+
+        // Mostly passive orders around 100, with the odd aggressive one sweeping a few levels
+        const int shares = 1 + offset;
+        auto execution = ((i % 2 == 0) ? orderBook.addOrder(buy, shares, 90 + offset / 2 + (i % 11 == 0 ? 15 : 0))
+                                       : orderBook.addOrder(sell, shares, 101 + offset / 2 - (i % 13 == 0 ? 15 : 0))).value();
+
+        for(const int filledId : execution.getFulfilledOrderIds())
+            restingIds.erase(filledId);
+        if(execution.getTotalSharesExecuted() < shares)
+            restingIds.insert(execution.getBaseId());
+    }
+    done.store(true, std::memory_order_release);
+
+    for(auto& reader : readers)
+        reader.join();
+
+    CHECK_EQ(badSnapshots.load(), 0);
+    CHECK(orderBook.getPublishedSnapshot() == orderBook.getSnapshot());
+}
+
+TEST_SUITE_END();
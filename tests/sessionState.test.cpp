@@ -0,0 +1,108 @@
+/**
+ * @file sessionState.test.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Unit tests for trading session states, and queueing while halted
+ * @version 1.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "orderBook.hpp"
+#include "sessionState.hpp"
+#include "doctest.h"
+#include <cstdint>
+#include <vector>
+
+using namespace Exchange;
+using enum OrderType;
+
+TEST_SUITE_BEGIN("sessionState");
+
+TEST_CASE("Books move through the day's session states") {
+    OrderBook orderBook;
+    CHECK_EQ(orderBook.getSessionState(), SessionState::continuous);
+
+    // Continuous trading can't go back to preOpen without closing first
+    CHECK_EQ(orderBook.setSessionState(SessionState::preOpen).error(), RejectReason::invalidTransition);
+    CHECK(orderBook.setSessionState(SessionState::closed));
+    CHECK_EQ(orderBook.setSessionState(SessionState::continuous).error(), RejectReason::invalidTransition);
+
+    // Closed books only take cancels
+    CHECK_EQ(orderBook.addOrder(buy, 10, 100).error(), RejectReason::sessionClosed);
+
+    // Orders entered before the open rest, however far they cross, and opening needs an uncross
+    CHECK(orderBook.setSessionState(SessionState::preOpen));
+    orderBook.addOrder(buy, 10, 101);
+    orderBook.addOrder(sell, 10, 99);
+    CHECK_EQ(orderBook.getTotalVolume(), 0);
+    CHECK_EQ(orderBook.setSessionState(SessionState::continuous).error(), RejectReason::bookCrossed);
+    CHECK(orderBook.uncrossAuction(100).value().uncross);
+    CHECK_EQ(orderBook.getSessionState(), SessionState::continuous);
+    CHECK_EQ(orderBook.getTotalVolume(), 10);
+
+    // Only auction states uncross, and spend no order ID on refusing
+    const int nextId = orderBook.addOrder(buy, 1, 90).value().getBaseId() + 1;
+    CHECK_EQ(orderBook.uncrossAuction(100).error(), RejectReason::invalidTransition);
+    CHECK_EQ(orderBook.getSessionState(), SessionState::continuous);
+    CHECK_EQ(orderBook.addOrder(buy, 1, 90).value().getBaseId(), nextId);
+}
+
+TEST_CASE("Halted books queue orders and cancels, and replay them on resuming") {
+    OrderBook orderBook;
+    const int restingSell = orderBook.addOrder(sell, 10, 100).value().getBaseId();
+    const OrderHandle otherSell = orderBook.addOrder(sell, 10, 101).value().getRestingHandle().value();
+
+    CHECK(orderBook.setSessionState(SessionState::halted));
+
+    // Queued orders get their IDs straight away, but nothing trades
+    const auto queuedBuy = orderBook.addOrder(buy, 15, 101).value();
+    CHECK_EQ(queuedBuy.getTotalSharesExecuted(), 0);
+    CHECK(orderBook.cancelOrder(otherSell));
+    CHECK(orderBook.cancelOrder(12'345));
+    CHECK_EQ(orderBook.getTotalVolume(), 0);
+    CHECK_EQ(orderBook.getBestAsk(), 100);
+
+    CHECK(orderBook.setSessionState(SessionState::continuous));
+    const auto replayed = orderBook.getReplayedExecutions();
+    REQUIRE_EQ(replayed.size(), 1);
+    CHECK_EQ(replayed[0].getBaseId(), queuedBuy.getBaseId());
+    CHECK_EQ(replayed[0].getFulfilledOrderIds(), std::vector<int>{restingSell});
+
+    // Replayed in arrival order, so the buy traded with the 101 sell before its cancel took the rest
+    CHECK_EQ(replayed[0].getTotalSharesExecuted(), 15);
+    CHECK_EQ(orderBook.getTotalVolume(), 15);
+    CHECK_FALSE(orderBook.getBestAsk());
+    CHECK_FALSE(orderBook.getBestBid());
+}
+
+TEST_CASE("Halted books reject orders past the queue's capacity") {
+    OrderBook orderBook;
+    CHECK(orderBook.setSessionState(SessionState::halted));
+    for(std::size_t i = 0; i < haltQueueCapacity; ++i)
+        REQUIRE(orderBook.addOrder(buy, 1, 100));
+    CHECK_EQ(orderBook.addOrder(buy, 1, 100).error(), RejectReason::haltQueueFull);
+    CHECK_EQ(orderBook.cancelOrder(0).error(), RejectReason::haltQueueFull);
+
+    // Resuming into an auction rests them all, closing instead would have dropped them
+    CHECK(orderBook.setSessionState(SessionState::auction));
+    CHECK_EQ(orderBook.getReplayedExecutions().size(), haltQueueCapacity);
+    CHECK_EQ(orderBook.getTopOfBook().bidShares, Qty{static_cast<std::int64_t>(haltQueueCapacity)});
+}
+
+TEST_CASE("Session transitions apply across many books at once") {
+    std::vector<OrderBook> books(100);
+    books[7].addOrder(buy, 10, 100);
+
+    CHECK_EQ(setSessionState(books, SessionState::closed), 100);
+    CHECK_EQ(setSessionState(books, SessionState::preOpen), 100);
+
+    // One book is left crossed, so it can't open without an uncross
+    books[7].addOrder(sell, 10, 100);
+    CHECK_EQ(setSessionState(books, SessionState::continuous), 99);
+    CHECK_EQ(books[7].getSessionState(), SessionState::preOpen);
+    CHECK_EQ(books[8].getSessionState(), SessionState::continuous);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,130 @@
+/**
+ * @file topOfBook.test.cpp
+ * @author Stefan Mada (me@stefanmada.com)
+ * @brief Unit tests for top of book publishing
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "orderBook.hpp"
+#include "topOfBook.hpp"
+#include "doctest.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace Exchange;
+using enum OrderType;
+
+TEST_SUITE_BEGIN("topOfBook");
+
+TEST_CASE("Empty book has no top of book") {
+    OrderBook orderBook;
+
+    const auto topOfBook = orderBook.getTopOfBook();
+    CHECK(!topOfBook.hasBid());
+    CHECK(!topOfBook.hasAsk());
+    CHECK_EQ(orderBook.getTopOfBookUpdates().getSequence(), 0);
+}
+
+TEST_CASE("Top of book tracks price and size") {
+    OrderBook orderBook;
+    orderBook.addOrder(buy, 5, 10);
+    orderBook.addOrder(buy, 7, 10);
+    orderBook.addOrder(buy, 3, 9);
+    orderBook.addOrder(sell, 4, 12);
+
+    auto topOfBook = orderBook.getTopOfBook();
+    CHECK_EQ(topOfBook.bidPrice, 10);
+    CHECK_EQ(topOfBook.bidShares, 12);
+    CHECK_EQ(topOfBook.askPrice, 12);
+    CHECK_EQ(topOfBook.askShares, 4);
+
+    // Partially fill the best bid, size should shrink but price stay
+    orderBook.addOrder(sell, 6, 10);
+    topOfBook = orderBook.getTopOfBook();
+    CHECK_EQ(topOfBook.bidPrice, 10);
+    CHECK_EQ(topOfBook.bidShares, 6);
+
+    CHECK(orderBook.getTopOfBookUpdates().read() == topOfBook);
+}
+
+TEST_CASE("Top of book only published on change") {
+    OrderBook orderBook;
+    const auto& updates = orderBook.getTopOfBookUpdates();
+
+    orderBook.addOrder(buy, 5, 10);
+    CHECK_EQ(updates.getSequence(), 1);
+
+    // Behind the best bid, so top of book doesn't change
+    auto deeperOrder = orderBook.addOrder(buy, 5, 8).value();
+    CHECK_EQ(updates.getSequence(), 1);
+    orderBook.cancelOrder(deeperOrder.getBaseId());
+    CHECK_EQ(updates.getSequence(), 1);
+
+    // Joining the best bid changes size
+    orderBook.addOrder(buy, 5, 10);
+    CHECK_EQ(updates.getSequence(), 2);
+    CHECK_EQ(updates.read().bidShares, 10);
+
+    // Fully trading out the bid removes it
+    orderBook.addOrder(sell, 10, 10);
+    CHECK_EQ(updates.getSequence(), 3);
+    CHECK(!updates.read().hasBid());
+}
+
+TEST_CASE("Slow reader only sees latest top of book") {
+    OrderBook orderBook;
+    const auto& updates = orderBook.getTopOfBookUpdates();
+    std::uint64_t cursor = 0;
+
+    orderBook.addOrder(sell, 5, 20);
+    orderBook.addOrder(sell, 5, 19);
+    orderBook.addOrder(sell, 5, 18);
+
+    auto latest = updates.tryConsume(cursor);
+    REQUIRE(latest.has_value());
+    CHECK_EQ(latest->askPrice, 18);
+    CHECK_EQ(cursor, 3);
+
+    // Nothing new since the last read
+    CHECK(!updates.tryConsume(cursor).has_value());
+
+    orderBook.addOrder(buy, 5, 18);
+    latest = updates.tryConsume(cursor);
+    REQUIRE(latest.has_value());
+    CHECK_EQ(latest->askPrice, 19);
+}
+
+TEST_CASE("Published depth follows the book though changes behind it aren't republished") {
+    std::mt19937 generator{26};
+    OrderBook orderBook;
+    std::vector<int> orderIds;
+
+    for(int i = 0; i < 5'000; ++i) {
+        const auto action = generator() % 10;
+        if(action < 6) {
+            // Spread well past snapshotDepth on both sides, some hidden
+            const OrderType side = generator() % 2 == 0 ? buy : sell;
+            const Price price = side == buy ? 90 + static_cast<int>(generator() % 15) : 96 + static_cast<int>(generator() % 15);
+            const auto flags = generator() % 4 == 0 ? OrderFlags::hidden : std::uint8_t{0};
+            const auto execution = orderBook.addOrder(OrderRequest{.orderType = side, .flags = flags,
+                                                                   .shares = 1 + static_cast<int>(generator() % 20),
+                                                                   .limitPrice = price}).value();
+            orderIds.push_back(execution.getBaseId());
+        } else if(action < 9 && !orderIds.empty()) {
+            orderBook.cancelOrder(orderIds[generator() % orderIds.size()]);
+        } else {
+            orderBook.addOrder(generator() % 2 == 0 ? buy : sell, 1 + static_cast<int>(generator() % 60),
+                               generator() % 2 == 0 ? 200 : 1);
+        }
+
+        REQUIRE_EQ(orderBook.getPublishedSnapshot(), orderBook.getSnapshot());
+        REQUIRE_EQ(orderBook.getTopOfBookUpdates().read(), orderBook.getTopOfBook());
+    }
+}
+
+TEST_SUITE_END();